@@ -2,58 +2,35 @@
 import sys
 import subprocess
 import os
+import json
 
-if __name__ == "__main__":
-  n_arg = len(sys.argv)  
-  argv = sys.argv
-  argv[0] = './src/autosa'
-  output_dir = './autosa.tmp/output'
-  target = 'autosa_hls_c'
-  src_file_prefix = 'kernel'
-  xilinx_host = 'opencl'
+def generate_final_code(output_dir, src_file, src_file_prefix, target, 
+                        xilinx_host):
+  """ Generate the final code in the output directory
 
-  for arg in argv:
-    if 'output-dir' in arg:
-      output_dir = arg.split('=')[-1]
-    if 'target' in arg:
-      target = arg.split('=')[-1]
-  if n_arg > 1:
-    src_file = argv[1]
-    src_file_prefix = os.path.basename(src_file).split('.')[0]
-  if n_arg > 1 and target == 'autosa_hls_c':
-    # Check whether to generate HLS or OpenCL host for Xilinx FPGAs
-    for arg in argv:
-      if 'AutoSA-hls' in arg:
-        xilinx_host = 'hls'        
-
-  # Check if the output directory exists
-  if not os.path.isdir("./autosa.tmp"):
-    os.mkdir("./autosa.tmp")
-  if not os.path.isdir(output_dir):
-    os.mkdir(output_dir)    
-    os.mkdir(output_dir + '/src')
-    os.mkdir(output_dir + '/latency_est')
-    os.mkdir(output_dir + '/resource_est')
-
-  # Execute the AutoSA
-  process = subprocess.run(argv)
-  if process.returncode != 0:
-    sys.exit()
+  The top module is generated and the kernel code is post-processed 
+  before the temporary files are cleaned up.
+  """
   if not os.path.exists(output_dir + '/src/completed'):
-    sys.exit()  
+    return
 
   # Generate the top module
-  if not os.path.exists(output_dir + '/src/' + src_file_prefix + '_top_gen.cpp'):
-    sys.exit()
-  cmd = 'g++ -o '   + output_dir + '/src/top_gen ' + output_dir + \
-        '/src/' + src_file_prefix + '_top_gen.cpp ' + \
-        '-I./src/isl/include -L./src/isl/.libs -lisl'
-  process = subprocess.run(cmd.split())
-  my_env = os.environ.copy()
-  cwd = os.getcwd()
-  my_env['LD_LIBRARY_PATH'] += os.pathsep +  cwd + '/src/isl/.libs' 
-  cmd = output_dir + '/src/top_gen'
-  process = subprocess.run(cmd.split(), env=my_env)
+  top_gen_file = output_dir + '/src/' + src_file_prefix + '_top_gen.cpp'
+  if not os.path.exists(top_gen_file):
+    return
+  with open(top_gen_file, 'r') as f:
+    # The generator is empty if AutoSA generated the top module directly
+    has_top_gen = 'top_generate' in f.read()
+  if has_top_gen:
+    cmd = 'g++ -o '   + output_dir + '/src/top_gen ' + top_gen_file + \
+          ' -I./src/isl/include -L./src/isl/.libs -lisl'
+    process = subprocess.run(cmd.split())
+    my_env = os.environ.copy()
+    cwd = os.getcwd()
+    my_env['LD_LIBRARY_PATH'] = my_env.get('LD_LIBRARY_PATH', '') + \
+                                os.pathsep +  cwd + '/src/isl/.libs' 
+    cmd = output_dir + '/src/top_gen'
+    process = subprocess.run(cmd.split(), env=my_env)
 
   # Generate the final code
   cmd = './autosa_scripts/codegen.py -c ' + output_dir + \
@@ -66,8 +43,9 @@ if __name__ == "__main__":
   process = subprocess.run(cmd.split())  
 
   # Clean up the temp files
-  cmd = 'rm ' + output_dir + '/src/top_gen'
-  process = subprocess.run(cmd.split())
+  if has_top_gen:
+    cmd = 'rm ' + output_dir + '/src/top_gen'
+    process = subprocess.run(cmd.split())
   cmd = 'rm ' + output_dir + '/src/top.cpp'
   process = subprocess.run(cmd.split())
   cmd = 'rm ' + output_dir + '/src/' + src_file_prefix + '_top_gen.cpp'
@@ -76,7 +54,7 @@ if __name__ == "__main__":
   process = subprocess.run(cmd.split())
   cmd = 'rm ' + output_dir + '/src/' + src_file_prefix + '_kernel_modules.cpp'
   process = subprocess.run(cmd.split())
-  cmd = 'cp ' + argv[1] + ' ' + output_dir + '/src/'
+  cmd = 'cp ' + src_file + ' ' + output_dir + '/src/'
   process = subprocess.run(cmd.split())
   headers = src_file.split('.')
   headers[-1] = 'h'
@@ -90,3 +68,57 @@ if __name__ == "__main__":
   if target == 'autosa_hls_c' and xilinx_host == 'opencl':
     cmd = 'rm ' + output_dir + '/src/' + src_file_prefix + '_kernel.h'
     process = subprocess.run(cmd.split())
+
+if __name__ == "__main__":
+  n_arg = len(sys.argv)  
+  argv = sys.argv
+  argv[0] = './src/autosa'
+  output_dir = './autosa.tmp/output'
+  target = 'autosa_hls_c'
+  src_file_prefix = 'kernel'
+  xilinx_host = 'opencl'
+  sweep = False
+
+  for arg in argv:
+    if 'output-dir' in arg:
+      output_dir = arg.split('=')[-1]
+    if 'target' in arg:
+      target = arg.split('=')[-1]
+    if 'sa-sizes-sweep' in arg:
+      sweep = True
+  if n_arg > 1:
+    src_file = argv[1]
+    src_file_prefix = os.path.basename(src_file).split('.')[0]
+  if n_arg > 1 and target == 'autosa_hls_c':
+    # Check whether to generate HLS or OpenCL host for Xilinx FPGAs
+    for arg in argv:
+      if 'AutoSA-hls' in arg:
+        xilinx_host = 'hls'        
+
+  # Check if the output directory exists
+  if not os.path.isdir("./autosa.tmp"):
+    os.mkdir("./autosa.tmp")
+  if not os.path.isdir(output_dir):
+    os.mkdir(output_dir)    
+    os.mkdir(output_dir + '/src')
+    os.mkdir(output_dir + '/latency_est')
+    os.mkdir(output_dir + '/resource_est')
+
+  # Execute the AutoSA
+  process = subprocess.run(argv)
+  if process.returncode != 0:
+    sys.exit()
+
+  if sweep:
+    # Generate the final code for each design point of the sweep
+    if not os.path.exists(output_dir + '/sweep.json'):
+      sys.exit()
+    with open(output_dir + '/sweep.json', 'r') as f:
+      points = json.load(f)['points']
+    for point in points:
+      if point['status'] == 0:
+        generate_final_code(point['output_dir'], src_file, src_file_prefix, 
+                            target, xilinx_host)
+  else:
+    generate_final_code(output_dir, src_file, src_file_prefix, target, 
+                        xilinx_host)
@@ -0,0 +1,259 @@
+#!/usr/bin/env python3.6
+import sys
+import subprocess
+import os
+import json
+import csv
+import shutil
+
+RESOURCES = ['BRAM', 'DSP', 'FF', 'LUT', 'URAM']
+STAGES = ['space_time', 'array_part', 'array_part_L2', 'latency', 'simd']
+
+def divisors(n):
+  """ Return the divisors of n in increasing order
+  """
+  n = max(int(n), 1)
+  return [d for d in range(1, n + 1) if n % d == 0]
+
+def print_sa_sizes(kernel_id, sizes):
+  """ Print the tile sizes as a --sa-sizes string
+
+  "sizes" maps the stages to their tile sizes.
+  """
+  items = []
+  for stage in STAGES:
+    if stage not in sizes:
+      continue
+    value = sizes[stage]
+    if not isinstance(value, list):
+      value = [value]
+    items.append('kernel[' + str(kernel_id) + ']->' + stage + '[' + \
+                 ','.join(str(v) for v in value) + ']')
+  return '{' + ';'.join(items) + '}'
+
+def prune(candidates, max_points):
+  """ Keep at most max_points candidates, evenly spaced over the list
+
+  The candidates are listed in increasing order of their tile sizes, so
+  the kept candidates span the whole range of the stage. The pruning is
+  deterministic, i.e., the same candidates are kept in every run.
+  """
+  n = len(candidates)
+  if max_points > 0 and n > max_points:
+    return [candidates[i * n // max_points] for i in range(max_points)]
+  return candidates
+
+def expand_point(point, tuning, max_points):
+  """ Expand the design point with the candidates of its next tuning stage
+
+  The candidates are taken from the "tuning.json" dumped by AutoSA:
+  - space_time: every systolic array
+  - array_part, array_part_L2: divisors of the loop bounds, at least two
+    for the array partitioning so that no array dimension is degenerate
+  - latency: divisors of the loop bounds
+  - simd: a power-of-two divisor of the bound of one legal loop,
+    or no SIMD vectorization
+  """
+  stage = list(tuning.keys())[0]
+  info = tuning[stage]
+  candidates = []
+  if stage == 'space_time':
+    candidates = list(range(int(info['n_kernel'])))
+  elif stage in ('array_part', 'array_part_L2', 'latency'):
+    choices = []
+    for ub in info['tilable_loops']:
+      ds = divisors(ub)
+      if stage == 'array_part' and ub >= 2:
+        ds = [d for d in ds if d >= 2]
+      choices.append(ds)
+    candidates = [[]]
+    for ds in choices:
+      candidates = [c + [d] for c in candidates for d in ds]
+  elif stage == 'simd':
+    n_loop = len(info['tilable_loops'])
+    candidates = [[-1] * n_loop]
+    for i in range(n_loop):
+      if not info['legal'][i]:
+        continue
+      for d in divisors(info['tilable_loops'][i]):
+        if d > 1 and d <= 64 and d & (d - 1) == 0:
+          c = [-1] * n_loop
+          c[i] = d
+          candidates.append(c)
+  candidates = prune(candidates, max_points)
+
+  points = []
+  for c in candidates:
+    sizes = dict(point)
+    sizes[stage] = c
+    points.append(sizes)
+  return points
+
+def make_output_dir(output_dir):
+  """ Create an empty output directory for AutoSA
+  """
+  if os.path.isdir(output_dir):
+    shutil.rmtree(output_dir)
+  os.makedirs(output_dir + '/src')
+  os.mkdir(output_dir + '/latency_est')
+  os.mkdir(output_dir + '/resource_est')
+
+def run_sweep(argv, config, output_dir, points, n_jobs):
+  """ Compile the design points in parallel with the AutoSA sweep mode
+
+  Return the sweep status of each design point.
+  """
+  make_output_dir(output_dir)
+  sweep_file = output_dir + '/sweep.txt'
+  with open(sweep_file, 'w') as f:
+    for p in points:
+      f.write(print_sa_sizes(0, p) + '\n')
+  cmd = argv + ['--AutoSA-config=' + config,
+                '--AutoSA-output-dir=' + output_dir,
+                '--AutoSA-sa-sizes-sweep=' + sweep_file,
+                '--AutoSA-sweep-jobs=' + str(n_jobs)]
+  process = subprocess.run(cmd, stdin=subprocess.DEVNULL,
+                           stdout=subprocess.DEVNULL)
+  if process.returncode != 0 or \
+     not os.path.exists(output_dir + '/sweep.json'):
+    print('[AutoSA] Error: The sweep failed in ' + output_dir)
+    sys.exit(1)
+  with open(output_dir + '/sweep.json', 'r') as f:
+    return json.load(f)['points']
+
+def load_json(path):
+  if not os.path.exists(path):
+    return None
+  with open(path, 'r') as f:
+    return json.load(f)
+
+def evaluate_point(status, resource_key):
+  """ Collect the estimated latency and resource usage of a design point
+  """
+  latency = load_json(status['output_dir'] + '/latency_est/latency.json')
+  resource = load_json(status['output_dir'] + '/resource_est/resource.json')
+  if latency is None or resource is None:
+    return None
+  point = {'sa_sizes': status['sa_sizes'],
+           'output_dir': status['output_dir'],
+           'latency': latency['latency'],
+           'throughput': 1.0 / max(latency['latency'], 1)}
+  for r in RESOURCES:
+    point[r] = resource['total'].get(r, 0)
+  util = resource.get('utilization', {})
+  if resource_key == 'max':
+    point['resource'] = max(util.values()) if util else 0
+  else:
+    point['resource'] = util.get(resource_key, 0)
+  return point
+
+def pareto_front(points):
+  """ Return the points with no other point of both lower latency
+  and lower resource usage, ordered by increasing resource usage
+  """
+  front = []
+  for p in sorted(points, key=lambda p: (p['resource'], p['latency'])):
+    if not front or p['latency'] < front[-1]['latency']:
+      front.append(p)
+  return front
+
+def dump_results(output_dir, points, front):
+  with open(output_dir + '/dse.json', 'w') as f:
+    json.dump({'points': points, 'pareto': front}, f, indent=2)
+  fields = ['sa_sizes', 'latency', 'throughput', 'resource'] + RESOURCES + \
+           ['output_dir']
+  with open(output_dir + '/pareto.csv', 'w') as f:
+    writer = csv.DictWriter(f, fieldnames=fields)
+    writer.writeheader()
+    for p in front:
+      writer.writerow(p)
+
+if __name__ == "__main__":
+  argv = ['./src/autosa']
+  output_dir = './autosa.tmp/dse'
+  config_file = './autosa_config/autosa_config.json'
+  hw_info = None
+  n_jobs = os.cpu_count() or 1
+  max_points = 64
+  resource_key = 'max'
+
+  for arg in sys.argv[1:]:
+    if arg.startswith('--dse-jobs='):
+      n_jobs = int(arg.split('=')[-1])
+    elif arg.startswith('--dse-max-points='):
+      max_points = int(arg.split('=')[-1])
+    elif arg.startswith('--dse-resource='):
+      resource_key = arg.split('=')[-1]
+    elif 'output-dir' in arg:
+      output_dir = arg.split('=')[-1]
+    elif 'AutoSA-config' in arg:
+      config_file = arg.split('=')[-1]
+    elif 'hw-info' in arg:
+      hw_info = arg.split('=')[-1]
+    elif 'sa-sizes' in arg:
+      continue
+    else:
+      argv.append(arg)
+  if len(argv) < 2:
+    print('Usage: ' + sys.argv[0] + ' <input.c> [AutoSA options] ' + \
+          '[--dse-jobs=<num>] [--dse-max-points=<num>] ' + \
+          '[--dse-resource=max|BRAM|DSP|FF|LUT|URAM]')
+    sys.exit(1)
+  if hw_info is None:
+    hw_info = './autosa_config/hw_info.json'
+  argv += ['--AutoSA-estimate', '--AutoSA-hw-info=' + hw_info]
+
+  # Run all the enabled tuning stages in the manual mode
+  if not os.path.isdir(output_dir):
+    os.makedirs(output_dir)
+  with open(config_file, 'r') as f:
+    config = json.load(f)
+  for stage in config:
+    config[stage]['mode'] = 'manual'
+  dse_config = output_dir + '/autosa_config.json'
+  with open(dse_config, 'w') as f:
+    json.dump(config, f, indent=4)
+
+  # Find the number of systolic arrays
+  stage_dir = output_dir + '/stage_0'
+  make_output_dir(stage_dir)
+  cmd = argv + ['--AutoSA-config=' + dse_config,
+                '--AutoSA-output-dir=' + stage_dir]
+  process = subprocess.run(cmd, stdin=subprocess.DEVNULL,
+                           stdout=subprocess.DEVNULL)
+  tuning = load_json(stage_dir + '/tuning.json')
+  if process.returncode != 0 or tuning is None:
+    print('[AutoSA] Error: Failed to find the systolic arrays.')
+    sys.exit(1)
+  pending = expand_point({}, tuning, 0)
+
+  # Expand the design points stage by stage until they are complete
+  results = []
+  n_stage = 1
+  while pending:
+    print('[AutoSA] DSE stage ' + str(n_stage) + ': ' + str(len(pending)) + \
+          ' design points')
+    stage_dir = output_dir + '/stage_' + str(n_stage)
+    status = run_sweep(argv, dse_config, stage_dir, pending, n_jobs)
+    next_pending = []
+    for sizes, s in zip(pending, status):
+      if s['status'] != 0:
+        continue
+      tuning = load_json(s['output_dir'] + '/tuning.json')
+      if tuning is not None:
+        next_pending += expand_point(sizes, tuning, max_points)
+        continue
+      point = evaluate_point(s, resource_key)
+      if point is not None:
+        results.append(point)
+    pending = prune(next_pending, max_points)
+    n_stage += 1
+
+  front = pareto_front(results)
+  dump_results(output_dir, results, front)
+  print('[AutoSA] DSE completed: ' + str(len(results)) + \
+        ' design points, ' + str(len(front)) + ' on the Pareto front.')
+  for p in front:
+    print('[AutoSA] latency ' + str(p['latency']) + ', resource ' + \
+          '{:.3f}'.format(p['resource']) + ': --sa-sizes="' + \
+          p['sa_sizes'] + '"')
@@ -0,0 +1,460 @@
+#!/usr/bin/env python3.6
+import sys
+import subprocess
+import os
+import json
+import random
+import shlex
+import threading
+import queue
+import re
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from autosa_dse import STAGES, divisors, print_sa_sizes, load_json
+
+INF = float('inf')
+
+class CompileServer:
+  """ An AutoSA process running in the compile server mode
+
+  The program is analyzed once when the server starts. Each request
+  compiles one design point in a child process of the server.
+  """
+  def __init__(self, argv, log_file):
+    self.log = open(log_file, 'w')
+    self.process = subprocess.Popen(argv + ['--AutoSA-serve'],
+                                    stdin=subprocess.PIPE,
+                                    stdout=subprocess.PIPE,
+                                    stderr=self.log,
+                                    universal_newlines=True, bufsize=1)
+
+  def request(self, sa_sizes, output_dir):
+    req = {'output_dir': output_dir}
+    if sa_sizes is not None:
+      req['sa_sizes'] = sa_sizes
+    self.process.stdin.write(json.dumps(req) + '\n')
+    self.process.stdin.flush()
+    # Skip the messages printed before the server is ready
+    while True:
+      line = self.process.stdout.readline()
+      if not line:
+        return {'status': -1}
+      try:
+        response = json.loads(line)
+      except ValueError:
+        continue
+      if isinstance(response, dict) and 'id' in response:
+        return response
+
+  def close(self):
+    self.process.stdin.close()
+    self.process.wait()
+    self.log.close()
+
+class ServerPool:
+  """ A pool of compile servers shared by the tuner threads
+  """
+  def __init__(self, argv, n_workers, log_dir):
+    self.servers = queue.Queue()
+    self.all = []
+    for i in range(n_workers):
+      server = CompileServer(argv, log_dir + '/server_' + str(i) + '.log')
+      self.all.append(server)
+      self.servers.put(server)
+
+  def request(self, sa_sizes, output_dir):
+    server = self.servers.get()
+    try:
+      return server.request(sa_sizes, output_dir)
+    finally:
+      self.servers.put(server)
+
+  def close(self):
+    for server in self.all:
+      server.close()
+
+def loop_choices(stage, info):
+  """ Return the candidate tile sizes of each loop of a tuning stage
+  """
+  choices = []
+  for ub in info['tilable_loops']:
+    ds = divisors(ub)
+    if stage == 'array_part' and ub >= 2:
+      ds = [d for d in ds if d >= 2]
+    choices.append(ds)
+  return choices
+
+def simd_choices(info):
+  """ Return the candidate SIMD factors of each loop, -1 disables the loop
+  """
+  choices = []
+  for i, ub in enumerate(info['tilable_loops']):
+    ds = [-1]
+    if info['legal'][i]:
+      ds += [d for d in divisors(ub) if d > 1 and d <= 64 and d & (d - 1) == 0]
+    choices.append(ds)
+  return choices
+
+def is_valid(stage, info, sizes):
+  """ Check if the tile sizes are a candidate of the tuning stage
+  """
+  if stage == 'space_time':
+    return isinstance(sizes, int) and 0 <= sizes < int(info['n_kernel'])
+  if not isinstance(sizes, list) or len(sizes) != len(info['tilable_loops']):
+    return False
+  if stage == 'simd':
+    choices = simd_choices(info)
+    if len([s for s in sizes if s != -1]) > 1:
+      return False
+  else:
+    choices = loop_choices(stage, info)
+  return all(s in c for s, c in zip(sizes, choices))
+
+def random_sizes(stage, info, rng):
+  """ Draw random tile sizes for the tuning stage
+  """
+  if stage == 'space_time':
+    return rng.randrange(int(info['n_kernel']))
+  if stage == 'simd':
+    sizes = [-1] * len(info['tilable_loops'])
+    choices = simd_choices(info)
+    legal = [i for i in range(len(choices)) if len(choices[i]) > 1]
+    if legal:
+      i = rng.choice(legal)
+      sizes[i] = rng.choice(choices[i])
+    return sizes
+  return [rng.choice(c) for c in loop_choices(stage, info)]
+
+class Tuner:
+  """ A genetic algorithm over the --sa-sizes configurations
+
+  Each design point is a dict from the tuning stages to their tile sizes.
+  As the candidates of a stage depend on the previous stages, a design
+  point is completed stage by stage. The tuning.json of each prefix is
+  queried from the compile servers once and cached in the database.
+  The objective of the complete design points is minimized. Infeasible
+  design points, e.g., the ones that exceed the resource budget, have an
+  infinite objective.
+  """
+  def __init__(self, pool, output_dir, objective, rng, db_file=None,
+               measured=False):
+    self.pool = pool
+    self.db_file = db_file
+    self.measured = measured
+    self.output_dir = output_dir
+    self.objective = objective
+    self.rng = rng
+    self.lock = threading.Lock()
+    self.tuner_file = output_dir + '/tuner.json'
+    db = load_json(self.tuner_file)
+    if db is None:
+      db = {'tuning': {}, 'points': {}}
+    self.tuning = db['tuning']
+    self.points = db['points']
+    # Resume the numbering after the point directories of earlier runs.
+    # The tuning entries don't record their directories, so they are
+    # listed from the disk.
+    self.n_request = 0
+    points_dir = output_dir + '/points'
+    if os.path.isdir(points_dir):
+      for name in os.listdir(points_dir):
+        m = re.fullmatch(r'point_(\d+)', name)
+        if m:
+          self.n_request = max(self.n_request, int(m.group(1)) + 1)
+
+  def save(self):
+    with self.lock:
+      db = {'tuning': self.tuning, 'points': self.points, 'best': self.best()}
+      with open(self.tuner_file + '.tmp', 'w') as f:
+        json.dump(db, f, indent=2)
+      os.replace(self.tuner_file + '.tmp', self.tuner_file)
+
+  def query(self, sizes):
+    """ Return the tuning.json of the design point if it is incomplete,
+    or its database entry otherwise
+    """
+    key = print_sa_sizes(0, sizes)
+    with self.lock:
+      if key in self.tuning:
+        return self.tuning[key], None
+      if key in self.points:
+        return None, self.points[key]
+      output_dir = self.output_dir + '/points/point_' + str(self.n_request)
+      self.n_request += 1
+    response = self.pool.request(key if sizes else None, output_dir)
+    tuning = response.get('tuning')
+    if response['status'] == 0 and tuning is not None:
+      with self.lock:
+        self.tuning[key] = tuning
+      return tuning, None
+    value = None
+    if response['status'] == 0:
+      value = self.objective(output_dir)
+      if self.measured and self.db_file is not None and value != INF:
+        with self.lock:
+          record_measured(self.db_file, output_dir, value)
+    entry = {'sizes': sizes, 'output_dir': output_dir,
+             'status': response['status'],
+             'objective': value if value != INF else None}
+    with self.lock:
+      self.points[key] = entry
+    return None, entry
+
+  def complete(self, wanted):
+    """ Complete the design point "wanted" stage by stage
+
+    The tile sizes of "wanted" are kept where they are still candidates,
+    the other stages are drawn at random.
+    """
+    sizes = {}
+    while True:
+      tuning, entry = self.query(sizes)
+      if entry is not None:
+        return entry
+      stage = list(tuning.keys())[0]
+      info = tuning[stage]
+      if stage in sizes:
+        # The stage is repeated, give up the design point
+        return {'sizes': sizes, 'status': -1, 'objective': None}
+      if stage in wanted and is_valid(stage, info, wanted[stage]):
+        sizes[stage] = wanted[stage]
+      else:
+        with self.lock:
+          sizes[stage] = random_sizes(stage, info, self.rng)
+
+  def best(self):
+    feasible = [p for p in self.points.values() if p['objective'] is not None]
+    if not feasible:
+      return None
+    return min(feasible, key=lambda p: p['objective'])
+
+  def tournament(self, population):
+    a, b = self.rng.sample(population, 2) if len(population) > 1 \
+           else (population[0], population[0])
+    return a if score(a) <= score(b) else b
+
+  def offspring(self, population):
+    a = self.tournament(population)['sizes']
+    b = self.tournament(population)['sizes']
+    stages = [s for s in STAGES if s in a]
+    # One-point crossover along the tuning stages
+    k = self.rng.randrange(len(stages) + 1)
+    child = {}
+    for i, s in enumerate(stages):
+      if i < k:
+        child[s] = a[s]
+      elif s in b:
+        child[s] = b[s]
+    # Mutation: redraw one stage
+    if stages and self.rng.random() < 0.8:
+      child.pop(self.rng.choice(stages), None)
+    return child
+
+def read_tuning_db(db_file):
+  """ Read the records of the tuning database written by --AutoSA-tuning-db
+  """
+  entries = []
+  if db_file is None or not os.path.exists(db_file):
+    return entries
+  with open(db_file, 'r') as f:
+    for line in f:
+      try:
+        entries.append(json.loads(line))
+      except ValueError:
+        continue
+  return entries
+
+def parse_sa_sizes(sa_sizes):
+  """ Parse a --sa-sizes string into a dict from the stages to the sizes
+  """
+  sizes = {}
+  for stage, values in re.findall(r'kernel\[\d+\]->(\w+)\[([-\d,]*)\]',
+                                  sa_sizes):
+    values = [int(v) for v in values.split(',') if v]
+    sizes[stage] = values[0] if stage == 'space_time' else values
+  return sizes
+
+def warm_start(tuner, db_file, n):
+  """ Return at most n design points from the tuning database to seed
+  the search
+
+  The keys of the program and the hardware are taken from the record of
+  a design point compiled by the tuner. The best records of the same
+  program are used first, then the ones of programs with the same shape.
+  Measured and estimated latencies are not comparable, so the measured
+  records are ranked before the estimated ones.
+  """
+  entries = read_tuning_db(db_file)
+  dirs = set(p.get('output_dir') for p in tuner.points.values())
+  keys = [e for e in entries if e.get('output_dir') in dirs]
+  if not keys:
+    return []
+  key = keys[-1]
+  seeds = []
+  for field in ('scop', 'shape'):
+    matched = [e for e in entries if e.get('hw') == key['hw'] and \
+               e.get(field) == key[field] and e.get('fit', True) and \
+               db_objective(e) is not None]
+    matched.sort(key=lambda e: (not is_measured(e), db_objective(e)))
+    for e in matched:
+      sizes = parse_sa_sizes(e['sa_sizes'])
+      if sizes not in seeds:
+        seeds.append(sizes)
+  return seeds[:n]
+
+def is_measured(entry):
+  return entry.get('source') == 'measured'
+
+def db_objective(entry):
+  """ The measured latency of a measured record, or the estimated latency
+  """
+  return entry.get('measured' if is_measured(entry) else 'latency')
+
+def record_measured(db_file, output_dir, value):
+  """ Append the objective measured by the user script to the tuning
+  database, as a copy of the record of the design point
+  """
+  entries = [e for e in read_tuning_db(db_file) \
+             if e.get('output_dir') == output_dir and not is_measured(e)]
+  if not entries:
+    return
+  entry = dict(entries[-1])
+  entry['source'] = 'measured'
+  entry['measured'] = value
+  with open(db_file, 'a') as f:
+    f.write(json.dumps(entry) + '\n')
+
+def score(entry):
+  return entry['objective'] if entry['objective'] is not None else INF
+
+def estimate_objective(output_dir):
+  """ The latency estimated by AutoSA
+  """
+  latency = load_json(output_dir + '/latency_est/latency.json')
+  if latency is None:
+    return INF
+  return latency['latency']
+
+def script_objective(cmd):
+  """ An objective computed by a user script
+
+  The script is called with the output directory of the design point and
+  prints the objective to minimize on the last line of its output.
+  """
+  def objective(output_dir):
+    process = subprocess.run(shlex.split(cmd) + [output_dir],
+                             stdout=subprocess.PIPE, universal_newlines=True)
+    lines = process.stdout.strip().split('\n')
+    if process.returncode != 0 or not lines[-1]:
+      return INF
+    try:
+      return float(lines[-1])
+    except ValueError:
+      return INF
+  return objective
+
+if __name__ == "__main__":
+  argv = ['./src/autosa']
+  output_dir = './autosa.tmp/tuner'
+  config_file = './autosa_config/autosa_config.json'
+  hw_info = './autosa_config/hw_info.json'
+  n_workers = os.cpu_count() or 1
+  population_size = 16
+  time_budget = 3600
+  objective = estimate_objective
+  measured = False
+  db_file = None
+  seed = 0
+
+  for arg in sys.argv[1:]:
+    if arg.startswith('--tuner-workers='):
+      n_workers = int(arg.split('=')[-1])
+    elif arg.startswith('--tuner-population='):
+      population_size = int(arg.split('=')[-1])
+    elif arg.startswith('--tuner-time='):
+      time_budget = float(arg.split('=')[-1])
+    elif arg.startswith('--tuner-objective='):
+      objective = script_objective(arg.split('=', 1)[-1])
+      measured = True
+    elif arg.startswith('--tuner-seed='):
+      seed = int(arg.split('=')[-1])
+    elif 'output-dir' in arg:
+      output_dir = arg.split('=')[-1]
+    elif 'AutoSA-config' in arg:
+      config_file = arg.split('=')[-1]
+    elif 'hw-info' in arg:
+      hw_info = arg.split('=')[-1]
+    elif 'sa-sizes' in arg:
+      continue
+    else:
+      if 'tuning-db' in arg:
+        db_file = arg.split('=')[-1]
+      argv.append(arg)
+  if len(argv) < 2:
+    print('Usage: ' + sys.argv[0] + ' <input.c> [AutoSA options] ' + \
+          '[--tuner-workers=<num>] [--tuner-population=<num>] ' + \
+          '[--tuner-time=<seconds>] [--tuner-objective=<script>] ' + \
+          '[--tuner-seed=<num>]')
+    sys.exit(1)
+
+  # Run all the enabled tuning stages in the manual mode
+  if not os.path.isdir(output_dir + '/points'):
+    os.makedirs(output_dir + '/points')
+  with open(config_file, 'r') as f:
+    config = json.load(f)
+  for stage in config:
+    config[stage]['mode'] = 'manual'
+  tuner_config = output_dir + '/autosa_config.json'
+  with open(tuner_config, 'w') as f:
+    json.dump(config, f, indent=4)
+  argv += ['--AutoSA-config=' + tuner_config,
+           '--AutoSA-output-dir=' + output_dir,
+           '--AutoSA-estimate', '--AutoSA-hw-info=' + hw_info]
+
+  start = time.time()
+  rng = random.Random(seed)
+  pool = ServerPool(argv, n_workers, output_dir)
+  tuner = Tuner(pool, output_dir, objective, rng, db_file, measured)
+  if tuner.points:
+    print('[AutoSA] Resume from ' + str(len(tuner.points)) + \
+          ' evaluated design points.')
+
+  # The initial population holds the best design points evaluated so far
+  population = sorted(tuner.points.values(), key=score)[:population_size]
+  population = [p for p in population if 'sizes' in p]
+  with ThreadPoolExecutor(max_workers=n_workers) as executor:
+    if db_file is not None and not population:
+      # Seed the search with the best designs in the tuning database
+      population.append(tuner.complete({}))
+      seeds = warm_start(tuner, db_file, population_size // 2)
+      if seeds:
+        print('[AutoSA] Warm start from ' + str(len(seeds)) + \
+              ' design points in the tuning database.')
+      population += list(executor.map(tuner.complete, seeds))
+    n = population_size - len(population)
+    population += list(executor.map(tuner.complete, [{}] * n))
+    tuner.save()
+    generation = 0
+    while time.time() - start < time_budget:
+      children = [tuner.offspring(population) for i in range(population_size)]
+      children = list(executor.map(tuner.complete, children))
+      merged = {}
+      for p in population + children:
+        merged[print_sa_sizes(0, p['sizes'])] = p
+      population = sorted(merged.values(), key=score)[:population_size]
+      tuner.save()
+      generation += 1
+      best = tuner.best()
+      print('[AutoSA] Generation ' + str(generation) + ': ' + \
+            str(len(tuner.points)) + ' design points, best objective ' + \
+            (str(best['objective']) if best else 'none'))
+  pool.close()
+
+  best = tuner.best()
+  if best is None:
+    print('[AutoSA] No feasible design point found.')
+    sys.exit(1)
+  print('[AutoSA] Best objective ' + str(best['objective']) + ': ' + \
+        '--sa-sizes="' + print_sa_sizes(0, best['sizes']) + '"')
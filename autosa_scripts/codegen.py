@@ -1,6 +1,5 @@
 #!/usr/bin/env python3.6
 
-import sympy
 import sys
 import argparse
 import re
@@ -132,223 +131,93 @@ def generate_intel_kernel(kernel, headers, module_defs, module_calls, fifo_decls
       print_module_def(f, arg_map, module_def, def_args, call_args_type)
       f.write('/* Module Definition */\n\n')
 
-def contains_pipeline_for(pos, lines):
-  """ Examine if there is any for loop with hls_pipeline annotation inside the current for loop
-
-  """
-  n_l_bracket = 0
-  n_r_bracket = 0
-  code_len = len(lines)
-  init_state = 1
-  while pos < code_len and n_r_bracket <= n_l_bracket:
-    if lines[pos].find('{') != -1:
-      n_l_bracket += 1
-    if lines[pos].find('}') != -1:
-      n_r_bracket += 1
-    if lines[pos].find('for') != -1:
-      if init_state:
-        init_state = 0
-      else:
-        if lines[pos + 1].find('hls_pipeline') != -1:
-          return 1
-    if n_l_bracket == n_r_bracket and not init_state:
-      break
-    pos += 1
-  return 0
-
-def insert_xlnx_pragmas(lines):
-  """ Insert HLS pragmas for Xilinx program
-
-  Replace the comments of "// hls_pipeline" and "// hls_unroll" with
-  HLS pragmas
-  For "// hls pipeline", find the previous for loop before hitting any "}".
-  Insert "#pragma HLS PIPELINE II=1" below the for loop.
-  For "// hls unroll", find the previous for loop before hitting the "simd" mark.
-  Insert "#pragma HLS UNROLL" below the for loop.
-  For "// hls_dependence.x", the position is the same with hls_pipeline.
-  Insert "#pragma HLS DEPENDENCE variable=x inter false".
+def shrink_bit_width(line):
+  """ Calculate the bitwidth of the iterator and shrink it to the proper size
 
   Args:
-    lines: contains the codelines of the program
+    line: a codeline of the program
   """
-  # Handle hls_dependence
-  handle_dep_pragma = 1
 
-  code_len = len(lines)
-  pos = 0
-  while pos < code_len:
-    line = lines[pos]
-    if line.find("// hls_pipeline") != -1 or line.find("// hls_dependence") != -1:
-      is_pipeline = 0
-      is_dep = 0
-      if line.find('// hls_pipeline') != -1:
-        is_pipeline = 1
-      else:
-        is_dep = 1
-      # Find if there is any other hls_pipeline/hls_dependence annotation below
-      n_l_bracket = 0
-      n_r_bracket = 0
-      next_pos = pos + 1
-      find_pipeline = 0
-      init_state = 1
-      while next_pos < code_len and n_r_bracket <= n_l_bracket:
-        if is_pipeline and lines[next_pos].find('hls_pipeline') != -1:
-          find_pipeline = 1
-          break
-        if is_dep and lines[next_pos].find('hls_dependence') != -1 and handle_dep_pragma:
-          find_pipeline = 1
-          break
-        if lines[next_pos].find('{') != -1:
-          n_l_bracket += 1
-          init_state = 0
-        if lines[next_pos].find('}') != -1:
-          n_r_bracket += 1
-        if n_l_bracket == n_r_bracket and not init_state:
-          break
-        next_pos += 1
-      if find_pipeline:
-        pos += 1
-        continue
-
-      # Find the for loop above before hitting any "}"
-      prev_pos = pos - 1
-      find_for = 0
-      n_l_bracket = 0
-      n_r_bracket = 0
-      while prev_pos >= 0:
-        if lines[prev_pos].find('{') != -1:
-          n_l_bracket += 1
-        if lines[prev_pos].find('}') != -1:
-          n_r_bracket += 1
-        if lines[prev_pos].find('for') != -1:
-          if n_l_bracket > n_r_bracket:
-            # check if the pragma is already inserted
-            if is_pipeline and lines[prev_pos + 1].find('#pragma HLS PIPELINE II=1\n') == -1:
-              find_for = 1
-            if is_dep and lines[prev_pos + 2].find('#pragma HLS DEPENDENCE') == -1 and handle_dep_pragma:
-              find_for = 1
-            # check if there is any other for loop with hls_pipeline annotation inside
-            if contains_pipeline_for(prev_pos, lines):
-              find_for = 0
-            break
-        prev_pos -= 1
-      if find_for == 1:
-        # insert the pragma right after the for loop
-        indent = lines[prev_pos].find('for')
-        if line.find("hls_pipeline") != -1:
-          new_line = ' ' * indent + "#pragma HLS PIPELINE II=1\n"
-        else:
-          line_cp = line
-          var_name = line_cp.strip().split('.')[-1]
-          new_line = ' ' * indent + "#pragma HLS DEPENDENCE variable=" + var_name + " inter false\n"
-        lines.insert(prev_pos + 1, new_line)
-        del lines[pos + 1]
-    elif line.find("// hls_unroll") != -1:
-      # Find the for loop above before hitting any "simd"
-      prev_pos = pos - 1
-      find_for = 0
-      while prev_pos >= 0 and lines[prev_pos].find('simd') == -1:
-        if lines[prev_pos].find('for') != -1:
-          find_for = 1
-          break
-        prev_pos -= 1
-      if find_for == 1:
-        # insert the pragma right after the for loop
-        indent = lines[prev_pos].find('for')
-        new_line = ' ' * indent + "#pragma HLS UNROLL\n"
-        lines.insert(prev_pos + 1, new_line)
-        del lines[pos + 1]
-    pos = pos + 1
-
-  return lines
-
-def index_simplify(matchobj):
-  str_expr = matchobj.group(0)
-  expr = sympy.sympify(str_expr[1 : len(str_expr) - 1])
-  """
-  This will sometimes cause bugs due to the different semantics in C
-  E.g., x = 9, (x+3)/4 != x/4+3/4.
-  We could use cxxcode, but it will generate floating expressions which are
-  expensive on FPGA.
-  At present, we check if there is floor or ceil in the expression.
-  If so, we abort and use the original expression. Otherwise, we replace it
-  with the simplified one.
-  """
-  expr = sympy.simplify(expr)
-  new_str_expr = sympy.printing.ccode(expr)
-  if 'floor' in new_str_expr or 'ceil' in new_str_expr or '.0L' in new_str_expr:
-    return str_expr
-  else:
-    return '[' + new_str_expr + ']'
-
-def mod_simplify(matchobj):
-  str_expr = matchobj.group(0)
-  str_expr = str_expr[1: len(str_expr) - 3]
-  expr = sympy.sympify(str_expr)
-  expr = sympy.simplify(expr)
-  str_expr = str(expr)
-
-  return '(' + str_expr + ') %'
-
-def simplify_expressions(lines):
-  """ Simplify the index expressions in the program
-
-  Use Sympy to simplify all the array index expressions in the program.
+  if line.find('for') != -1:
+    # Parse the loop upper bound
+    m = re.search('<=(.+?);', line)
+    if m:
+      ub = m.group(1).strip()
+      if ub.isnumeric():
+        # Replace it with shallow bit width
+        bitwidth = int(np.ceil(np.log2(float(ub) + 1))) + 1
+        new_iter_t = 'ap_uint<' + str(bitwidth) + '>'
+        line = re.sub('int', new_iter_t, line)
+    m = re.search('<(.+?);', line)
+    if m:
+      ub = m.group(1).strip()
+      if ub.isnumeric():
+        # Replace it with shallow bit width
+        bitwidth = int(np.ceil(np.log2(float(ub)))) + 1
+        new_iter_t = 'ap_uint<' + str(bitwidth) + '>'
+        line = re.sub('int', new_iter_t, line)
+
+  return line
+
+def drop_mark(block, key, out):
+  """ Drop the hls_pipeline or hls_dependence mark of a code block
+
+  The comment line of the mark is removed from the program.
 
   Args:
-    lines: contains the codelines of the program
+    block: the code block
+    key: the mark to drop, 'pipeline' or 'dep'
+    out: contains the output codelines
   """
+  if block[key] != -1:
+    out[block[key]] = None
+    block[key] = -1
 
-  code_len = len(lines)
-  # Simplify array index expressions
-  for pos in range(code_len):
-    line = lines[pos]
-    line = re.sub('\[(.+?)\]', index_simplify, line)
-    lines[pos] = line
+def close_block(block, out, after):
+  """ Insert the HLS pragmas of a code block when it is closed
 
-  # Simplify mod expressions
-  for pos in range(code_len):
-    line = lines[pos]
-    line = re.sub('\((.+?)\) %', mod_simplify, line)
-    lines[pos] = line
-
-  return lines
-
-def shrink_bit_width(lines):
-  """ Calculate the bitwidth of the iterator and shrink it to the proper size
+  If the block is a for loop with a hls_pipeline or hls_dependence mark,
+  the pragmas are inserted right after the for loop and the marks are
+  removed.
 
   Args:
-    lines: contains the codelines of the program
+    block: the code block to close
+    out: contains the output codelines
+    after: maps the position of a codeline to the lines inserted after it
   """
+  if block['for'] == -1:
+    return
+  indent = out[block['for']].find('for')
+  if block['dep'] != -1:
+    var_name = out[block['dep']].strip().split('.')[-1]
+    new_line = ' ' * indent + "#pragma HLS DEPENDENCE variable=" + var_name + " inter false\n"
+    after.setdefault(block['for'], []).append(new_line)
+    out[block['dep']] = None
+  if block['pipeline'] != -1:
+    new_line = ' ' * indent + "#pragma HLS PIPELINE II=1\n"
+    after.setdefault(block['for'], []).append(new_line)
+    out[block['pipeline']] = None
+
+def xlnx_post_process(lines):
+  """ Post-process the program for Xilinx platform
+
+  Shrink the bit width of the loop iterators, insert the HLS pragmas and
+  lift the split buffers in a single pass over the program.
+  A stack of the open code blocks is maintained. Lines to be inserted are
+  recorded by the position of the line they follow or precede, and the
+  program is assembled at the end, so that the pass takes linear time.
 
-  code_len = len(lines)
-  for pos in range(code_len):
-    line = lines[pos]
-    if line.find('for') != -1:
-      # Parse the loop upper bound
-      m = re.search('<=(.+?);', line)
-      if m:
-        ub = m.group(1).strip()
-        if ub.isnumeric():
-          # Replace it with shallow bit width
-          bitwidth = int(np.ceil(np.log2(float(ub) + 1))) + 1
-          new_iter_t = 'ap_uint<' + str(bitwidth) + '>'
-          line = re.sub('int', new_iter_t, line)
-          lines[pos] = line
-      m = re.search('<(.+?);', line)
-      if m:
-        ub = m.group(1).strip()
-        if ub.isnumeric():
-          # Replace it with shallow bit width
-          bitwidth = int(np.ceil(np.log2(float(ub)))) + 1
-          new_iter_t = 'ap_uint<' + str(bitwidth) + '>'
-          line = re.sub('int', new_iter_t, line)
-          lines[pos] = line
-
-  return lines
-
-def lify_split_buffers(lines):
-  """ Lift the split buffers in the program
+  Replace the comments of "// hls_pipeline" and "// hls_unroll" with
+  HLS pragmas
+  For "// hls_pipeline", find the innermost for loop around the comment.
+  Insert "#pragma HLS PIPELINE II=1" below the for loop, unless another
+  "// hls_pipeline" comment follows inside a nested for loop. Several
+  comments of the same for loop, e.g., inside an if block, lead to a
+  single pragma.
+  For "// hls_unroll", find the previous for loop before hitting the "simd" mark.
+  Insert "#pragma HLS UNROLL" below the for loop.
+  For "// hls_dependence.x", the position is the same with hls_pipeline.
+  Insert "#pragma HLS DEPENDENCE variable=x inter false".
 
   For each module, if we find any split buffers with the name "buf_data_split",
   we will lift them out of the for loops and put them in the variable declaration
@@ -357,29 +226,87 @@ def lify_split_buffers(lines):
   Args:
     lines: contains the codelines of the program
   """
-  code_len = len(lines)
-  for pos in range(code_len):
-    line = lines[pos]
-    if line.find('variable=buf_data_split') != -1:
-      # Search for the variable declaration section
-      decl_pos = -1
+  out = []
+  after = {}
+  before = {}
+  blocks = []
+  last_for = -1
+  decl_pos = -1
+
+  for line in lines:
+    line = shrink_bit_width(line)
+    pos = len(out)
+    out.append(line)
+
+    if line.find("// hls_pipeline") != -1 or line.find("// hls_dependence") != -1:
+      is_pipeline = line.find("// hls_pipeline") != -1
+      # The innermost for loop takes the mark, the marks of the outer
+      # for loops are dropped. A mark nested in a non-loop block of the
+      # same for loop, e.g., an if block, replaces the mark of the loop.
+      # The dropped marks are removed from the program.
+      loop = None
+      for block in reversed(blocks):
+        if block['for'] == -1:
+          continue
+        if loop is None:
+          loop = block
+        else:
+          drop_mark(block, 'dep', out)
+          if is_pipeline:
+            drop_mark(block, 'pipeline', out)
+      if loop is not None:
+        key = 'pipeline' if is_pipeline else 'dep'
+        drop_mark(loop, key, out)
+        loop[key] = pos
+    elif line.find("// hls_unroll") != -1:
+      if last_for != -1:
+        indent = out[last_for].find('for')
+        new_line = ' ' * indent + "#pragma HLS UNROLL\n"
+        after.setdefault(last_for, []).append(new_line)
+        out[pos] = None
+    elif line.find('variable=buf_data_split') != -1 and decl_pos != -1:
+      # Move the code lines of the buffer and its pragma to the end of
+      # the variable declaration section
       prev_pos = pos - 1
-      while prev_pos >= 0:
-        prev_line = lines[prev_pos]
-        if prev_line.find('Variable Declaration') != -1:
-          decl_pos = prev_pos
-          break
+      while out[prev_pos] is None:
         prev_pos -= 1
-      # Move the two code lines at [pos - 1] and [pos] to [decl_pos] and [decl_pos + 1]
-      indent = lines[decl_pos].find('/*')
-      line1 = ' ' * indent + lines[pos - 1].lstrip()
-      line2 = ' ' * indent + lines[pos].lstrip()
-      del lines[pos - 1]
-      del lines[pos - 1]
-      lines.insert(decl_pos, line1)
-      lines.insert(decl_pos + 1, line2)
-
-  return lines
+      indent = out[decl_pos].find('/*')
+      before.setdefault(decl_pos, []).append(' ' * indent + out[prev_pos].lstrip())
+      before[decl_pos].append(' ' * indent + line.lstrip())
+      out[prev_pos] = None
+      out[pos] = None
+      continue
+
+    if line.find('Variable Declaration') != -1:
+      decl_pos = pos
+    if line.find('simd') != -1:
+      last_for = -1
+    elif line.find('for') != -1:
+      last_for = pos
+
+    # Update the stack of code blocks
+    l_bracket = line.find('{')
+    r_bracket = line.find('}')
+    if r_bracket != -1 and (l_bracket == -1 or r_bracket < l_bracket):
+      if blocks:
+        close_block(blocks.pop(), out, after)
+    if l_bracket != -1 and (r_bracket == -1 or r_bracket < l_bracket):
+      blocks.append({'for': pos if line.find('for') != -1 else -1,
+                     'pipeline': -1, 'dep': -1})
+
+  while blocks:
+    close_block(blocks.pop(), out, after)
+
+  new_lines = []
+  for pos in range(len(out)):
+    if pos in before:
+      new_lines.extend(before[pos])
+    if out[pos] is not None:
+      new_lines.append(out[pos])
+    if pos in after:
+      new_lines.extend(after[pos])
+
+  return new_lines
 
 def reorder_module_calls(lines):
   """ Reorder the module calls in the program
@@ -388,12 +315,15 @@ def reorder_module_calls(lines):
   Starting from the first module, enlist the module calls until the boundary module
   is met.
   Reverse the list and output it.
+  The module calls are written to a new list in a single pass, the reversed
+  calls replace the tail of the list.
 
   Args:
     lines: contains the codelines of the program
   """
 
   code_len = len(lines)
+  new_lines = []
   module_calls = []
   module_start = 0
   module_call = []
@@ -402,7 +332,6 @@ def reorder_module_calls(lines):
   new_module = 0
   prev_module_name = ""
   first_line = -1
-  last_line = -1
   reset = 0
 
   for pos in range(code_len):
@@ -427,22 +356,21 @@ def reorder_module_calls(lines):
           module_name = module_name[:-9]
         if prev_module_name == "":
           prev_module_name = module_name
-          first_line = pos
+          first_line = len(new_lines)
         else:
           if prev_module_name != module_name:
             new_module = 1
             prev_module_name = module_name
-            first_line = pos
+            first_line = len(new_lines)
             reset = 0
           else:
             if reset:
-              first_line = pos
+              first_line = len(new_lines)
               reset = 0
             new_module = 0
 
       if not module_start:
         if output_io:
-          last_line = pos
           module_call.append(line)
           module_calls.append(module_call.copy())
           module_call.clear()
@@ -450,28 +378,28 @@ def reorder_module_calls(lines):
             # Reverse the list
             module_calls.reverse()
             # Insert it back
-            left_lines = lines[last_line + 1:]
-            lines = lines[:first_line]
+            del new_lines[first_line:]
             first = 1
             for c in module_calls:
               if not first:
-                lines.append("\n")
-              lines = lines + c
+                new_lines.append("\n")
+              new_lines.extend(c)
               first = 0
-            lines = lines + left_lines
             # Clean up
             module_calls.clear()
             boundary = 0
             output_io = 0
             reset = 1
+            continue
           if new_module:
             # Pop out the previous module calls except the last one
             module_calls = module_calls[-1:]
 
     if module_start and output_io:
       module_call.append(line)
+    new_lines.append(line)
 
-  return lines
+  return new_lines
 
 def xilinx_run(kernel_call, kernel_def, kernel='autosa.tmp/output/src/kernel_kernel.cpp', host='opencl'):
   """ Generate the kernel file for Xilinx platform
@@ -490,17 +418,9 @@ def xilinx_run(kernel_call, kernel_def, kernel='autosa.tmp/output/src/kernel_ker
   with open(kernel_def, 'r') as f:
     lines = f.readlines()
 
-  # Simplify the expressions
-  lines = simplify_expressions(lines)
-
-  # Change the loop iterator type
-  lines = shrink_bit_width(lines)
-
-  # Insert the HLS pragmas
-  lines = insert_xlnx_pragmas(lines)
-
-  # Lift the split_buffers
-  lines = lify_split_buffers(lines)
+  # Change the loop iterator type, insert the HLS pragmas and lift the 
+  # split buffers
+  lines = xlnx_post_process(lines)
 
   kernel = str(kernel)
   print("Please find the generated file: " + kernel)
@@ -1046,9 +1046,71 @@ __isl_give isl_schedule_node *add_io_copies_stmt_acc(
   return node;
 }
 
+/* Return the first dimension of "tile" from which on the tile is stored 
+ * contiguously in the array of "group", i.e., the tile covers the full 
+ * extent of the array in all the later dimensions.
+ * Return tile->n - 1 if only the rows of the tile are contiguous.
+ */
+static int tile_burst_dim(struct autosa_array_ref_group *group,
+  struct autosa_array_tile *tile)
+{
+  int pos;
+
+  for (pos = tile->n - 1; pos > 0; pos--) {
+    isl_val *max = isl_set_dim_max_val(
+                    isl_set_copy(group->array->extent), pos);
+    int full;
+
+    max = isl_val_add_ui(max, 1);
+    full = isl_val_is_int(max) && isl_val_eq(max, tile->bound[pos].size) &&
+           isl_val_is_one(tile->bound[pos].stride);
+    isl_val_free(max);
+    if (!full)
+      break;
+  }
+
+  return pos;
+}
+
+/* Return the product of the sizes of "tile" from dimension "pos" on,
+ * i.e., the number of the elements in the contiguous runs of the tile
+ * if "pos" is computed by tile_burst_dim.
+ */
+static long tile_burst_len(struct autosa_array_tile *tile, int pos)
+{
+  long len = 1;
+
+  for (int i = pos; i < tile->n; i++)
+    len *= isl_val_get_num_si(tile->bound[i].size);
+
+  return len;
+}
+
+/* Replace the tile dimensions of "ma" from "pos" on by their row-major 
+ * linearized index in "tile".
+ */
+static __isl_give isl_multi_aff *linearize_tile_dims(
+  __isl_take isl_multi_aff *ma, struct autosa_array_tile *tile, int pos)
+{
+  isl_aff *aff = isl_multi_aff_get_aff(ma, pos);
+
+  for (int i = pos + 1; i < tile->n; i++) {
+    aff = isl_aff_scale_val(aff, isl_val_copy(tile->bound[i].size));
+    aff = isl_aff_add(aff, isl_multi_aff_get_aff(ma, i));
+  }
+  ma = isl_multi_aff_set_aff(ma, pos, aff);
+  ma = isl_multi_aff_drop_dims(ma, isl_dim_out, pos + 1, tile->n - pos - 1);
+
+  return ma;
+}
+
 /* Insert the copy statement at the node level to transfer the entire tie.
  * If "is_buffer" is set, add a marker for dependence false. This is
  * only for Xilinx platform.
+ * If "burst_dim" is non-negative, the tile dimensions from "burst_dim" on
+ * are contiguous in the DRAM (see tile_burst_dim) and are transferred
+ * by a single pipelined loop over their linearized index, so that each 
+ * contiguous run of the tile is one sequential burst.
  */
 static __isl_give isl_schedule_node *add_io_copies_stmt_tile(
   struct autosa_kernel *kernel,
@@ -1061,7 +1123,8 @@ static __isl_give isl_schedule_node *add_io_copies_stmt_tile(
   __isl_take char *stmt_name,
   int before, int is_buffer,
   /* If it is proper to insert hls_pipeline for Xilinx platforms. */
-  int insert_dependence                 
+  int insert_dependence,
+  int burst_dim
   )
 {
   isl_union_map *access = NULL;
@@ -1095,6 +1158,8 @@ static __isl_give isl_schedule_node *add_io_copies_stmt_tile(
   ma = isl_multi_aff_copy(tile->tiling);
   ma = isl_multi_aff_pullback_multi_aff(ma, 
       isl_multi_aff_copy(from_access));
+  if (burst_dim >= 0)
+    ma = linearize_tile_dims(ma, tile, burst_dim);
   mpa = isl_multi_pw_aff_from_multi_aff(ma);
   mupa = isl_multi_union_pw_aff_from_multi_pw_aff(mpa);
 
@@ -1391,7 +1456,8 @@ static __isl_give isl_schedule *generate_io_module_inter_trans(
     node = add_io_copies_stmt_tile(kernel, group, node, 
               buf->tile, buf->tile, buf->n_lane, read, stmt_name, read? 1: 0, 
               is_buffer & 0, 
-              coalesce_bound > 1 && 0 && kernel->options->autosa->insert_hls_dependence);
+              coalesce_bound > 1 && 0 && kernel->options->autosa->insert_hls_dependence,
+              -1);
     node = isl_schedule_node_cut(node);
     /* Insert empty filter. */
     empty_filter = isl_union_set_from_set(isl_set_empty(
@@ -1650,8 +1716,8 @@ static __isl_give isl_schedule *generate_io_module_intra_trans(
               cur_buf->tile, buf->tile, buf->n_lane, 
               read, stmt_name, read? 1: 0, is_buffer & 0,
               coalesce_bound > 1 && cur_buf->n_lane != buf->n_lane 
-                && kernel->options->autosa->insert_hls_dependence
-              );
+                && kernel->options->autosa->insert_hls_dependence,
+              -1);
     node = isl_schedule_node_cut(node);
     /* Insert empty filter. */
     empty_filter = isl_union_set_from_set(isl_set_empty(isl_set_get_space(kernel->context)));
@@ -2213,6 +2279,7 @@ static isl_stat generate_default_io_module_schedule(
     int coalesce_depth;
     isl_val *coalesce_bound_val;
     int coalesce_bound;
+    int burst_dim = -1;
 
     /* Add the I/O statement for the entire group. */
     module->data_pack_inter = buf->n_lane;
@@ -2221,9 +2288,17 @@ static isl_stat generate_default_io_module_schedule(
     p = isl_printer_print_int(p, buf->n_lane);
 
 	  /* Compute the coalesce loop depth and upper bounds. */
-    coalesce_depth = isl_schedule_node_get_schedule_depth(node) + buf->tile->n - 1;
-    coalesce_bound_val = buf->tile->bound[buf->tile->n - 1].size;
-    coalesce_bound = isl_val_get_num_si(coalesce_bound_val) / buf->n_lane;
+    if (module->to_mem && is_buffer && gen->options->autosa->burst_buffer) {
+      /* The burst buffer is transferred from/to the DRAM by one loop 
+       * over each contiguous run of the tile. */
+      burst_dim = tile_burst_dim(group, buf->tile);
+      coalesce_depth = isl_schedule_node_get_schedule_depth(node) + burst_dim;
+      coalesce_bound = tile_burst_len(buf->tile, burst_dim) / buf->n_lane;
+    } else {
+      coalesce_depth = isl_schedule_node_get_schedule_depth(node) + buf->tile->n - 1;
+      coalesce_bound_val = buf->tile->bound[buf->tile->n - 1].size;
+      coalesce_bound = isl_val_get_num_si(coalesce_bound_val) / buf->n_lane;
+    }
     if (coalesce_bound <= 1) {
       coalesce_depth = -1;
     }
@@ -2238,7 +2313,8 @@ static isl_stat generate_default_io_module_schedule(
     node = add_io_copies_stmt_tile(kernel, group, node, 
               buf->tile, buf->tile, buf->n_lane, read, 
               stmt_name, read? 1: 0, is_buffer,
-              coalesce_bound > 1 && 0 && kernel->options->autosa->insert_hls_dependence);
+              coalesce_bound > 1 && 0 && kernel->options->autosa->insert_hls_dependence,
+              burst_dim);
     if (!is_buffer) {
       node = isl_schedule_node_cut(node);
       empty_filter = isl_union_set_from_set(isl_set_empty(isl_set_get_space(kernel->context)));
@@ -2315,7 +2391,8 @@ static isl_stat generate_default_io_module_schedule(
       node = add_io_copies_stmt_tile(kernel, group, node, cur_buf->tile, 
               buf->tile, buf->n_lane, read, stmt_name, read? 1 : 0, is_buffer,
               coalesce_bound > 1 && cur_buf->n_lane != buf->n_lane
-                && kernel->options->autosa->insert_hls_dependence);
+                && kernel->options->autosa->insert_hls_dependence,
+              -1);
       node = isl_schedule_node_cut(node);
       empty_filter = isl_union_set_from_set(isl_set_empty(
               isl_set_get_space(kernel->context)));
@@ -2438,6 +2515,28 @@ static __isl_give struct autosa_hw_module *generate_io_module_by_type(
   return module;
 }
 
+/* Return 1 if the I/O module of "group" at the outermost level "outermost"
+ * is buffered in addition to the default I/O buffers.
+ * When two-level buffering is enabled, we will implement a second-level 
+ * buffer at the outermost I/O module.
+ * When burst buffering is enabled, the outermost I/O module transfers 
+ * the array tile between the DRAM and the local buffer allocated by 
+ * compute_io_group_buffer in bursts, and transfers the data between 
+ * the local buffer and the FIFOs in a separate loop.
+ */
+static int is_outermost_io_buffer(struct autosa_gen *gen, 
+  struct autosa_array_ref_group *group, int i, int outermost)
+{
+  if (i != outermost)
+    return 0;
+  if (gen->options->autosa->two_level_buffer)
+    return 1;
+  if (gen->options->autosa->burst_buffer)
+    return group->io_buffers[i - 1]->tile != NULL;
+
+  return 0;
+}
+
 /* This function builds a set of I/O modules for each I/O group.
  * We will first examine if any flow dependence that is associated with the 
  * current group is carried by the array part loops. 
@@ -2588,13 +2687,8 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
         }
       }
 
-      if (gen->options->autosa->two_level_buffer) {
-        /* When two-level buffering is enabled, 
-         * we will implement a second-level buffe at the outermost I/O module.
-         */
-        if (i == outermost)
-          is_buffer = 1;
-      }
+      if (is_outermost_io_buffer(gen, group, i, outermost))
+        is_buffer = 1;
 
       /* Generate the I/O module */
       if (i >= innermost && i <= outermost) {
@@ -2605,8 +2699,11 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
         module->to_mem = (i == outermost)? 1 : 0;
         module->credit = (i == outermost)? credit : 0;
         module->n_array_ref = group->local_array->n_io_group_refs;
+        /* The L3 I/O modules split across HBM channels use one pointer
+         * per channel. */
         if (module->to_mem)
-          group->local_array->n_io_group_refs++;
+          group->local_array->n_io_group_refs += 
+            group->n_hbm_port > 1 ? group->n_hbm_port : 1;
 
         module = generate_io_module_by_type(module, node, group, kernel, 
             gen, i, space_dim, is_filter, is_buffer, 1);
@@ -2658,13 +2755,8 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
         }
       }
 
-      if (gen->options->autosa->two_level_buffer) {
-        /* When two-level buffering is enabled, 
-         * we will implement a second-level buffer at the outermost I/O module.
-         */
-        if (i == outermost)
-          is_buffer = 1;
-      }
+      if (is_outermost_io_buffer(gen, group, i, outermost))
+        is_buffer = 1;
 
       /* Generate the I/O module. */
       if (i >= innermost && i <= outermost) {
@@ -2676,7 +2768,8 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
         module->credit = (i == outermost)? credit : 0;
         module->n_array_ref = group->local_array->n_io_group_refs;
         if (module->to_mem)
-          group->local_array->n_io_group_refs++;
+          group->local_array->n_io_group_refs += 
+            group->n_hbm_port > 1 ? group->n_hbm_port : 1;
 
         module = generate_io_module_by_type(module, node, group, kernel, 
             gen, i, space_dim, is_filter, is_buffer, 0);
@@ -5846,6 +5939,7 @@ __isl_give isl_ast_expr *autosa_local_array_info_linearize_index(
 	if (1 + array->n_index > n) {
 		res = isl_ast_expr_add(isl_ast_expr_get_op_arg(expr, 0), res);
 	} else {
+		res = autosa_ast_expr_simplify(res);
 		list = isl_ast_expr_list_from_ast_expr(res);
 		res = isl_ast_expr_get_op_arg(expr, 0);
 		res = isl_ast_expr_access(res, list);
@@ -7093,7 +7187,7 @@ static __isl_give isl_ast_node *create_io_leaf(struct autosa_kernel *kernel,
       isl_ast_expr *arg, *div;
       arg = isl_ast_expr_get_op_arg(expr, 1);
       div = isl_ast_expr_from_val(isl_val_int_from_si(kernel->ctx, stmt->u.i.data_pack));
-      arg = isl_ast_expr_div(arg, div); 
+      arg = autosa_ast_expr_simplify(isl_ast_expr_div(arg, div));
       expr = isl_ast_expr_set_op_arg(expr, 1, arg);
     }
   } else {
@@ -7106,7 +7200,7 @@ static __isl_give isl_ast_node *create_io_leaf(struct autosa_kernel *kernel,
       n_arg = isl_ast_expr_get_op_n_arg(expr);
       arg = isl_ast_expr_get_op_arg(expr, n_arg - 1);
       div = isl_ast_expr_from_val(isl_val_int_from_si(kernel->ctx, stmt->u.i.data_pack));
-      arg = isl_ast_expr_div(arg, div);
+      arg = autosa_ast_expr_simplify(isl_ast_expr_div(arg, div));
       expr = isl_ast_expr_set_op_arg(expr, n_arg - 1, arg);
     }
   }
@@ -7399,6 +7493,7 @@ static __isl_give isl_ast_node *create_fifo_decl_leaf(
     stmt->u.m.boundary = 1;
   else
     stmt->u.m.boundary = 0;
+  stmt->u.m.fifo_chain_dim = -1;
   id = isl_id_alloc(ctx, "fifo_decl", stmt);
   id = isl_id_set_free_user(id, &autosa_kernel_stmt_free);
   if (!id)
@@ -2,7 +2,14 @@
 
 #include <isl/ilp.h>
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "autosa_comm.h"
+#include "autosa_resource_est.h"
 #include "autosa_schedule_tree.h"
 #include "autosa_utils.h"
 
@@ -1219,13 +1226,12 @@ static isl_stat compute_io_group_schedule(
       node = isl_schedule_node_child(node, 0);
     }
 
-    /* If the multi-port DRAM/HBM is to be used, we will need to tile the loop again.
-     * TODO: This feature is not fully supported yet.
+    /* If HBM is used, we will tile the outermost loop again so that
+     * the L3 I/O modules are split across the HBM channels of the array, 
+     * one tile per channel.
      */
-    if (i == 0 && gen->options->autosa->hbm) {      
+    if (i == 0 && group->local_array->n_hbm_port > 1) {      
       printf("[AutoSA] Apply HBM optimization.\n");      
-      isl_die(ctx, isl_error_unsupported, 
-                "HBM not supported yet", goto next);
       if (group->io_type == AUTOSA_EXT_IO && i == space_dim - 1) { 
         printf("[AutoSA] HBM optimization failed! Not enough I/O modules.\n");
         goto next; 
@@ -1233,35 +1239,34 @@ static isl_stat compute_io_group_schedule(
       
       isl_union_set *uset;
       isl_set *set;
-      isl_basic_set *bset;
       isl_union_map *umap;
       isl_val *val;
-      int tile_len = 1;
-      int *tile_size = NULL;
-      tile_size = read_hbm_tile_sizes(kernel, tile_len);
-      printf("[AutoSA] HBM port: %d\n", tile_size[0]);
+      int tile_size[1];
+      int extent, n_port;
 
-      /* Check if the tile factor is greater or equal than the loop bound */
+      /* The number of channels should divide the loop bound. */
       umap = isl_schedule_node_band_get_partial_schedule_union_map(node);
       uset = isl_union_map_range(umap);       
       set = isl_set_from_union_set(uset);
       val = isl_val_zero(ctx);
       isl_set_foreach_basic_set(set, &extract_set_max_dim, &val);
       isl_set_free(set);
-      if (isl_val_get_num_si(val) <= tile_size[0]) {
-        /* The current loop bound is smaller than the tile size, 
-         * no need to further tile. 
-         */
-        free(tile_size);
-        isl_val_free(val);
+      extent = isl_val_is_int(val) ? isl_val_get_num_si(val) + 1 : 1;
+      isl_val_free(val);
+      n_port = min(group->local_array->n_hbm_port, extent);
+      while (n_port > 1 && extent % n_port != 0)
+        n_port--;
+      if (n_port <= 1) {
         printf("[AutoSA] HBM optimization failed! Please try to use a smaller HBM port number.\n");
         goto next;
       }
-      isl_val_free(val);
+      tile_size[0] = extent / n_port;
+      printf("[AutoSA] HBM port: %d\n", n_port);
 
       node = autosa_tile_band(node, tile_size);
       node = isl_schedule_node_child(node, 0);
       space_dim++;
+      group->n_hbm_port = n_port;
 
       /* Update the transformation function */
       isl_aff *aff = isl_multi_aff_get_aff(io_trans_ma, 0);
@@ -1284,7 +1289,6 @@ static isl_stat compute_io_group_schedule(
       isl_multi_aff_free(io_trans_ma);
       space = isl_space_add_dims(space, isl_dim_out, 1);
       io_trans_ma = isl_multi_aff_from_aff_list(space, aff_list);
-      free(tile_size);
     }
 next:
     p_str = isl_printer_to_str(ctx);
@@ -1313,18 +1317,150 @@ next:
   return isl_stat_ok;
 }
 
-static __isl_give isl_map *local_access_io_at_node(struct autosa_kernel *kernel,
-  struct autosa_array_ref_group *group,
-  __isl_keep isl_union_map *access, __isl_keep isl_schedule_node *node)
+/* A local tile computed for the accesses of "group" (collected with 
+ * autosa_array_ref_group_access_relation(group, "read", 1)) under 
+ * the expanded prefix schedule "sched" of depth "depth".
+ * "tile" is NULL if the accesses can't be tiled.
+ */
+struct autosa_tile_memo_entry {
+  struct autosa_array_ref_group *group;
+  int read;
+  int depth;
+  isl_union_map *sched;
+  struct autosa_array_tile *tile;
+};
+
+/* Memoization table of the local tiles computed for the array reference
+ * groups of a kernel.
+ * The same tiles are requested at the different I/O levels, at the PE level
+ * and while hoisting the I/O buffers. The prefix schedules of these requests
+ * often coincide although they come from different schedule trees 
+ * (the I/O schedule of the group and the kernel schedule), so the 
+ * entries are looked up by comparing the prefix schedules.
+ * The table only lives during the I/O optimization of a single group,
+ * so that the groups it refers to are never freed while it is in use.
+ * "access" holds the access relations of the groups, indexed by group and
+ * by the "read" argument used to collect them.
+ */
+struct autosa_tile_memo {
+  std::vector<struct autosa_tile_memo_entry> entries;
+  std::map<std::pair<struct autosa_array_ref_group *, int>, 
+    isl_union_map *> access;
+};
+
+static struct autosa_tile_memo *autosa_tile_memo_alloc()
 {
-  isl_union_map *local, *sched;
+  return new autosa_tile_memo;
+}
+
+static struct autosa_tile_memo *autosa_tile_memo_free(
+  struct autosa_tile_memo *memo)
+{
+  if (!memo)
+    return NULL;
+
+  for (size_t i = 0; i < memo->entries.size(); i++) {
+    isl_union_map_free(memo->entries[i].sched);
+    autosa_array_tile_free(memo->entries[i].tile);
+  }
+  for (auto it = memo->access.begin(); it != memo->access.end(); ++it)
+    isl_union_map_free(it->second);
+  delete memo;
+
+  return NULL;
+}
+
+/* Return the accesses of "group" as collected by 
+ * autosa_array_ref_group_access_relation(group, "read", 1), 
+ * reusing the result of a previous call from the memoization table 
+ * of "kernel", if any.
+ */
+static __isl_give isl_union_map *memo_group_access_relation(
+  struct autosa_kernel *kernel, struct autosa_array_ref_group *group, int read)
+{
+  struct autosa_tile_memo *memo = kernel->tile_memo;
+  isl_union_map *access;
+
+  if (!memo)
+    return autosa_array_ref_group_access_relation(group, read, 1);
+
+  auto key = std::make_pair(group, read);
+  auto it = memo->access.find(key);
+  if (it != memo->access.end())
+    return isl_union_map_copy(it->second);
+
+  access = autosa_array_ref_group_access_relation(group, read, 1);
+  memo->access[key] = isl_union_map_copy(access);
+
+  return access;
+}
+
+/* Compute the local tile of the accesses of "group" at "node" and 
+ * store it in "tile", or store NULL in "tile" if the accesses can't be tiled.
+ * The accesses are collected by 
+ * autosa_array_ref_group_access_relation(group, "read", 1) and mapped to 
+ * the outer schedule dimensions at "node".
+ *
+ * If the same tile has been computed before for "group" under the same
+ * prefix schedule, a copy of that tile is returned instead.
+ */
+static isl_stat compute_group_tile_at_node(struct autosa_kernel *kernel,
+  struct autosa_array_ref_group *group, __isl_keep isl_schedule_node *node,
+  int read, struct autosa_array_tile **tile)
+{
+  isl_ctx *ctx = isl_space_get_ctx(group->array->space);
+  struct autosa_tile_memo *memo = kernel->tile_memo;
+  isl_union_map *access, *sched;
+  isl_map *acc;
+  isl_bool ok;
+  int depth;
 
-  local = isl_union_map_copy(access);
   sched = prefix_with_equalities(node);
   sched = expand(sched, kernel->contraction);
-  local = isl_union_map_apply_domain(local, sched);
-  
-  return isl_map_from_union_map(local);
+  depth = isl_schedule_node_get_schedule_depth(node);
+  if (memo) {
+    for (size_t i = 0; i < memo->entries.size(); i++) {
+      struct autosa_tile_memo_entry *entry = &memo->entries[i];
+      if (entry->group != group || entry->read != read || 
+          entry->depth != depth)
+        continue;
+      if (isl_union_map_is_equal(entry->sched, sched) == isl_bool_true) {
+        isl_union_map_free(sched);
+        *tile = autosa_array_tile_dup(entry->tile);
+        return isl_stat_ok;
+      }
+    }
+  }
+
+  /* Create a tile. */
+  *tile = autosa_array_tile_create(ctx, group->array->n_index);
+  /* Map the domain to the outer scheduling dimensions. */
+  access = memo_group_access_relation(kernel, group, read);
+  access = isl_union_map_apply_domain(access, isl_union_map_copy(sched));
+  acc = isl_map_from_union_map(access);
+  /* Collect the shift and scale factors of the tile. */
+  ok = can_tile(acc, *tile);
+  isl_map_free(acc);
+  if (ok < 0) {
+    isl_union_map_free(sched);
+    return isl_stat_error;
+  }
+  if (!ok)
+    *tile = autosa_array_tile_free(*tile);
+
+  if (memo) {
+    struct autosa_tile_memo_entry entry;
+    entry.group = group;
+    entry.read = read;
+    entry.depth = depth;
+    entry.sched = sched;
+    entry.tile = autosa_array_tile_dup(*tile);
+    memo->entries.push_back(entry);
+  } else {
+    isl_union_map_free(sched);
+  }
+
+  return isl_stat_ok;
 }
 
 /* Compute the local memory tiles for the drain group "group"
@@ -1337,12 +1473,7 @@ isl_stat compute_group_bounds_drain_at_node(struct autosa_kernel *kernel,
   struct autosa_array_ref_group *group, __isl_keep isl_schedule_node *node,
   struct autosa_io_buffer *buffer) 
 {
-  isl_ctx *ctx = isl_space_get_ctx(group->array->space);
   int use_local = kernel->options->autosa->use_local_memory;
-  isl_stat r = isl_stat_ok;
-  isl_union_map *access;
-  isl_map *acc;
-  isl_bool ok;
 
   if (!use_local)
     return isl_stat_ok;
@@ -1353,30 +1484,7 @@ isl_stat compute_group_bounds_drain_at_node(struct autosa_kernel *kernel,
   if (group->slice)
     return isl_stat_ok;
  
-  /* Collect all accesses in the group. */
-  access = autosa_array_ref_group_access_relation(group, 0, 1);
-  /* Create local tile */
-  if (use_local) {
-    /* Create a tile */
-    buffer->tile = autosa_array_tile_create(ctx, group->array->n_index);
-    /* Map the domain to the outer scheduling dimensions */
-    acc = local_access_io_at_node(kernel, group, access, node);
-    /* Collect the shift and scale factors of the tile */
-    ok = can_tile(acc, buffer->tile);
-    if (ok < 0)
-      r = isl_stat_error;
-    else if (!ok)
-      buffer->tile = autosa_array_tile_free(buffer->tile);
-    isl_map_free(acc);
-  }
-
-  if (r < 0) {
-    isl_union_map_free(access);
-    return r;
-  }
-
-  isl_union_map_free(access);
-  return isl_stat_ok;
+  return compute_group_tile_at_node(kernel, group, node, 0, &buffer->tile);
 }
 
 /* Should this array reference group be mapped to local or global
@@ -1587,12 +1695,7 @@ static isl_stat compute_group_bounds_drain_at_node_PE(
   struct autosa_kernel *kernel, struct autosa_array_ref_group *group, 
   __isl_keep isl_schedule_node *node) 
 {
-  isl_ctx *ctx = isl_space_get_ctx(group->array->space);
   int use_local = kernel->options->autosa->use_local_memory;
-  isl_stat r = isl_stat_ok;
-  isl_union_map *access;
-  isl_map *acc;
-  isl_bool ok;
 
   if (!use_local)
     return isl_stat_ok;
@@ -1603,30 +1706,7 @@ static isl_stat compute_group_bounds_drain_at_node_PE(
   if (group->slice)
     return isl_stat_ok;
  
-  /* Collect all accesses in the group. */
-  access = autosa_array_ref_group_access_relation(group, 0, 1);
-  /* Create local tile. */
-  if (use_local) {
-    /* Create a tile. */
-    group->pe_tile = autosa_array_tile_create(ctx, group->array->n_index);
-    /* Map the domain to the outer scheduling dimensions. */
-    acc = local_access_io_at_node(kernel, group, access, node);
-    /* Collect the shift and scale factors of the tile. */
-    ok = can_tile(acc, group->pe_tile);
-    if (ok < 0)
-      r = isl_stat_error;
-    else if (!ok)
-      group->pe_tile = autosa_array_tile_free(group->pe_tile);
-    isl_map_free(acc);
-  }
-
-  if (r < 0) {
-    isl_union_map_free(access);
-    return r;
-  }
-
-  isl_union_map_free(access);
-  return isl_stat_ok;
+  return compute_group_tile_at_node(kernel, group, node, 0, &group->pe_tile);
 }
 
 /* Compute the drain group tiling at the PE level. */
@@ -1655,12 +1735,7 @@ isl_stat compute_group_bounds_io_at_node(struct autosa_kernel *kernel,
   struct autosa_array_ref_group *group, __isl_keep isl_schedule_node *node,
   struct autosa_io_buffer *buffer) 
 {
-  isl_ctx *ctx = isl_space_get_ctx(group->array->space);
   int use_local = kernel->options->autosa->use_local_memory;
-  isl_stat r = isl_stat_ok;
-  isl_union_map *access;
-  isl_map *acc;
-  isl_bool ok;
 
   if (!use_local)
     return isl_stat_ok;
@@ -1671,30 +1746,7 @@ isl_stat compute_group_bounds_io_at_node(struct autosa_kernel *kernel,
   if (group->slice)
     return isl_stat_ok;
  
-  /* Collect all accesses in the group. */
-  access = autosa_array_ref_group_access_relation(group, 1, 1);
-  /* Create local tile. */
-  if (use_local) {
-    /* Create a tile. */
-    buffer->tile = autosa_array_tile_create(ctx, group->array->n_index);
-    /* Map the domain to the outer scheduling dimensions. */
-    acc = local_access_io_at_node(kernel, group, access, node);
-    /* Collect the shift and scale factors of the tile. */
-    ok = can_tile(acc, buffer->tile);
-    if (ok < 0)
-      r = isl_stat_error;
-    else if (!ok)
-      buffer->tile = autosa_array_tile_free(buffer->tile);
-    isl_map_free(acc);
-  }
-
-  if (r < 0) {
-    isl_union_map_free(access);
-    return r;
-  }
-
-  isl_union_map_free(access);
-  return isl_stat_ok;
+  return compute_group_tile_at_node(kernel, group, node, 1, &buffer->tile);
 }
 
 /* Compute the tiling group bounds for the io group at the PE level. */
@@ -1702,12 +1754,7 @@ isl_stat compute_group_bounds_io_at_node_PE(
   struct autosa_kernel *kernel,
   struct autosa_array_ref_group *group, __isl_keep isl_schedule_node *node) 
 {
-  isl_ctx *ctx = isl_space_get_ctx(group->array->space);
   int use_local = kernel->options->autosa->use_local_memory;
-  isl_stat r = isl_stat_ok;
-  isl_union_map *access;
-  isl_map *acc;
-  isl_bool ok;
 
   if (!use_local)
     return isl_stat_ok;
@@ -1718,30 +1765,7 @@ isl_stat compute_group_bounds_io_at_node_PE(
   if (group->slice)
     return isl_stat_ok;
  
-  /* Collect all accesses in the group. */
-  access = autosa_array_ref_group_access_relation(group, 1, 1);
-  /* Create local tile. */
-  if (use_local) {
-    /* Create a tile. */
-    group->pe_tile = autosa_array_tile_create(ctx, group->array->n_index);
-    /* Map the domain to the outer scheduling dimensions. */
-    acc = local_access_io_at_node(kernel, group, access, node);
-    /* Collect the shift and scale factors of the tile. */
-    ok = can_tile(acc, group->pe_tile);
-    if (ok < 0)
-      r = isl_stat_error;
-    else if (!ok)
-      group->pe_tile = autosa_array_tile_free(group->pe_tile);
-    isl_map_free(acc);
-  }
-
-  if (r < 0) {
-    isl_union_map_free(access);
-    return r;
-  }
-
-  isl_union_map_free(access);
-  return isl_stat_ok;
+  return compute_group_tile_at_node(kernel, group, node, 1, &group->pe_tile);
 }
 
 /* Create the tiling for the IO group at the PE level. */
@@ -1767,6 +1791,8 @@ static isl_stat compute_io_tiling_at_PE(struct autosa_kernel *kernel,
  * - io group @ io_L1 (INT_IO) | io_L2 (EXT_IO)
  * If two-level buffer is turned on, we will also allocate buffers
  * at the outermost level for each group.
+ * If burst buffer is turned on, we will allocate buffers at the outermost 
+ * level for the groups that are not buffered at that level yet.
  * Furthermore, we will also decide if we need to further lift the L2
  * buffer to increase the memory coalescing.
  */
@@ -1777,6 +1803,7 @@ static isl_stat compute_io_group_buffer(struct autosa_kernel *kernel,
   int io_level = group->io_level;
   int i;
   int two_level_buffer = gen->options->autosa->two_level_buffer;
+  int burst_buffer = gen->options->autosa->burst_buffer;
 
   node = isl_schedule_get_root(group->io_schedule);
 
@@ -1829,16 +1856,20 @@ static isl_stat compute_io_group_buffer(struct autosa_kernel *kernel,
         group->io_buffers[group->n_io_buffer - 1]->tile = NULL;
       }
 
-      if (two_level_buffer) {
-        if (i == io_level) {
-          /* Compute the group tiling at the outermost I/O module. */
-          if (group->group_type == AUTOSA_DRAIN_GROUP) 
-            compute_group_bounds_drain_at_node(kernel, group, node, group->io_buffers[group->n_io_buffer - 1]);
-          else if (group->group_type == AUTOSA_IO_GROUP) 
-            compute_group_bounds_io_at_node(kernel, group, node, group->io_buffers[group->n_io_buffer - 1]);            
-          
-          autosa_array_ref_group_compute_tiling(group->io_buffers[group->n_io_buffer - 1]->tile, group);
-        }
+      if (i == io_level && (two_level_buffer || 
+          (burst_buffer && !group->io_buffers[group->n_io_buffer - 1]->tile))) {
+        struct autosa_io_buffer *buf = group->io_buffers[group->n_io_buffer - 1];
+        /* Compute the group tiling at the outermost I/O module, which 
+         * is used as the second-level buffer or the burst buffer of 
+         * the DRAM accesses. 
+         */
+        if (group->group_type == AUTOSA_DRAIN_GROUP) 
+          compute_group_bounds_drain_at_node(kernel, group, node, buf);
+        else if (group->group_type == AUTOSA_IO_GROUP) 
+          compute_group_bounds_io_at_node(kernel, group, node, buf);
+        
+        if (buf->tile)
+          autosa_array_ref_group_compute_tiling(buf->tile, group);
       }
       i++;
     }
@@ -1994,6 +2025,13 @@ static isl_bool update_group_simd(__isl_keep isl_schedule_node *node, void *user
  * 
  * If SIMD vectorization is enabled, and the data stored in the I/O buffer is 
  * to be vectorized, the data pack factor should also be multiples of the SIMD factor.
+ *
+ * The data pack factors are no more than the number of elements that fit in 
+ * the DRAM port of the array (see sa_port_width). The SIMD lanes should be
+ * aligned to "max_n_lane", which defaults to the same number.
+ * Unless "pow2_data_pack" is disabled in the hardware information file, 
+ * each factor is a power-of-two multiple of the factor of the lower-level
+ * buffer.
  */
 static isl_stat compute_io_group_data_pack(struct autosa_kernel *kernel,
   struct autosa_array_ref_group *group, struct autosa_gen *gen, int max_n_lane)
@@ -2001,10 +2039,13 @@ static isl_stat compute_io_group_data_pack(struct autosa_kernel *kernel,
   isl_schedule_node *node; 
   struct update_group_simd_data data;
   int ele_size = group->array->size; // bytes
-  /* Given the maximal DRAM port width as 64 Bytes, 
-   * compute the maximal data pack factor. */
+  int pow2 = sa_pow2_data_pack(gen->options->autosa);
+  /* Given the DRAM port width, compute the maximal data pack factor. */
+  int port_n_lane = 
+    sa_port_width(gen->options->autosa, group->array->name) / 8 / ele_size;
+  port_n_lane = max(port_n_lane, 1);
   if (max_n_lane == -1)
-    max_n_lane = 64 / ele_size; 
+    max_n_lane = port_n_lane;
 
   /* Examine if any of the array reference in the group is in used by SIMD loop.
    * The default SIMD lane for the group is 1. 
@@ -2018,9 +2059,12 @@ static isl_stat compute_io_group_data_pack(struct autosa_kernel *kernel,
   data.kernel = kernel;
   isl_schedule_node_foreach_descendant_top_down(node, &update_group_simd, &data);
   isl_schedule_node_free(node);
-  if (max_n_lane % group->n_lane != 0) {
+  if (pow2 ? max_n_lane % group->n_lane != 0 : group->n_lane > max_n_lane) {
     printf("[AutoSA] Error: The data is not aligned to the DRAM port. Abort!\n");
-    printf("[AutoSA] Please try to use a SIMD factor as sub-multiples of %d.\n", max_n_lane);
+    if (pow2)
+      printf("[AutoSA] Please try to use a SIMD factor as sub-multiples of %d.\n", max_n_lane);
+    else
+      printf("[AutoSA] Please try to use a SIMD factor no more than %d.\n", max_n_lane);
     exit(1);
   }
 
@@ -2052,13 +2096,14 @@ static isl_stat compute_io_group_data_pack(struct autosa_kernel *kernel,
   for (int i = 0; i < group->io_level; i++) {
     struct autosa_io_buffer *buf = group->io_buffers[i];
     if (i == 0)
-      cur_max_n_lane = max(group->n_lane, 8 / ele_size);  // 64 bits
+      cur_max_n_lane = max(group->n_lane, min(8 / ele_size, port_n_lane));  // 64 bits
     else if (i > 0 && i < group->io_level - 1) 
-      cur_max_n_lane = max(group->n_lane, 32 / ele_size); // 256 bits
+      cur_max_n_lane = max(group->n_lane, min(32 / ele_size, port_n_lane)); // 256 bits
     else
-      cur_max_n_lane = max(group->n_lane, 64 / ele_size); // 512 bits
+      cur_max_n_lane = max(group->n_lane, port_n_lane); // DRAM port
     if (buf->tile) {
       int n_lane = cur_n_lane;
+      int lane_step = cur_n_lane;
       isl_val *size = isl_val_copy(buf->tile->bound[group->array->n_index - 1].size);
       while (n_lane <= cur_max_n_lane) {
         /* The lane should be multiples of SIMD lane. */
@@ -2071,7 +2116,7 @@ static isl_stat compute_io_group_data_pack(struct autosa_kernel *kernel,
           }
           isl_val_free(val);
         }
-        n_lane = n_lane * 2;
+        n_lane = pow2 ? n_lane * 2 : n_lane + lane_step;
       }
       if (status) {
         buf->n_lane = cur_n_lane;
@@ -2102,13 +2147,13 @@ static isl_stat compute_io_group_data_pack(struct autosa_kernel *kernel,
  * buffer size is irrelevant to the outer loop. This helps save the communication.
  * 
  * If the buffer location is not changed, we will last check if the last dimension
- * of the array can be packed as multiples of 512 bits. Since the maximal DRAM
- * port width is 512 bits.
+ * of the array can be packed as multiples of the DRAM port width 
+ * (512 bits by default, see sa_port_width).
  * This is helpful because on Xilinx FPGAs, we limit the maximal on-chip fifo 
- * width to 256 bits. Repacking the data to 512 bits at the L2 I/O buffer 
+ * width to 256 bits. Repacking the data to the port width at the L2 I/O buffer 
  * could help improve the effective DRAM bandwidth.
  *
- * If it is not a multiple of 512 bits, there is no benefit overall to generate
+ * If it is not a multiple of the port width, there is no benefit overall to generate
  * L2 I/O buffers. In this case, we will free up the L2 I/O buffer. 
  * No L2 I/O buffer is generated.
  */
@@ -2186,11 +2231,13 @@ static isl_stat hoist_L2_io_buffer(struct autosa_kernel *kernel,
   if (is_last_dim_equal && new_depth == old_depth) {
     /* In this case, the buffer couldn't be hosited up, and it doesn't 
      * increase the burst length. 
-     * We will test if the last dimension is a multiple of 512 bits (64 bytes).
+     * We will test if the last dimension is a multiple of the DRAM port width.
      */
+    int port_bytes = sa_port_width(gen->options->autosa, 
+                                   group->array->name) / 8;
     cur_last_dim = cur_buffer->tile->bound[cur_buffer->tile->n - 1].size;
     long dim_val = isl_val_get_num_si(cur_last_dim);
-    if ((dim_val * group->array->size) % 64 != 0) {
+    if ((dim_val * group->array->size) % port_bytes != 0) {
       /*There is no benefit to generate the 
        * second-level buffer. We will free up the tile.
        */
@@ -2211,6 +2258,9 @@ static isl_stat hoist_L2_io_buffer(struct autosa_kernel *kernel,
  * - I/O module clustering
  * - L2 I/O buffering
  * - Data packing
+ *
+ * The local tiles computed while allocating and hoisting the I/O buffers 
+ * are memoized in kernel->tile_memo.
  */
 static isl_stat autosa_io_optimize(
   struct autosa_kernel *kernel, struct autosa_array_ref_group *group, 
@@ -2218,12 +2268,14 @@ static isl_stat autosa_io_optimize(
 {
   /* Update the I/O schedules by I/O module clustering. */
   compute_io_group_schedule(kernel, group, gen);
+  kernel->tile_memo = autosa_tile_memo_alloc();
   /* Allocate I/O buffers inside I/O modules. */
   compute_io_group_buffer(kernel, group, gen);
   if (gen->options->autosa->two_level_buffer) {
     /* Seek the opportunity to hoist up the L2 I/O buffers. */
     hoist_L2_io_buffer(kernel, group, gen, data);
   }
+  kernel->tile_memo = autosa_tile_memo_free(kernel->tile_memo);
   /* Compute data packing factors. */
   compute_io_group_data_pack(kernel, group, gen, -1);  
 
@@ -2721,6 +2773,157 @@ static void compute_group_tilings_drain(struct autosa_kernel *kernel)
 	}
 }
 
+/* Record the size of the box hull of the footprint "map" of one array 
+ * partition tile in "user", indexed by the array name.
+ */
+static isl_stat record_tile_footprint(__isl_take isl_map *map, void *user)
+{
+  std::map<std::string, double> *footprint = 
+    (std::map<std::string, double> *)user;
+  isl_fixed_box *box;
+  double size = 1;
+
+  if (!isl_map_has_tuple_name(map, isl_dim_out)) {
+    isl_map_free(map);
+    return isl_stat_ok;
+  }
+  std::string name(isl_map_get_tuple_name(map, isl_dim_out));
+  box = isl_map_get_range_simple_fixed_box_hull(map);
+  isl_map_free(map);
+  if (isl_fixed_box_is_valid(box)) {
+    isl_multi_val *box_size = isl_fixed_box_get_size(box);
+    for (int i = 0; i < isl_multi_val_size(box_size); i++) {
+      isl_val *v = isl_multi_val_get_val(box_size, i);
+      size *= isl_val_get_num_si(v);
+      isl_val_free(v);
+    }
+    isl_multi_val_free(box_size);
+  }
+  isl_fixed_box_free(box);
+  (*footprint)[name] = max((*footprint)[name], size);
+
+  return isl_stat_ok;
+}
+
+/* Split the HBM channels among the read-only arrays of "kernel" 
+ * in proportion to their off-chip traffic and store them in "n_port".
+ * All the array partition tiles are executed the same number of times,
+ * hence the traffic of each array is proportional to its footprint 
+ * in one tile, i.e., below the "array" mark.
+ * The written arrays use a single channel each. The remaining channels
+ * are given by "hbm_channels" in the hardware information file,
+ * or --hbm-port-num channels per read-only array by default.
+ */
+static void compute_hbm_channels_auto(struct autosa_kernel *kernel,
+  struct autosa_gen *gen, std::map<std::string, int> &n_port)
+{
+  cJSON *hw_info = sa_hw_info(gen->options->autosa);
+  std::map<std::string, double> footprint;
+  isl_schedule_node *node;
+  isl_union_map *sched, *access;
+  double total = 0;
+  int n_read_only = 0, n_written = 0;
+  int budget = -1;
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_array(node, kernel->core);
+  sched = prefix_with_equalities(node);
+  sched = expand(sched, kernel->contraction);
+  isl_schedule_node_free(node);
+  access = isl_union_map_union(isl_union_map_copy(kernel->prog->read),
+              isl_union_map_copy(kernel->prog->may_write));
+  access = isl_union_map_apply_domain(access, sched);
+  isl_union_map_foreach_map(access, &record_tile_footprint, &footprint);
+  isl_union_map_free(access);
+
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_array_info *array = kernel->array[i].array;
+    if (!autosa_array_is_read_only(array)) {
+      n_written++;
+      continue;
+    }
+    footprint[array->name] *= array->size;
+    total += footprint[array->name];
+    n_read_only++;
+  }
+
+  if (hw_info) {
+    cJSON *channels = cJSON_GetObjectItemCaseSensitive(hw_info, 
+                        "hbm_channels");
+    if (cJSON_IsNumber(channels))
+      budget = (int)channels->valuedouble - n_written;
+  }
+  if (budget < 0)
+    budget = gen->options->autosa->n_hbm_port * n_read_only;
+
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_array_info *array = kernel->array[i].array;
+    if (!autosa_array_is_read_only(array) || total <= 0)
+      continue;
+    n_port[array->name] = max(1, 
+      (int)(budget * footprint[array->name] / total));
+  }
+}
+
+/* Compute the number of HBM channels of each array of "kernel".
+ * The channels are given for each array by --hbm-channels, e.g., "A:4,B:2",
+ * or derived from the off-chip traffic of the arrays with "auto".
+ * By default, all the arrays use the "hbm" sizes of --sa-sizes, 
+ * or --hbm-port-num.
+ * Only the read-only arrays are split across several channels, 
+ * as each channel keeps its own copy of the array.
+ */
+static void compute_hbm_channels(struct autosa_kernel *kernel, 
+  struct autosa_gen *gen)
+{
+  const char *channels = gen->options->autosa->hbm_channels;
+  std::map<std::string, int> n_port;
+  int *default_port;
+
+  default_port = read_hbm_tile_sizes(kernel, 1);
+  if (channels && !strcmp(channels, "auto")) {
+    compute_hbm_channels_auto(kernel, gen, n_port);
+  } else if (channels) {
+    std::string str(channels);
+    size_t pos = 0;
+    while (pos < str.size()) {
+      size_t end = str.find(',', pos);
+      if (end == std::string::npos)
+        end = str.size();
+      std::string item = str.substr(pos, end - pos);
+      size_t colon = item.find(':');
+      if (colon == std::string::npos || 
+          atoi(item.c_str() + colon + 1) < 1) {
+        printf("[AutoSA] Error: Invalid HBM channels: %s\n", channels);
+        exit(1);
+      }
+      n_port[item.substr(0, colon)] = atoi(item.c_str() + colon + 1);
+      pos = end + 1;
+    }
+  }
+
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_local_array_info *local = &kernel->array[i];
+    const char *name = local->array->name;
+    int n;
+
+    if (channels)
+      n = n_port.count(name) ? n_port[name] : 1;
+    else
+      n = default_port ? default_port[0] : 1;
+    if (n > 1 && !autosa_array_is_read_only(local->array)) {
+      if (channels)
+        printf("[AutoSA] Warning: Array %s is written, "
+               "using a single HBM channel.\n", name);
+      n = 1;
+    }
+    local->n_hbm_port = n;
+    if (gen->options->autosa->verbose)
+      printf("[AutoSA] HBM channels of array %s: %d\n", name, n);
+  }
+  free(default_port);
+}
+
 /* Group references of all arrays in "kernel".
  * Each array is associated with three types of groups:
  * PE group: Assign the local buffers inside PEs.
@@ -2757,6 +2960,9 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
       isl_schedule_node_get_subtree_schedule_union_map(node));
   data.schedule = kernel->schedule;
 
+  if (gen->options->autosa->hbm)
+    compute_hbm_channels(kernel, gen);
+
   /* Create the default array reference groups (PPCG heritage). */
   for (int i = 0; i < kernel->n_array; i++) {
     r = group_array_references_default(kernel, &kernel->array[i], &data);
@@ -2850,6 +3056,242 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
   return isl_stat_ok;
 }
 
+/* Return the order in which the array partition tiles of "kernel" 
+ * read (if "read" is set) or write the elements of "array",
+ * or NULL if "array" is not accessed that way.
+ * The order maps each element to the array partition loops of 
+ * the first tile that reads it, or of the last tile that writes it.
+ */
+static __isl_give isl_map *array_stream_order(struct autosa_kernel *kernel,
+  struct autosa_array_info *array, __isl_keep isl_union_map *sched, int read)
+{
+  isl_union_map *access;
+  isl_union_set *elements;
+  isl_map *order;
+
+  access = isl_union_map_copy(read ? kernel->prog->read : 
+                                     kernel->prog->may_write);
+  elements = isl_union_set_from_set(
+                isl_set_universe(isl_space_copy(array->space)));
+  access = isl_union_map_intersect_range(access, elements);
+  access = isl_union_map_apply_domain(access, isl_union_map_copy(sched));
+  access = isl_union_map_reverse(access);
+  if (isl_union_map_is_empty(access)) {
+    isl_union_map_free(access);
+    return NULL;
+  }
+  order = isl_map_from_union_map(access);
+
+  return read ? isl_map_lexmin(order) : isl_map_lexmax(order);
+}
+
+/* Return the number of elements in the box hull of "set",
+ * or -1 if the box hull is not of fixed size.
+ */
+static long set_box_size(__isl_take isl_set *set)
+{
+  isl_map *map;
+  isl_fixed_box *box;
+  long size = -1;
+
+  map = isl_map_from_range(set);
+  box = isl_map_get_range_simple_fixed_box_hull(map);
+  isl_map_free(map);
+  if (isl_fixed_box_is_valid(box)) {
+    isl_multi_val *box_size = isl_fixed_box_get_size(box);
+    size = 1;
+    for (int i = 0; i < isl_multi_val_size(box_size); i++) {
+      isl_val *v = isl_multi_val_get_val(box_size, i);
+      size *= isl_val_get_num_si(v);
+      isl_val_free(v);
+    }
+    isl_multi_val_free(box_size);
+  }
+  isl_fixed_box_free(box);
+
+  return size;
+}
+
+/* Load the stream orders written by a producer design from "file". */
+static cJSON *load_stream_order(const char *file)
+{
+  char *buffer;
+  cJSON *orders;
+
+  buffer = ppcg_read_file(file);
+  if (!buffer) {
+    printf("[AutoSA] Error: Can't open the stream order file: %s\n", file);
+    exit(1);
+  }
+  orders = cJSON_Parse(buffer);
+  free(buffer);
+  if (!orders) {
+    printf("[AutoSA] Error: Can't parse the stream order file: %s\n", file);
+    exit(1);
+  }
+
+  return orders;
+}
+
+/* Print "json" to the file "path". */
+static void write_stream_json(const std::string &path, cJSON *json)
+{
+  char *json_str;
+  FILE *fp;
+
+  fp = fopen(path.c_str(), "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Cannot open file: %s\n", path.c_str());
+    exit(1);
+  }
+  json_str = cJSON_Print(json);
+  fprintf(fp, "%s", json_str);
+  fclose(fp);
+  free(json_str);
+}
+
+/* Check if the array "name" written by the producer in the order "write"
+ * is compatible with the order "read" in which "kernel" reads it.
+ * The array partition tiles of both designs are executed in sequence. 
+ * The array is produced in order if no element is read by the consumer 
+ * before an element that the producer writes in a later tile, i.e.,
+ * the drain modules of the producer could feed the L3 I/O modules of 
+ * the consumer through FIFOs if the consumer only reorders the elements 
+ * inside one tile, e.g., in the buffers of --AutoSA-burst-buffer.
+ * Otherwise, the size of the reorder buffer holding the produced elements
+ * is reported if its box hull is of fixed size.
+ * This is an analysis only, the designs are not connected.
+ */
+static cJSON *check_stream_chain(struct autosa_kernel *kernel, 
+  const char *name, const char *write, __isl_keep isl_map *read)
+{
+  cJSON *chain = cJSON_CreateObject();
+  isl_map *producer, *consumer;
+  isl_map *before, *after;
+  int in_order;
+
+  producer = isl_map_read_from_str(kernel->ctx, write);
+  if (!producer || isl_map_dim(producer, isl_dim_in) != 
+                   isl_map_dim(read, isl_dim_in)) {
+    printf("[AutoSA] Error: Invalid stream order of array %s: %s\n", 
+           name, write);
+    exit(1);
+  }
+  consumer = isl_map_copy(read);
+  producer = isl_map_align_params(producer, isl_map_get_space(consumer));
+  consumer = isl_map_align_params(consumer, isl_map_get_space(producer));
+  producer = isl_map_set_tuple_id(producer, isl_dim_in,
+                isl_map_get_tuple_id(consumer, isl_dim_in));
+  consumer = isl_map_intersect_domain(consumer, 
+                isl_map_domain(isl_map_copy(producer)));
+
+  /* Pairs of elements read in the order a before b, 
+   * but written in the order b before a. */
+  before = isl_map_lex_lt_map(isl_map_copy(consumer), isl_map_copy(consumer));
+  after = isl_map_lex_gt_map(isl_map_copy(producer), isl_map_copy(producer));
+  before = isl_map_intersect(before, after);
+  in_order = isl_map_is_empty(before) == isl_bool_true;
+  isl_map_free(before);
+
+  cJSON_AddBoolToObject(chain, "in_order", in_order);
+  if (in_order) {
+    printf("[AutoSA] Array %s: produced in the order of the reads\n", name);
+  } else {
+    long size = set_box_size(isl_map_domain(isl_map_copy(consumer)));
+    if (size >= 0) {
+      cJSON_AddNumberToObject(chain, "reorder_buffer_size", size);
+      printf("[AutoSA] Array %s: produced out of order, the reorder buffer "
+             "holds %ld elements\n", name, size);
+    } else {
+      printf("[AutoSA] Warning: Array %s: produced out of order, can't bound "
+             "the reorder buffer\n", name);
+    }
+  }
+
+  isl_map_free(producer);
+  isl_map_free(consumer);
+
+  return chain;
+}
+
+/* Write the stream orders of the arrays of "kernel" to 
+ * "<output_dir>/stream_order.json", if --AutoSA-stream-order is set.
+ * If --AutoSA-stream-from is set, check each array read by "kernel" 
+ * against the order in which the producer design writes it and 
+ * write the results to "<output_dir>/stream_chain.json".
+ * The check is the analysis step of streaming the arrays between 
+ * consecutive systolic arrays. The top module with several arrays, the 
+ * FIFOs between the drain modules and the L3 I/O modules and the reorder 
+ * buffers are not generated yet, "kernel" still reads its arrays from DRAM.
+ */
+isl_stat sa_stream_order(struct autosa_kernel *kernel, struct autosa_gen *gen)
+{
+  struct autosa_options *options = gen->options->autosa;
+  isl_schedule_node *node;
+  isl_union_map *sched;
+  cJSON *report, *producer, *produced, *chains;
+  std::string dir(options->output_dir);
+
+  if (!options->stream_order && !options->stream_from)
+    return isl_stat_ok;
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_array(node, kernel->core);
+  sched = prefix_with_equalities(node);
+  sched = expand(sched, kernel->contraction);
+  isl_schedule_node_free(node);
+
+  report = cJSON_CreateObject();
+  producer = options->stream_from ? 
+                load_stream_order(options->stream_from) : NULL;
+  produced = cJSON_GetObjectItemCaseSensitive(producer, "arrays");
+  chains = cJSON_CreateObject();
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_array_info *array = kernel->array[i].array;
+    cJSON *orders = cJSON_CreateObject();
+
+    for (int read = 1; read >= 0; read--) {
+      isl_map *order = array_stream_order(kernel, array, sched, read);
+      cJSON *write;
+      char *str;
+
+      if (!order)
+        continue;
+      str = isl_map_to_str(order);
+      cJSON_AddStringToObject(orders, read ? "read" : "write", str);
+      free(str);
+      write = cJSON_GetObjectItemCaseSensitive(
+                cJSON_GetObjectItemCaseSensitive(produced, array->name), 
+                "write");
+      if (read && cJSON_IsString(write))
+        cJSON_AddItemToObject(chains, array->name, 
+            check_stream_chain(kernel, array->name, write->valuestring, 
+                               order));
+      isl_map_free(order);
+    }
+    cJSON_AddItemToObject(report, array->name, orders);
+  }
+  isl_union_map_free(sched);
+  cJSON_Delete(producer);
+
+  if (options->stream_order) {
+    cJSON *file = cJSON_CreateObject();
+    cJSON_AddItemToObject(file, "arrays", report);
+    write_stream_json(dir + "/stream_order.json", file);
+    cJSON_Delete(file);
+  } else {
+    cJSON_Delete(report);
+  }
+  if (options->stream_from) {
+    write_stream_json(dir + "/stream_chain.json", chains);
+    printf("[AutoSA] Warning: The stream chain is only analyzed, the arrays "
+           "are still transferred through DRAM.\n");
+  }
+  cJSON_Delete(chains);
+
+  return isl_stat_ok;
+}
+
 /* Return the access relation associated with the comm pair of the array reference
  * "ref" in the current I/O group "group".
  * For each reference, if 
@@ -4,6 +4,7 @@
 #include "autosa_common.h"
 
 isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_gen *gen);
+isl_stat sa_stream_order(struct autosa_kernel *kernel, struct autosa_gen *gen);
 enum autosa_group_access_type autosa_array_ref_group_type(
 	struct autosa_array_ref_group *group);
 enum autosa_group_access_type autosa_cpu_array_ref_group_type(
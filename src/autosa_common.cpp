@@ -118,6 +118,7 @@ struct autosa_kernel *autosa_kernel_copy(struct autosa_kernel *kernel)
   kernel_dup->host_domain = isl_set_copy(kernel->host_domain);
   kernel_dup->domain = isl_union_set_copy(kernel->domain);
   kernel_dup->single_statement = kernel->single_statement;
+  kernel_dup->tile_memo = NULL;
 
   return kernel_dup;
 }
@@ -165,6 +166,7 @@ struct autosa_kernel *autosa_kernel_from_schedule(__isl_take isl_schedule *sched
   kernel->host_domain = NULL;
   kernel->domain = NULL;
   kernel->single_statement = 0;
+  kernel->tile_memo = NULL;
 
   return kernel;
 }
@@ -219,6 +221,7 @@ struct autosa_kernel *autosa_kernel_alloc(isl_ctx *ctx, struct ppcg_scop *scop)
   kernel->host_domain = NULL;
   kernel->domain = NULL;
   kernel->single_statement = 0;
+  kernel->tile_memo = NULL;
 
   return kernel;
 }
@@ -452,6 +455,7 @@ static void free_array_info(struct autosa_prog *prog)
 		isl_ast_expr_free(prog->array[i].declared_size);
 		free(prog->array[i].refs);
 		isl_union_map_free(prog->array[i].dep_order);
+		free(prog->array[i].hbm_banks);
 	}
 	free(prog->array);
 }
@@ -813,6 +817,16 @@ int autosa_array_is_read_only_scalar(struct autosa_array_info *array)
 	return array->read_only_scalar;
 }
 
+/* Is "array" never written?
+ */
+int autosa_array_is_read_only(struct autosa_array_info *array)
+{
+  for (int i = 0; i < array->n_ref; i++)
+    if (array->refs[i]->write)
+      return 0;
+  return 1;
+}
+
 /* Check if a autosa array is a scalar.  A scalar is a value that is not stored
  * as an array or through a pointer reference, but as a single data element.
  * At the moment, scalars are represented as zero-dimensional arrays.
@@ -900,6 +914,7 @@ struct autosa_array_ref_group *autosa_array_ref_group_init(
   group->io_L1_schedule = NULL;
   group->io_level = 0;
   group->space_dim = 0;
+  group->n_hbm_port = 0;
   group->n_lane = 0;
   group->copy_schedule_dim = 0;
   group->copy_schedule = NULL;
@@ -953,6 +968,33 @@ struct autosa_array_tile *autosa_array_tile_create(isl_ctx *ctx, int n_index)
 	return tile;
 }
 
+/* Return a copy of "tile", or NULL if "tile" is NULL.
+ */
+struct autosa_array_tile *autosa_array_tile_dup(struct autosa_array_tile *tile)
+{
+	int i;
+	struct autosa_array_tile *dup;
+
+	if (!tile)
+		return NULL;
+
+	dup = autosa_array_tile_create(tile->ctx, tile->n);
+	if (!dup)
+		return NULL;
+
+	dup->requires_unroll = tile->requires_unroll;
+	dup->depth = tile->depth;
+	for (i = 0; i < tile->n; ++i) {
+		dup->bound[i].size = isl_val_copy(tile->bound[i].size);
+		dup->bound[i].lb = isl_aff_copy(tile->bound[i].lb);
+		dup->bound[i].stride = isl_val_copy(tile->bound[i].stride);
+		dup->bound[i].shift = isl_aff_copy(tile->bound[i].shift);
+	}
+	dup->tiling = isl_multi_aff_copy(tile->tiling);
+
+	return dup;
+}
+
 /* Compute the size of the tile specified by "tile"
  * in number of elements and return the result.
  */
@@ -1713,20 +1755,36 @@ error:
   return isl_stat_error;
 }
 
-/* Add the map { kernel[id] -> type[sizes] } to gen->used-sizes 
- * if the option debug->dump_sa_sizes is set.
+/* Add the map { kernel[id] -> type[sizes] } to sa->used_sizes.
  */
-static void set_sa_used_sizes(struct autosa_kernel *sa, const char *type, int id,
+void set_sa_used_sizes(struct autosa_kernel *sa, const char *type, int id,
     int *sizes, int len)
 {
-  // TODO: fix it
+  isl_space *space;
+  isl_map *map;
+
+  if (!sa->used_sizes)
+    sa->used_sizes = isl_union_map_empty(isl_space_params_alloc(sa->ctx, 0));
+
+  space = isl_union_map_get_space(sa->used_sizes);
+  space = isl_space_set_from_params(space);
+  space = isl_space_add_dims(space, isl_dim_set, 1);
+  space = isl_space_set_tuple_name(space, isl_dim_set, "kernel");
+  space = isl_space_from_domain(space);
+  space = isl_space_add_dims(space, isl_dim_out, len);
+  space = isl_space_set_tuple_name(space, isl_dim_out, type);
+
+  map = isl_map_universe(space);
+  map = isl_map_fix_si(map, isl_dim_in, 0, id);
+  for (int i = 0; i < len; ++i)
+    map = isl_map_fix_si(map, isl_dim_out, i, sizes[i]);
+
+  sa->used_sizes = isl_union_map_add_map(sa->used_sizes, map);
 }
 
-/* Extract user specified "sa_tile" sizes from the "sa_sizes" command line options,
- * defaulting to option->sa_tile_size in each dimension.
- * *tile_len contains the maximum number of tile sizes needed.
- * Update *tile_len to the number of specified tile sizes, if any, and
- * return a pointer to the tile sizes (or NULL on error).
+/* Extract user specified "hbm" port numbers from the "sa_sizes" command line 
+ * options, defaulting to option->n_hbm_port.
+ * Return a pointer to the port numbers (or NULL on error).
  * And the effectively used sizes to sa->used_sizes.
  */
 int *read_hbm_tile_sizes(struct autosa_kernel *sa, int tile_len)
@@ -1795,6 +1853,7 @@ int *read_default_array_part_tile_sizes(struct autosa_kernel *sa, int tile_len)
     return NULL;
   for (n = 0; n < tile_len; ++n)
     tile_size[n] = sa->scop->options->autosa->sa_tile_size;
+  set_sa_used_sizes(sa, "array_part", sa->id, tile_size, tile_len);
 
   return tile_size;
 }
@@ -1842,6 +1901,7 @@ int *read_default_latency_tile_sizes(struct autosa_kernel *sa, int tile_len)
     return NULL;
   for (n = 0; n < tile_len; ++n)
     tile_size[n] = sa->scop->options->autosa->sa_tile_size / 2;
+  set_sa_used_sizes(sa, "latency", sa->id, tile_size, tile_len);
 
   return tile_size;
 }
@@ -1882,6 +1942,7 @@ int *read_default_simd_tile_sizes(struct autosa_kernel *sa, int tile_len)
     return NULL;
   for (n = 0; n < tile_len; ++n) 
     tile_size[n] = sa->scop->options->autosa->sa_tile_size / 2;
+  set_sa_used_sizes(sa, "simd", sa->id, tile_size, tile_len);
 
   return tile_size;
 }
@@ -1939,6 +2000,7 @@ int *read_default_array_part_L2_tile_sizes(struct autosa_kernel *sa, int tile_le
     return NULL;
   for (n = 0; n < tile_len; ++n)
     tile_size[n] = sa->scop->options->autosa->sa_tile_size;
+  set_sa_used_sizes(sa, "array_part_L2", sa->id, tile_size, tile_len);
 
   return tile_size;
 }
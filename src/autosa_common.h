@@ -48,6 +48,11 @@ extern "C" {
 #define min(a, b)  (((a) < (b)) ? (a) : (b))
 #define max(a, b)  (((a) > (b)) ? (a) : (b))
 
+/* Default depth of the FIFOs between the modules */
+#define AUTOSA_FIFO_DEPTH 2
+/* Maximal depth of the FIFOs implemented with shift registers */
+#define AUTOSA_FIFO_SRL_DEPTH 32
+
 enum autosa_group_access_type {
   AUTOSA_ACCESS_GLOBAL,
   AUTOSA_ACCESS_LOCAL,
@@ -270,6 +275,10 @@ struct autosa_kernel {
 
   isl_set *host_domain;
   int single_statement;
+
+  /* Memoized local tiles of the array reference groups, only set during
+   * the I/O optimization of a group. */
+  struct autosa_tile_memo *tile_memo;
 };
 
 struct autosa_io_info {
@@ -411,6 +420,13 @@ struct autosa_array_info {
 
   /* AutoSA Extended */
   int n_lane;
+  /* Number of pointers of the array in the kernel. */
+  int n_io_group_refs;
+  /* HBM channel of each pointer, NULL if HBM is not used. */
+  int *hbm_banks;
+  /* Number of device buffers. Read-only arrays keep a copy in the channel 
+   * of each pointer, the other arrays use a single buffer. */
+  int n_buffer;
   /* AutoSA Extended */
 };
 
@@ -495,6 +511,9 @@ struct autosa_array_ref_group {
   int io_level;
   /* Dims of space band */
   int space_dim;
+  /* Number of HBM channels the L3 I/O modules are split across, 
+   * 0 if they are not split. */
+  int n_hbm_port;
   /* Data pack factor inside PEs */
   int n_lane;
   /* Copy schedule for PE group */
@@ -541,6 +560,8 @@ struct autosa_local_array_info {
    * allocate separater pointers for each group. 
    */
   int n_io_group_refs;
+  /* Number of HBM channels to split the L3 I/O modules of each I/O group */
+  int n_hbm_port;
 
   /* Default groups */
   int n_group;
@@ -721,6 +742,10 @@ struct autosa_gen {
     struct autosa_types *types, void *user);
   void *print_user;
 
+  /* Callback for redirecting the output files to a new output directory 
+   * in the sweep mode. A NULL output directory discards the output files. */
+  void (*redirect)(void *user, const char *output_dir);
+
   struct autosa_prog *prog;  
   struct autosa_kernel *kernel;
   /* The default AST */
@@ -832,6 +857,13 @@ struct autosa_kernel_stmt {
       int upper;
       int lower;
       char *module_name;
+      /* Depth of the declared FIFOs, 0 for the default depth */
+      int fifo_depth;
+      /* If non-negative, only the FIFOs at the ends of the module chains, 
+       * i.e., the boundary FIFOs and the FIFOs with the instance ids from 
+       * "fifo_chain_dim" on being zero, take "fifo_depth", the FIFOs inside 
+       * the chains keep the default depth */
+      int fifo_chain_dim;
     } m;
     struct {
       struct autosa_hw_module *module;
@@ -919,6 +951,7 @@ struct hls_info {
   enum platform target;
   int hls;               /* Generate HLS host instead of OpenCL host */
   char *output_dir;      /* Output directory */
+  const char *input;     /* Input file */
   isl_ctx *ctx;
 };
 
@@ -989,6 +1022,7 @@ struct autosa_iter *autosa_iter_free(struct autosa_iter *iter);
 /* AutoSA array */
 isl_stat collect_array_info(struct autosa_prog *prog);
 int autosa_array_is_read_only_scalar(struct autosa_array_info *array);
+int autosa_array_is_read_only(struct autosa_array_info *array);
 int autosa_array_is_scalar(struct autosa_array_info *array);
 int autosa_kernel_requires_array_argument(struct autosa_kernel *kernel, int i);
 struct autosa_array_ref_group *autosa_array_ref_group_free(
@@ -997,6 +1031,7 @@ struct autosa_array_ref_group *autosa_array_ref_group_init(
   struct autosa_array_ref_group *group);
 struct autosa_array_tile *autosa_array_tile_free(struct autosa_array_tile *tile);
 struct autosa_array_tile *autosa_array_tile_create(isl_ctx *ctx, int n_index);
+struct autosa_array_tile *autosa_array_tile_dup(struct autosa_array_tile *tile);
 __isl_give isl_val *autosa_array_tile_size(struct autosa_array_tile *tile);  
 
 /* AutoSA statement */
@@ -1033,6 +1068,8 @@ int *read_default_simd_tile_sizes(struct autosa_kernel *kernel, int tile_len);
 int read_space_time_kernel_id(__isl_keep isl_union_map *sizes);
 int *read_array_part_L2_tile_sizes(struct autosa_kernel *kernel, int tile_len);
 int *read_default_array_part_L2_tile_sizes(struct autosa_kernel *kernel, int tile_len);
+void set_sa_used_sizes(struct autosa_kernel *sa, const char *type, int id,
+    int *sizes, int len);
 
 /* AutoSA latency and resource estimation */
 isl_stat sa_extract_loop_info(struct autosa_gen *gen, struct autosa_hw_module *module); 
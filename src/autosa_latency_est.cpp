@@ -0,0 +1,1262 @@
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <isl/ctx.h>
+
+#include "autosa_latency_est.h"
+#include "autosa_print.h"
+#include "autosa_resource_est.h"
+#include "autosa_utils.h"
+
+/* Latency of a node in the loop structure extracted by sa_extract_loop_info.
+ * If "pipelined" is set, the node is a (flattened) pipelined loop nest
+ * with "iters" iterations, each of which takes "depth" cycles to complete.
+ * Otherwise, the node takes "depth" cycles.
+ */
+struct sa_lat {
+  bool pipelined;
+  long iters;
+  long depth;
+};
+
+/* Internal data structure for estimating the latency of the modules.
+ * "dir" is the directory containing the loop info files.
+ * "base" is the name of the hardware module currently being estimated,
+ * used to locate the inter_trans and intra_trans modules it calls.
+ * "env" maps the loop iterators to their current values.
+ * "max_depth" is the largest pipeline depth found in the current module.
+ * "sub_cycles" caches the latency of the inter_trans and intra_trans modules.
+ * "fifo", if not empty, restricts the FIFO accesses of the PEs counted by
+ * count_fifo_accesses to the statements of the FIFO, e.g., "in.fifo_A".
+ */
+struct sa_latency_est_data {
+  std::string dir;
+  std::string base;
+  std::map<std::string, long> env;
+  long max_depth;
+  std::map<std::string, long> sub_cycles;
+  std::string fifo;
+};
+
+/* All loops are assumed to be pipelined with II = 1.
+ * The latency hiding and I/O data packing optimizations
+ * of AutoSA are designed to achieve this.
+ */
+#define SA_LAT_II 1
+
+static struct sa_lat sa_lat_seq(long depth)
+{
+  struct sa_lat lat = { false, 0, depth };
+  return lat;
+}
+
+static long sa_lat_cycles(struct sa_lat lat)
+{
+  if (!lat.pipelined)
+    return lat.depth;
+  if (lat.iters <= 0)
+    return 0;
+  return (lat.iters - 1) * SA_LAT_II + lat.depth;
+}
+
+/* Load the JSON file "path".
+ * Return NULL if the file doesn't exist.
+ */
+static cJSON *load_json(const std::string &path)
+{
+  char *buffer;
+  cJSON *info;
+
+  buffer = ppcg_read_file(path.c_str());
+  if (!buffer)
+    return NULL;
+  info = cJSON_Parse(buffer);
+  free(buffer);
+
+  return info;
+}
+
+/* Load the loop info of the module "name".
+ * Return NULL if the file doesn't exist.
+ */
+static cJSON *load_loop_info(struct sa_latency_est_data *data,
+  const std::string &name)
+{
+  return load_json(data->dir + "/" + name + "_loop_info.json");
+}
+
+/* Bind the identifiers in "s" that have no value yet to zero.
+ * These are the module indices, e.g., "idx" or "p0", which are not
+ * known from the loop structure. Function names are skipped.
+ */
+static void bind_free_ids(const char *s, std::map<std::string, long> &env)
+{
+  size_t pos = 0;
+
+  while (s[pos]) {
+    if (isalpha(s[pos]) || s[pos] == '_') {
+      std::string name;
+      size_t next;
+      while (isalnum(s[pos]) || s[pos] == '_')
+        name += s[pos++];
+      next = pos;
+      while (isspace(s[next]))
+        next++;
+      if (s[next] != '(' && env.find(name) == env.end())
+        env[name] = 0;
+    } else if (isdigit(s[pos])) {
+      while (isalnum(s[pos]))
+        pos++;
+    } else {
+      pos++;
+    }
+  }
+}
+
+static long eval_loop_expr(struct sa_latency_est_data *data, const char *s)
+{
+  bool error = false;
+  long v;
+
+  bind_free_ids(s, data->env);
+  v = autosa_eval_c_expr(s, data->env, &error);
+  if (error) {
+    printf("[AutoSA] Warning: Cannot evaluate loop bound: %s\n", s);
+    return 0;
+  }
+  return v;
+}
+
+static struct sa_lat estimate_node(struct sa_latency_est_data *data,
+  const cJSON *node);
+static long estimate_sub_module(struct sa_latency_est_data *data,
+  const std::string &name);
+
+/* Return the name of the mark if "node" is a mark node.
+ */
+static const char *node_mark_name(const cJSON *node)
+{
+  const cJSON *mark = cJSON_GetObjectItemCaseSensitive(node, "mark");
+  const cJSON *name;
+
+  if (!mark)
+    return NULL;
+  name = cJSON_GetObjectItemCaseSensitive(mark, "mark_name");
+  return cJSON_IsString(name) ? name->valuestring : NULL;
+}
+
+/* Estimate the latency of the for loop "loop".
+ * The iterator is set to the middle of its range when visiting the loop body
+ * such that the trip counts of the inner loops that depend on it
+ * are averaged over the iterations.
+ * A loop with an "hls_pipeline" mark directly below it is pipelined,
+ * and the enclosing loops of a perfect loop nest are flattened into
+ * the pipeline as HLS does.
+ * A loop with an "hls_unroll" mark directly below it is fully unrolled,
+ * and its iterations run in parallel.
+ * All the other loops execute their iterations sequentially,
+ * with one extra cycle per iteration for the loop control.
+ */
+static struct sa_lat estimate_loop(struct sa_latency_est_data *data,
+  const cJSON *loop)
+{
+  const cJSON *info = cJSON_GetObjectItemCaseSensitive(loop, "loop_info");
+  const cJSON *child = cJSON_GetObjectItemCaseSensitive(loop, "child");
+  const cJSON *iter = cJSON_GetObjectItemCaseSensitive(info, "iter");
+  const cJSON *lb = cJSON_GetObjectItemCaseSensitive(info, "lb");
+  const cJSON *ub = cJSON_GetObjectItemCaseSensitive(info, "ub");
+  const cJSON *stride = cJSON_GetObjectItemCaseSensitive(info, "stride");
+  const char *mark_name;
+  struct sa_lat lat, body;
+  long lb_v, ub_v, stride_v, trip;
+  std::string name;
+  bool shadowed;
+  long saved = 0;
+
+  if (!cJSON_IsString(iter) || !cJSON_IsString(lb) || !cJSON_IsString(ub) ||
+      !cJSON_IsString(stride))
+    return sa_lat_seq(0);
+
+  lb_v = eval_loop_expr(data, lb->valuestring);
+  ub_v = eval_loop_expr(data, ub->valuestring);
+  stride_v = eval_loop_expr(data, stride->valuestring);
+  if (stride_v < 1)
+    stride_v = 1;
+  trip = ub_v >= lb_v ? (ub_v - lb_v) / stride_v + 1 : 0;
+
+  name = iter->valuestring;
+  shadowed = data->env.find(name) != data->env.end();
+  if (shadowed)
+    saved = data->env[name];
+  data->env[name] = lb_v + (trip > 0 ? (trip - 1) / 2 : 0) * stride_v;
+
+  mark_name = node_mark_name(child);
+  if (mark_name && !strcmp(mark_name, "hls_pipeline")) {
+    const cJSON *mark = cJSON_GetObjectItemCaseSensitive(child, "mark");
+    body = estimate_node(data, cJSON_GetObjectItemCaseSensitive(mark, "child"));
+    lat.pipelined = true;
+    lat.iters = trip;
+    lat.depth = sa_lat_cycles(body);
+    data->max_depth = max(data->max_depth, lat.depth);
+  } else if (mark_name && !strcmp(mark_name, "hls_unroll")) {
+    const cJSON *mark = cJSON_GetObjectItemCaseSensitive(child, "mark");
+    body = estimate_node(data, cJSON_GetObjectItemCaseSensitive(mark, "child"));
+    lat = sa_lat_seq(sa_lat_cycles(body));
+  } else {
+    body = estimate_node(data, child);
+    if (body.pipelined) {
+      lat = body;
+      lat.iters *= trip;
+    } else {
+      lat = sa_lat_seq(trip * (body.depth + 1));
+    }
+  }
+
+  if (shadowed)
+    data->env[name] = saved;
+  else
+    data->env.erase(name);
+
+  return lat;
+}
+
+/* Estimate the latency of the user statement "user".
+ * The I/O modules with local buffers call their inter_trans and
+ * intra_trans modules, whose latency is estimated from their own loop info.
+ * With double buffering, "io_module.inter_intra" and "io_module.intra_inter"
+ * run both modules concurrently.
+ * All the other statements take a single cycle.
+ */
+static struct sa_lat estimate_user(struct sa_latency_est_data *data,
+  const cJSON *user)
+{
+  const cJSON *expr = cJSON_GetObjectItemCaseSensitive(user, "user_expr");
+  const char *s;
+  std::string inter, intra;
+
+  if (!cJSON_IsString(expr))
+    return sa_lat_seq(1);
+  s = expr->valuestring;
+  if (strncmp(s, "io_module.", strlen("io_module.")))
+    return sa_lat_seq(1);
+
+  inter = data->base + "_inter_trans";
+  if (strstr(s, ".boundary"))
+    inter += "_boundary";
+  intra = data->base + "_intra_trans";
+
+  if (!strncmp(s, "io_module.inter_trans", strlen("io_module.inter_trans")))
+    return sa_lat_seq(estimate_sub_module(data, inter));
+  if (!strncmp(s, "io_module.intra_trans", strlen("io_module.intra_trans")))
+    return sa_lat_seq(estimate_sub_module(data, intra));
+  if (!strncmp(s, "io_module.inter_intra", strlen("io_module.inter_intra")) ||
+      !strncmp(s, "io_module.intra_inter", strlen("io_module.intra_inter"))) {
+    long inter_cycles = estimate_sub_module(data, inter);
+    long intra_cycles = estimate_sub_module(data, intra);
+    return sa_lat_seq(max(inter_cycles, intra_cycles));
+  }
+
+  return sa_lat_seq(1);
+}
+
+/* Estimate the latency of "node" in the loop structure.
+ * The children of a block execute sequentially and
+ * an if node takes the latency of its longer branch.
+ */
+static struct sa_lat estimate_node(struct sa_latency_est_data *data,
+  const cJSON *node)
+{
+  const cJSON *item;
+
+  if (!node)
+    return sa_lat_seq(0);
+
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "loop")))
+    return estimate_loop(data, item);
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "mark")))
+    return estimate_node(data, cJSON_GetObjectItemCaseSensitive(item, "child"));
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "user")))
+    return estimate_user(data, item);
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "block"))) {
+    const cJSON *child;
+    long cycles = 0;
+
+    cJSON_ArrayForEach(child, cJSON_GetObjectItemCaseSensitive(item, "child"))
+      cycles += sa_lat_cycles(estimate_node(data, child));
+    return sa_lat_seq(cycles);
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "if"))) {
+    long then_cycles, else_cycles;
+
+    then_cycles = sa_lat_cycles(estimate_node(data,
+                    cJSON_GetObjectItemCaseSensitive(item, "then")));
+    else_cycles = sa_lat_cycles(estimate_node(data,
+                    cJSON_GetObjectItemCaseSensitive(item, "else")));
+    return sa_lat_seq(max(then_cycles, else_cycles));
+  }
+
+  return sa_lat_seq(0);
+}
+
+/* Estimate the latency of the module "name" from its loop info.
+ * Return -1 if the loop info is not found.
+ */
+static long estimate_module(struct sa_latency_est_data *data,
+  const std::string &name)
+{
+  cJSON *info;
+  long cycles;
+
+  info = load_loop_info(data, name);
+  if (!info) {
+    printf("[AutoSA] Warning: Cannot find the loop info of module: %s\n",
+           name.c_str());
+    return -1;
+  }
+  cycles = sa_lat_cycles(estimate_node(data, info));
+  cJSON_Delete(info);
+
+  return cycles;
+}
+
+/* Estimate the latency of the inter_trans or intra_trans module "name".
+ * The loop iterators of the calling module are not visible inside.
+ */
+static long estimate_sub_module(struct sa_latency_est_data *data,
+  const std::string &name)
+{
+  std::map<std::string, long> env;
+  long cycles;
+
+  if (data->sub_cycles.find(name) != data->sub_cycles.end())
+    return data->sub_cycles[name];
+
+  env.swap(data->env);
+  cycles = estimate_module(data, name);
+  env.swap(data->env);
+  if (cycles < 0)
+    cycles = 1;
+  data->sub_cycles[name] = cycles;
+
+  return cycles;
+}
+
+/* Estimate the latency of the top-level module "name", which is
+ * generated from the hardware module "base", and add the result to "modules".
+ * Update "steady" and "fill" with the latency and the pipeline depth
+ * of the module.
+ */
+static void estimate_array_module(struct sa_latency_est_data *data,
+  const char *base, const std::string &name, cJSON *modules,
+  long *steady, long *fill)
+{
+  cJSON *module;
+  long cycles;
+
+  data->base = base;
+  data->env.clear();
+  data->max_depth = 0;
+  cycles = estimate_module(data, name);
+  if (cycles < 0)
+    return;
+
+  module = cJSON_CreateObject();
+  cJSON_AddNumberToObject(module, "latency", cycles);
+  cJSON_AddNumberToObject(module, "pipeline_depth", data->max_depth);
+  cJSON_AddItemToObject(modules, name.c_str(), module);
+
+  *steady = max(*steady, cycles);
+  *fill += data->max_depth;
+}
+
+/* Return the number of executions of the user statements below "node",
+ * each weighted by "count_user". As in estimate_loop, the iterators are
+ * set to the middle of their ranges and an if node takes its larger branch.
+ */
+static double count_node(struct sa_latency_est_data *data, const cJSON *node,
+  double (*count_user)(struct sa_latency_est_data *data, const char *expr))
+{
+  const cJSON *item;
+
+  if (!node)
+    return 0;
+
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "loop"))) {
+    const cJSON *info = cJSON_GetObjectItemCaseSensitive(item, "loop_info");
+    const cJSON *iter = cJSON_GetObjectItemCaseSensitive(info, "iter");
+    const cJSON *lb = cJSON_GetObjectItemCaseSensitive(info, "lb");
+    const cJSON *ub = cJSON_GetObjectItemCaseSensitive(info, "ub");
+    const cJSON *stride = cJSON_GetObjectItemCaseSensitive(info, "stride");
+    long lb_v, ub_v, stride_v, trip, saved = 0;
+    std::string name;
+    bool shadowed;
+    double count;
+
+    if (!cJSON_IsString(iter) || !cJSON_IsString(lb) || 
+        !cJSON_IsString(ub) || !cJSON_IsString(stride))
+      return 0;
+    lb_v = eval_loop_expr(data, lb->valuestring);
+    ub_v = eval_loop_expr(data, ub->valuestring);
+    stride_v = eval_loop_expr(data, stride->valuestring);
+    if (stride_v < 1)
+      stride_v = 1;
+    trip = ub_v >= lb_v ? (ub_v - lb_v) / stride_v + 1 : 0;
+
+    name = iter->valuestring;
+    shadowed = data->env.find(name) != data->env.end();
+    if (shadowed)
+      saved = data->env[name];
+    data->env[name] = lb_v + (trip > 0 ? (trip - 1) / 2 : 0) * stride_v;
+    count = trip * count_node(data, 
+              cJSON_GetObjectItemCaseSensitive(item, "child"), count_user);
+    if (shadowed)
+      data->env[name] = saved;
+    else
+      data->env.erase(name);
+    return count;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "mark")))
+    return count_node(data, cJSON_GetObjectItemCaseSensitive(item, "child"),
+                      count_user);
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "user"))) {
+    const cJSON *expr = cJSON_GetObjectItemCaseSensitive(item, "user_expr");
+    return cJSON_IsString(expr) ? count_user(data, expr->valuestring) : 0;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "block"))) {
+    const cJSON *child;
+    double count = 0;
+
+    cJSON_ArrayForEach(child, cJSON_GetObjectItemCaseSensitive(item, "child"))
+      count += count_node(data, child, count_user);
+    return count;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "if"))) {
+    double then_count = count_node(data, 
+                          cJSON_GetObjectItemCaseSensitive(item, "then"), 
+                          count_user);
+    double else_count = count_node(data, 
+                          cJSON_GetObjectItemCaseSensitive(item, "else"), 
+                          count_user);
+    return max(then_count, else_count);
+  }
+
+  return 0;
+}
+
+/* Return the number of executions of the user statements in the module
+ * "name", each weighted by "count_user".
+ * The loop iterators of the calling module are not visible inside.
+ */
+static double count_module(struct sa_latency_est_data *data,
+  const std::string &name,
+  double (*count_user)(struct sa_latency_est_data *data, const char *expr))
+{
+  std::map<std::string, long> env;
+  cJSON *info;
+  double count;
+
+  info = load_loop_info(data, name);
+  if (!info) {
+    printf("[AutoSA] Warning: Cannot find the loop info of module: %s\n",
+           name.c_str());
+    return 0;
+  }
+  env.swap(data->env);
+  count = count_node(data, info, count_user);
+  env.swap(data->env);
+  cJSON_Delete(info);
+
+  return count;
+}
+
+/* Return the number of array elements moved by the I/O statement "expr"
+ * between the DRAM and the array. The statement name is in the format of
+ * in/out_trans_dram.[fifo_name].[is_filter].[is_buffer].[sched_depth].[param_id].[pack_lane]
+ * The transfers of the I/O modules with local buffers are in their
+ * inter_trans modules.
+ */
+static double count_dram_elements(struct sa_latency_est_data *data, 
+  const char *expr)
+{
+  if (!strncmp(expr, "in_trans_dram", strlen("in_trans_dram")) ||
+      !strncmp(expr, "out_trans_dram", strlen("out_trans_dram"))) {
+    const char *pos = expr;
+    long n_lane;
+
+    for (int n_dot = 0; n_dot < 6 && pos; n_dot++) {
+      pos = strchr(pos, '.');
+      if (pos)
+        pos++;
+    }
+    n_lane = pos ? atol(pos) : 1;
+    return max(n_lane, 1L);
+  }
+  if (!strncmp(expr, "io_module.inter_trans", strlen("io_module.inter_trans")) ||
+      !strncmp(expr, "io_module.inter_intra", strlen("io_module.inter_intra")) ||
+      !strncmp(expr, "io_module.intra_inter", strlen("io_module.intra_inter"))) {
+    std::string inter = data->base + "_inter_trans";
+    if (strstr(expr, ".boundary"))
+      inter += "_boundary";
+    return count_module(data, inter, &count_dram_elements);
+  }
+
+  return 0;
+}
+
+/* Return one for the compute statements of the PEs, i.e., all the 
+ * statements other than the I/O statements "in.*", "out.*", "in_*" and
+ * "out_*".
+ */
+static double count_compute_stmts(struct sa_latency_est_data *data, 
+  const char *expr)
+{
+  if (!strncmp(expr, "in.", 3) || !strncmp(expr, "in_", 3) ||
+      !strncmp(expr, "out.", 4) || !strncmp(expr, "out_", 4))
+    return 0;
+  return 1;
+}
+
+/* Build the off-chip traffic and roofline report of the systolic array.
+ * The DRAM traffic of each array is counted from the loop info of 
+ * the I/O and drain modules connected to the DRAM, and the operations from 
+ * the compute statements of the PE module times the number of PEs.
+ * The arithmetic intensity is the number of operations per DRAM byte.
+ * If the hardware information file declares the "frequency" (MHz) and 
+ * the DRAM "bandwidth" (GB/s), the compute roof, i.e., 
+ * #PE x SIMD x frequency, is compared with the memory roof, i.e., 
+ * bandwidth x arithmetic intensity, to classify the design as compute- or 
+ * memory-bound. The throughput and the bandwidth at the estimated 
+ * "latency" are reported as well.
+ */
+static cJSON *estimate_roofline(struct sa_latency_est_data *data,
+  struct autosa_gen *gen, long latency)
+{
+  struct autosa_kernel *kernel = gen->kernel;
+  cJSON *hw_info = sa_hw_info(gen->options->autosa);
+  std::map<std::string, std::pair<double, double> > array_bytes;
+  cJSON *report, *arrays;
+  double ops = 0, bytes = 0, intensity = 0;
+  long n_pe = 1;
+
+  for (int i = 0; i < kernel->n_sa_dim; i++)
+    n_pe *= kernel->sa_dim[i];
+
+  for (int i = 0; i < gen->n_hw_modules; i++) {
+    struct autosa_hw_module *module = gen->hw_modules[i];
+
+    data->base = module->name;
+    if (module->type == PE_MODULE) {
+      ops += n_pe * count_module(data, module->name, &count_compute_stmts);
+    } else if (module->to_mem && module->n_io_group > 0) {
+      struct autosa_array_info *array = module->io_groups[0]->array;
+      double module_bytes = array->size * 
+        count_module(data, module->name, &count_dram_elements);
+
+      if (module->in)
+        array_bytes[array->name].first += module_bytes;
+      else
+        array_bytes[array->name].second += module_bytes;
+      bytes += module_bytes;
+    }
+  }
+
+  report = cJSON_CreateObject();
+  arrays = cJSON_CreateObject();
+  for (auto &it : array_bytes) {
+    cJSON *array_json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(array_json, "read", it.second.first);
+    cJSON_AddNumberToObject(array_json, "write", it.second.second);
+    cJSON_AddItemToObject(arrays, it.first.c_str(), array_json);
+  }
+  cJSON_AddItemToObject(report, "arrays", arrays);
+  cJSON_AddNumberToObject(report, "bytes", bytes);
+  cJSON_AddNumberToObject(report, "ops", ops);
+  if (bytes > 0) {
+    intensity = ops / bytes;
+    cJSON_AddNumberToObject(report, "intensity", intensity);
+  }
+  cJSON_AddNumberToObject(report, "n_pe", n_pe);
+  cJSON_AddNumberToObject(report, "simd", kernel->simd_w);
+  printf("[AutoSA] Estimated off-chip traffic: %.0f bytes\n", bytes);
+
+  if (hw_info) {
+    cJSON *freq = cJSON_GetObjectItemCaseSensitive(hw_info, "frequency");
+    cJSON *bw = cJSON_GetObjectItemCaseSensitive(hw_info, "bandwidth");
+
+    if (cJSON_IsNumber(freq) && freq->valuedouble > 0) {
+      /* Throughput in GOPS and bandwidth in GB/s */
+      double compute_roof = n_pe * kernel->simd_w * freq->valuedouble / 1e3;
+
+      cJSON_AddNumberToObject(report, "frequency", freq->valuedouble);
+      cJSON_AddNumberToObject(report, "compute_roof", compute_roof);
+      if (latency > 0) {
+        cJSON_AddNumberToObject(report, "throughput", 
+          ops * freq->valuedouble / latency / 1e3);
+        cJSON_AddNumberToObject(report, "required_bandwidth", 
+          bytes * freq->valuedouble / latency / 1e3);
+      }
+      if (cJSON_IsNumber(bw) && bw->valuedouble > 0) {
+        const char *bound = "compute";
+        double memory_roof = bytes > 0 ? bw->valuedouble * intensity : -1;
+
+        cJSON_AddNumberToObject(report, "bandwidth", bw->valuedouble);
+        if (bytes > 0) {
+          cJSON_AddNumberToObject(report, "memory_roof", memory_roof);
+          if (memory_roof < compute_roof)
+            bound = "memory";
+        }
+        cJSON_AddNumberToObject(report, "attainable", 
+          bytes > 0 ? min(compute_roof, memory_roof) : compute_roof);
+        cJSON_AddStringToObject(report, "bound", bound);
+        if (bytes > 0)
+          printf("[AutoSA] Roofline: %.3f ops/byte, compute roof %.2f GOPS, "
+                 "memory roof %.2f GOPS, %s-bound\n", intensity, compute_roof,
+                 memory_roof, bound);
+      }
+    }
+  }
+
+  return report;
+}
+
+/* Estimate the latency of the systolic array from the loop info
+ * dumped by sa_extract_loop_info.
+ * The modules are connected by FIFOs and run concurrently. In the steady
+ * state, the throughput of the array is limited by the slowest module.
+ * On top of it, the data need to go through the pipelines of the modules
+ * before the results come out, which is approximated by the sum of
+ * the pipeline depths of all the modules.
+ * The latency of each module is written to
+ * "<output_dir>/latency_est/latency.json" and the off-chip traffic and
+ * roofline report to "<output_dir>/latency_est/roofline.json".
+ */
+isl_stat sa_estimate_latency(struct autosa_gen *gen)
+{
+  struct sa_latency_est_data data;
+  cJSON *report, *modules;
+  char *json_str;
+  std::string path;
+  long steady = 0, fill = 0;
+  FILE *fp;
+
+  data.dir = std::string(gen->options->autosa->output_dir) + "/latency_est";
+  data.max_depth = 0;
+  report = cJSON_CreateObject();
+  modules = cJSON_CreateObject();
+
+  for (int i = 0; i < gen->n_hw_modules; i++) {
+    struct autosa_hw_module *module = gen->hw_modules[i];
+
+    estimate_array_module(&data, module->name, module->name, modules,
+                          &steady, &fill);
+    if (module->boundary)
+      estimate_array_module(&data, module->name,
+                            std::string(module->name) + "_boundary",
+                            modules, &steady, &fill);
+    for (int j = 0; j < module->n_pe_dummy_modules; j++) {
+      struct autosa_pe_dummy_module *dummy_module = module->pe_dummy_modules[j];
+      isl_printer *p_str = isl_printer_to_str(gen->ctx);
+      char *module_name;
+
+      p_str = autosa_array_ref_group_print_prefix(dummy_module->io_group, p_str);
+      p_str = isl_printer_print_str(p_str, "_PE_dummy");
+      module_name = isl_printer_get_str(p_str);
+      isl_printer_free(p_str);
+      estimate_array_module(&data, module->name, module_name, modules,
+                            &steady, &fill);
+      free(module_name);
+    }
+  }
+
+  cJSON_AddItemToObject(report, "modules", modules);
+  cJSON_AddNumberToObject(report, "steady_state", steady);
+  cJSON_AddNumberToObject(report, "fill", fill);
+  cJSON_AddNumberToObject(report, "latency", steady + fill);
+
+  json_str = cJSON_Print(report);
+  path = data.dir + "/latency.json";
+  fp = fopen(path.c_str(), "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Cannot open file: %s\n", path.c_str());
+    exit(1);
+  }
+  fprintf(fp, "%s", json_str);
+  fclose(fp);
+  free(json_str);
+  cJSON_Delete(report);
+
+  printf("[AutoSA] Estimated latency: %ld cycles\n", steady + fill);
+
+  report = estimate_roofline(&data, gen, steady + fill);
+  json_str = cJSON_Print(report);
+  path = data.dir + "/roofline.json";
+  fp = fopen(path.c_str(), "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Cannot open file: %s\n", path.c_str());
+    exit(1);
+  }
+  fprintf(fp, "%s", json_str);
+  fclose(fp);
+  free(json_str);
+  cJSON_Delete(report);
+
+  return isl_stat_ok;
+}
+
+/* FIFOs deeper than this only delay the stall of the producer. */
+#define SA_FIFO_MAX_DEPTH 1024
+
+/* FIFO access profile of a module, computed from its loop info.
+ * "start" is the number of cycles before the first FIFO access,
+ * or -1 if the module doesn't access the FIFOs.
+ * "burst" is the largest number of FIFO accesses in one pipelined loop nest.
+ * "count" is the total number of FIFO accesses.
+ * "latency" is the latency of the module.
+ */
+struct sa_fifo_profile {
+  double start;
+  double burst;
+  double count;
+  long latency;
+};
+
+/* Return the inter_trans and intra_trans modules called by the statement
+ * "expr" of an I/O module with local buffers.
+ */
+static std::vector<std::string> sub_module_names(
+  struct sa_latency_est_data *data, const char *expr)
+{
+  std::vector<std::string> names;
+  std::string inter = data->base + "_inter_trans";
+  std::string intra = data->base + "_intra_trans";
+
+  if (strstr(expr, ".boundary"))
+    inter += "_boundary";
+  if (!strncmp(expr, "io_module.inter_trans", strlen("io_module.inter_trans")))
+    names.push_back(inter);
+  else if (!strncmp(expr, "io_module.intra_trans", 
+                    strlen("io_module.intra_trans")))
+    names.push_back(intra);
+  else if (!strncmp(expr, "io_module.inter_intra", 
+                    strlen("io_module.inter_intra")) ||
+           !strncmp(expr, "io_module.intra_inter", 
+                    strlen("io_module.intra_inter"))) {
+    names.push_back(inter);
+    names.push_back(intra);
+  }
+
+  return names;
+}
+
+/* Return one for the statements that access a FIFO, i.e., the I/O
+ * statements "in.*", "out.*", "in_*" and "out_*".
+ * The DRAM transfers of the I/O modules with local buffers, in the format of
+ * in/out_trans_dram.[fifo_name].[is_filter].[is_buffer]..., only access
+ * the buffers. The PE statements are further restricted to "data->fifo".
+ * The I/O modules with local buffers access the FIFOs in their 
+ * inter_trans and intra_trans modules.
+ */
+static double count_fifo_accesses(struct sa_latency_est_data *data,
+  const char *expr)
+{
+  if (!strncmp(expr, "io_module.", strlen("io_module."))) {
+    std::vector<std::string> names = sub_module_names(data, expr);
+    double count = 0;
+
+    for (size_t i = 0; i < names.size(); i++)
+      count += count_module(data, names[i], &count_fifo_accesses);
+    return count;
+  }
+  if (!strncmp(expr, "in.", 3) || !strncmp(expr, "out.", 4))
+    return data->fifo.empty() ||
+           (!strncmp(expr, data->fifo.c_str(), data->fifo.size()) &&
+            expr[data->fifo.size()] == '.');
+  if (!strncmp(expr, "in_trans_dram", strlen("in_trans_dram")) ||
+      !strncmp(expr, "out_trans_dram", strlen("out_trans_dram"))) {
+    const char *pos = expr;
+
+    for (int n_dot = 0; n_dot < 3 && pos; n_dot++) {
+      pos = strchr(pos, '.');
+      if (pos)
+        pos++;
+    }
+    return pos && atol(pos) == 1 ? 0 : 1;
+  }
+  if (!strncmp(expr, "in_", 3) || !strncmp(expr, "out_", 4))
+    return 1;
+
+  return 0;
+}
+
+static double fifo_start_node(struct sa_latency_est_data *data,
+  const cJSON *node);
+
+/* Return the number of cycles before the first FIFO access of the
+ * inter_trans or intra_trans module "name", or -1 if there is none.
+ */
+static double fifo_start_module(struct sa_latency_est_data *data,
+  const std::string &name)
+{
+  std::map<std::string, long> env;
+  cJSON *info;
+  double start;
+
+  info = load_loop_info(data, name);
+  if (!info)
+    return -1;
+  env.swap(data->env);
+  start = fifo_start_node(data, info);
+  env.swap(data->env);
+  cJSON_Delete(info);
+
+  return start;
+}
+
+/* Return the number of cycles before the first FIFO access in "node",
+ * or -1 if there is none.
+ * The loop iterators are set to their first values, and the children of
+ * a block before the first access run to completion.
+ * With double buffering, the inter_trans and intra_trans modules
+ * run concurrently and the earlier one is taken.
+ */
+static double fifo_start_node(struct sa_latency_est_data *data,
+  const cJSON *node)
+{
+  const cJSON *item;
+
+  if (!node)
+    return -1;
+
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "loop"))) {
+    const cJSON *info = cJSON_GetObjectItemCaseSensitive(item, "loop_info");
+    const cJSON *iter = cJSON_GetObjectItemCaseSensitive(info, "iter");
+    const cJSON *lb = cJSON_GetObjectItemCaseSensitive(info, "lb");
+    std::map<std::string, long> env;
+    double start;
+
+    if (!cJSON_IsString(iter) || !cJSON_IsString(lb) ||
+        count_node(data, node, &count_fifo_accesses) <= 0)
+      return -1;
+    env = data->env;
+    data->env[iter->valuestring] = eval_loop_expr(data, lb->valuestring);
+    start = fifo_start_node(data, 
+              cJSON_GetObjectItemCaseSensitive(item, "child"));
+    data->env = env;
+    return start;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "mark")))
+    return fifo_start_node(data, 
+             cJSON_GetObjectItemCaseSensitive(item, "child"));
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "user"))) {
+    const cJSON *expr = cJSON_GetObjectItemCaseSensitive(item, "user_expr");
+    std::vector<std::string> names;
+    double start = -1;
+
+    if (!cJSON_IsString(expr))
+      return -1;
+    if (strncmp(expr->valuestring, "io_module.", strlen("io_module.")))
+      return count_fifo_accesses(data, expr->valuestring) > 0 ? 0 : -1;
+    names = sub_module_names(data, expr->valuestring);
+    for (size_t i = 0; i < names.size(); i++) {
+      double s = fifo_start_module(data, names[i]);
+      if (s >= 0 && (start < 0 || s < start))
+        start = s;
+    }
+    return start;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "block"))) {
+    const cJSON *child;
+    double cycles = 0;
+
+    cJSON_ArrayForEach(child, cJSON_GetObjectItemCaseSensitive(item, "child")) {
+      double start = fifo_start_node(data, child);
+      if (start >= 0)
+        return cycles + start;
+      cycles += sa_lat_cycles(estimate_node(data, child));
+    }
+    return -1;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "if"))) {
+    double then_start = fifo_start_node(data, 
+                          cJSON_GetObjectItemCaseSensitive(item, "then"));
+    double else_start = fifo_start_node(data, 
+                          cJSON_GetObjectItemCaseSensitive(item, "else"));
+    if (then_start < 0)
+      return else_start;
+    if (else_start < 0)
+      return then_start;
+    return min(then_start, else_start);
+  }
+
+  return -1;
+}
+
+static double fifo_burst_node(struct sa_latency_est_data *data,
+  const cJSON *node);
+
+/* Return the largest number of FIFO accesses in one pipelined loop nest
+ * of the inter_trans or intra_trans module "name".
+ */
+static double fifo_burst_module(struct sa_latency_est_data *data,
+  const std::string &name)
+{
+  std::map<std::string, long> env;
+  cJSON *info;
+  double burst;
+
+  info = load_loop_info(data, name);
+  if (!info)
+    return 0;
+  env.swap(data->env);
+  burst = fifo_burst_node(data, info);
+  env.swap(data->env);
+  cJSON_Delete(info);
+
+  return burst;
+}
+
+/* Return the largest number of FIFO accesses in one pipelined loop nest
+ * below "node". A loop nest that estimate_loop flattens into a pipeline
+ * issues all its accesses back to back. The other loops are visited with
+ * their iterators set to the middle of their ranges.
+ */
+static double fifo_burst_node(struct sa_latency_est_data *data,
+  const cJSON *node)
+{
+  const cJSON *item;
+
+  if (!node)
+    return 0;
+
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "loop"))) {
+    const cJSON *info = cJSON_GetObjectItemCaseSensitive(item, "loop_info");
+    const cJSON *iter = cJSON_GetObjectItemCaseSensitive(info, "iter");
+    const cJSON *lb = cJSON_GetObjectItemCaseSensitive(info, "lb");
+    const cJSON *ub = cJSON_GetObjectItemCaseSensitive(info, "ub");
+    std::map<std::string, long> env;
+    long lb_v, ub_v;
+    double burst;
+
+    if (!cJSON_IsString(iter) || !cJSON_IsString(lb) || !cJSON_IsString(ub))
+      return 0;
+    if (estimate_loop(data, item).pipelined)
+      return count_node(data, node, &count_fifo_accesses);
+    env = data->env;
+    lb_v = eval_loop_expr(data, lb->valuestring);
+    ub_v = eval_loop_expr(data, ub->valuestring);
+    data->env[iter->valuestring] = lb_v + (ub_v > lb_v ? (ub_v - lb_v) / 2 : 0);
+    burst = fifo_burst_node(data, 
+              cJSON_GetObjectItemCaseSensitive(item, "child"));
+    data->env = env;
+    return burst;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "mark")))
+    return fifo_burst_node(data, 
+             cJSON_GetObjectItemCaseSensitive(item, "child"));
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "user"))) {
+    const cJSON *expr = cJSON_GetObjectItemCaseSensitive(item, "user_expr");
+    std::vector<std::string> names;
+    double burst = 0;
+
+    if (!cJSON_IsString(expr))
+      return 0;
+    if (strncmp(expr->valuestring, "io_module.", strlen("io_module.")))
+      return count_fifo_accesses(data, expr->valuestring);
+    names = sub_module_names(data, expr->valuestring);
+    for (size_t i = 0; i < names.size(); i++) {
+      double sub_burst = fifo_burst_module(data, names[i]);
+      burst = max(burst, sub_burst);
+    }
+    return burst;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "block"))) {
+    const cJSON *child;
+    double burst = 0;
+
+    cJSON_ArrayForEach(child, cJSON_GetObjectItemCaseSensitive(item, "child")) {
+      double child_burst = fifo_burst_node(data, child);
+      burst = max(burst, child_burst);
+    }
+    return burst;
+  }
+  if ((item = cJSON_GetObjectItemCaseSensitive(node, "if"))) {
+    double then_burst = fifo_burst_node(data, 
+                          cJSON_GetObjectItemCaseSensitive(item, "then"));
+    double else_burst = fifo_burst_node(data, 
+                          cJSON_GetObjectItemCaseSensitive(item, "else"));
+    return max(then_burst, else_burst);
+  }
+
+  return 0;
+}
+
+/* Compute the FIFO access profile of "module".
+ * For the PEs, only the accesses of the FIFO "fifo" are considered.
+ */
+static struct sa_fifo_profile fifo_profile(struct sa_latency_est_data *data,
+  struct autosa_hw_module *module, const std::string &fifo)
+{
+  struct sa_fifo_profile profile = { -1, 0, 0, 0 };
+  cJSON *info;
+
+  data->base = module->name;
+  data->fifo = fifo;
+  data->env.clear();
+  data->max_depth = 0;
+  info = load_loop_info(data, module->name);
+  if (!info) {
+    printf("[AutoSA] Warning: Cannot find the loop info of module: %s\n",
+           module->name);
+    return profile;
+  }
+  profile.latency = sa_lat_cycles(estimate_node(data, info));
+  profile.count = count_node(data, info, &count_fifo_accesses);
+  profile.start = fifo_start_node(data, info);
+  profile.burst = fifo_burst_node(data, info);
+  cJSON_Delete(info);
+
+  return profile;
+}
+
+/* Return the depth of a FIFO written by a module with the profile "prod"
+ * and read by a module with the profile "cons" such that the producer
+ * is not stalled by back-pressure.
+ * If the producer starts earlier, it writes up to one burst before
+ * the consumer starts reading. During a burst, the producer writes one
+ * element per cycle while the consumer drains them at its average rate,
+ * so the FIFO needs to absorb the difference.
+ * The depth never exceeds the number of elements written.
+ */
+static long fifo_pair_depth(const struct sa_fifo_profile &prod,
+  const struct sa_fifo_profile &cons)
+{
+  double rate, depth;
+
+  if (prod.start < 0 || cons.start < 0 || prod.count <= 0 || cons.count <= 0)
+    return 0;
+  rate = cons.latency > 0 ? min(cons.count / cons.latency, 1.0) : 1.0;
+  depth = max(min(cons.start - prod.start, prod.burst), 
+              prod.burst * (1 - rate));
+  depth = min(depth, prod.count);
+
+  return (long)ceil(depth);
+}
+
+/* Return the I/O module of "group" in the direction "in" that is connected
+ * to the FIFOs declared by "module", i.e., the I/O module that feeds or 
+ * drains the PEs for a PE module, or the I/O module at the next upper level
+ * for an I/O module. Return NULL if there is none.
+ */
+static struct autosa_hw_module *fifo_neighbor(struct autosa_gen *gen,
+  struct autosa_hw_module *module, struct autosa_array_ref_group *group,
+  int in)
+{
+  for (int i = 0; i < gen->n_hw_modules; i++) {
+    struct autosa_hw_module *neighbor = gen->hw_modules[i];
+
+    if (neighbor == module || neighbor->type == PE_MODULE ||
+        neighbor->n_io_group == 0 || neighbor->io_groups[0] != group ||
+        neighbor->in != in)
+      continue;
+    if (module->type == PE_MODULE ? neighbor->to_pe : 
+        neighbor->level == module->level + 1)
+      return neighbor;
+  }
+
+  return NULL;
+}
+
+/* Return the depth of the FIFOs declared by "stmt" that avoids 
+ * back-pressure between their endpoint modules.
+ * The FIFOs between the instances of the same module, e.g., a chain of 
+ * PEs or I/O modules, connect modules running in lockstep and keep 
+ * the default depth. The FIFOs at the ends of the chains connect "module" 
+ * with its neighbor I/O module, which produces the data for the input FIFOs
+ * and consumes the data of the output FIFOs.
+ * In the PEs, the FIFO is read by the "in.[fifo_name]" statements and
+ * written by the "out.[fifo_name]" statements. The I/O modules are
+ * connected to a single FIFO group and all their I/O statements are used.
+ */
+static long fifo_decl_depth(struct sa_latency_est_data *data,
+  struct autosa_gen *gen, struct autosa_kernel_stmt *stmt)
+{
+  struct autosa_hw_module *module = stmt->u.m.module;
+  struct autosa_array_ref_group *group = stmt->u.m.group;
+  struct autosa_hw_module *in = fifo_neighbor(gen, module, group, 1);
+  struct autosa_hw_module *out = fifo_neighbor(gen, module, group, 0);
+  struct sa_fifo_profile read, write;
+  long depth = 0;
+
+  if (module->type == PE_MODULE) {
+    isl_printer *p_str = isl_printer_to_str(gen->ctx);
+    char *fifo_name;
+    std::string name;
+
+    p_str = autosa_array_ref_group_print_fifo_name(group, p_str);
+    fifo_name = isl_printer_get_str(p_str);
+    isl_printer_free(p_str);
+    name = fifo_name;
+    free(fifo_name);
+    read = fifo_profile(data, module, "in." + name);
+    write = fifo_profile(data, module, "out." + name);
+  } else {
+    read = write = fifo_profile(data, module, "");
+    if (module->in)
+      out = NULL;
+    else
+      in = NULL;
+  }
+
+  if (in) {
+    long in_depth = fifo_pair_depth(fifo_profile(data, in, ""), read);
+    depth = max(depth, in_depth);
+  }
+  if (out) {
+    long out_depth = fifo_pair_depth(write, fifo_profile(data, out, ""));
+    depth = max(depth, out_depth);
+  }
+
+  return depth;
+}
+
+/* Return the first instance id of the FIFOs declared by "stmt" that 
+ * indexes the module chains, i.e., the FIFOs with the instance ids from
+ * this position on being zero connect the chains to their neighbor
+ * I/O modules.
+ * The I/O modules are chained along their last instance id and connected
+ * to the I/O module at the next upper level by the first FIFO.
+ * The PEs of a group with a non-zero dependence direction are chained 
+ * behind each I/O module, whose instance ids are the leading ones. 
+ * Otherwise, every PE is connected to the I/O modules directly.
+ * Return the number of instance ids if all the FIFOs are at the chain ends.
+ */
+static int fifo_decl_chain_dim(struct autosa_gen *gen,
+  struct autosa_kernel_stmt *stmt)
+{
+  struct autosa_hw_module *module = stmt->u.m.module;
+  struct autosa_array_ref_group *group = stmt->u.m.group;
+  struct autosa_hw_module *neighbor;
+  int n = isl_id_list_n_id(module->inst_ids);
+
+  if (module->type != PE_MODULE) {
+    if (n == 0 || !fifo_neighbor(gen, module, group, module->in))
+      return n;
+    return n - 1;
+  }
+
+  if (isl_vec_is_zero(group->dir))
+    return n;
+  neighbor = fifo_neighbor(gen, module, group, 1);
+  if (!neighbor)
+    neighbor = fifo_neighbor(gen, module, group, 0);
+  if (!neighbor)
+    return n;
+  return min(isl_id_list_n_id(neighbor->inst_ids), n);
+}
+
+static isl_bool collect_fifo_decl(__isl_keep isl_ast_node *node, void *user)
+{
+  std::vector<struct autosa_kernel_stmt *> *stmts = 
+    (std::vector<struct autosa_kernel_stmt *> *)user;
+  struct autosa_kernel_stmt *stmt;
+  isl_id *id;
+
+  if (isl_ast_node_get_type(node) != isl_ast_node_user)
+    return isl_bool_true;
+  id = isl_ast_node_get_annotation(node);
+  stmt = (struct autosa_kernel_stmt *)isl_id_get_user(id);
+  isl_id_free(id);
+  if (stmt && stmt->type == AUTOSA_KERNEL_STMT_FIFO_DECL)
+    stmts->push_back(stmt);
+
+  return isl_bool_true;
+}
+
+/* Size the FIFOs declared in the top module.
+ * With --AutoSA-fifo-sizing, the depth of each FIFO declaration, 
+ * i.e., [fifo_name]_[module_name], is computed from the loop info of its
+ * endpoint modules by fifo_decl_depth. The depths in the file of 
+ * --AutoSA-fifo-depth-file, e.g., {"fifo_A_PE": 8}, override 
+ * the computed or default depths, e.g., with the FIFO occupancies measured 
+ * in the co-simulation. 
+ * The depth of a declaration is taken by its FIFO instances at the ends 
+ * of the module chains, see fifo_decl_chain_dim. The FIFOs inside 
+ * the chains connect identical modules running in lockstep and keep 
+ * the default depth.
+ * The depths are written to "<output_dir>/latency_est/fifo_depth.json",
+ * which can be used as the override file.
+ */
+isl_stat sa_size_fifos(struct autosa_gen *gen)
+{
+  struct autosa_hw_top_module *top = gen->hw_top_module;
+  struct autosa_options *options = gen->options->autosa;
+  struct sa_latency_est_data data;
+  cJSON *overrides = NULL, *report;
+  char *json_str;
+  std::string path;
+  FILE *fp;
+
+  data.dir = std::string(options->output_dir) + "/latency_est";
+  data.max_depth = 0;
+  if (options->fifo_depth_file) {
+    overrides = load_json(options->fifo_depth_file);
+    if (!overrides) {
+      printf("[AutoSA] Error: Cannot parse the FIFO depth file: %s\n",
+             options->fifo_depth_file);
+      exit(1);
+    }
+  }
+
+  report = cJSON_CreateObject();
+  for (int i = 0; i < top->n_fifo_decl_wrapped; i++) {
+    std::vector<struct autosa_kernel_stmt *> stmts;
+    std::string name(top->fifo_decl_names[i]);
+    cJSON *item;
+    long depth;
+
+    name = name.substr(0, name.rfind('.'));
+    if (isl_ast_node_foreach_descendant_top_down(
+          top->fifo_decl_wrapped_trees[i], &collect_fifo_decl, &stmts) < 0 ||
+        stmts.empty())
+      continue;
+
+    item = cJSON_GetObjectItemCaseSensitive(overrides, name.c_str());
+    if (cJSON_IsNumber(item)) {
+      depth = max(item->valueint, 1);
+    } else if (options->fifo_sizing) {
+      depth = fifo_decl_depth(&data, gen, stmts[0]);
+      depth = min(max(depth, AUTOSA_FIFO_DEPTH), SA_FIFO_MAX_DEPTH);
+    } else {
+      depth = AUTOSA_FIFO_DEPTH;
+    }
+
+    for (size_t j = 0; j < stmts.size(); j++) {
+      stmts[j]->u.m.fifo_depth = depth;
+      stmts[j]->u.m.fifo_chain_dim = fifo_decl_chain_dim(gen, stmts[j]);
+    }
+    cJSON_AddNumberToObject(report, name.c_str(), depth);
+    if (depth != AUTOSA_FIFO_DEPTH)
+      printf("[AutoSA] FIFO %s: depth %ld at the chain ends\n", 
+             name.c_str(), depth);
+  }
+  cJSON_Delete(overrides);
+
+  json_str = cJSON_Print(report);
+  path = data.dir + "/fifo_depth.json";
+  fp = fopen(path.c_str(), "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Cannot open file: %s\n", path.c_str());
+    exit(1);
+  }
+  fprintf(fp, "%s", json_str);
+  fclose(fp);
+  free(json_str);
+  cJSON_Delete(report);
+
+  return isl_stat_ok;
+}
@@ -0,0 +1,9 @@
+#ifndef _AUTOSA_LATENCY_EST_H
+#define _AUTOSA_LATENCY_EST_H
+
+#include "autosa_common.h"
+
+isl_stat sa_estimate_latency(struct autosa_gen *gen);
+isl_stat sa_size_fifos(struct autosa_gen *gen);
+
+#endif
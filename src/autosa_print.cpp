@@ -1106,6 +1106,198 @@ __isl_give isl_printer *print_top_gen_headers(
   isl_printer_free(p);
 }
 
+/* The printers of the top module below print the program that prints 
+ * the top module if "env" is NULL. Otherwise, they print the top module 
+ * directly, with the loop iterators of the top module taking the values 
+ * in "env".
+ */
+
+/* Print out
+ * "p = isl_printer_start_line(p);"
+ */
+__isl_give isl_printer *top_gen_start_line(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env)
+{
+  if (env)
+    return isl_printer_start_line(p);
+
+  return print_str_new_line(p, "p = isl_printer_start_line(p);");
+}
+
+/* Print out
+ * "p = isl_printer_end_line(p);"
+ */
+__isl_give isl_printer *top_gen_end_line(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env)
+{
+  if (env)
+    return isl_printer_end_line(p);
+
+  return print_str_new_line(p, "p = isl_printer_end_line(p);");
+}
+
+/* Print out
+ * "p = isl_printer_indent(p, [indent]);"
+ */
+__isl_give isl_printer *top_gen_indent(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env, int indent)
+{
+  if (env)
+    return isl_printer_indent(p, indent);
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "p = isl_printer_indent(p, ");
+  p = isl_printer_print_int(p, indent);
+  p = isl_printer_print_str(p, ");");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print out
+ * "p = isl_printer_print_str(p, \""
+ * The content of the string is printed to "p" by the caller, 
+ * followed by a call to top_gen_close_str.
+ * The content should not contain any character that needs to be escaped.
+ */
+__isl_give isl_printer *top_gen_open_str(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env)
+{
+  if (env)
+    return p;
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
+
+  return p;
+}
+
+/* Print out
+ * "\");"
+ */
+__isl_give isl_printer *top_gen_close_str(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env)
+{
+  if (env)
+    return p;
+
+  p = isl_printer_print_str(p, "\");");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print out
+ * "p = isl_printer_print_str(p, \"[str]\");"
+ * with the quotes and backslashes in "str" escaped.
+ */
+__isl_give isl_printer *top_gen_print_str(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env, const char *str)
+{
+  if (env)
+    return isl_printer_print_str(p, str);
+
+  p = top_gen_open_str(p, env);
+  for (const char *c = str; *c; c++) {
+    char buf[3] = {'\\', *c, '\0'};
+    p = isl_printer_print_str(p, (*c == '"' || *c == '\\') ? buf : buf + 1);
+  }
+  p = top_gen_close_str(p, env);
+
+  return p;
+}
+
+/* Print out
+ * "p = isl_printer_print_int(p, c[pos] + [offset]);"
+ * The offset is skipped if "offset" is NULL or zero.
+ */
+static __isl_give isl_printer *top_gen_print_iter(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env, int pos, __isl_keep isl_val *offset)
+{
+  std::string name = "c" + std::to_string(pos);
+
+  if (env) {
+    std::map<std::string, long>::iterator it = env->iters.find(name);
+    long v = 0;
+
+    if (it == env->iters.end())
+      env->error = true;
+    else
+      v = it->second;
+    if (offset)
+      v += isl_val_get_num_si(offset);
+    return isl_printer_print_int(p, v);
+  }
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "p = isl_printer_print_int(p, ");
+  p = isl_printer_print_str(p, name.c_str());
+  if (offset && !isl_val_is_zero(offset)) {
+    p = isl_printer_print_str(p, " + ");
+    p = isl_printer_print_val(p, offset);
+  }
+  p = isl_printer_print_str(p, ");");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print out
+ * "p = isl_printer_print_int(p, [expr] + [offset]);"
+ * The offset is skipped if "offset" is NULL or zero.
+ */
+static __isl_give isl_printer *top_gen_print_ast_expr(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env, 
+  __isl_keep isl_ast_expr *expr, __isl_keep isl_val *offset)
+{
+  int format;
+
+  if (env) {
+    bool error = false;
+    long v = autosa_eval_ast_expr(expr, env->iters, &error);
+
+    if (error)
+      env->error = true;
+    if (offset)
+      v += isl_val_get_num_si(offset);
+    return isl_printer_print_int(p, v);
+  }
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "p = isl_printer_print_int(p, ");
+  format = isl_printer_get_output_format(p);
+  p = isl_printer_set_output_format(p, ISL_FORMAT_C);
+  p = isl_printer_print_ast_expr(p, expr);
+  p = isl_printer_set_output_format(p, format);
+  if (offset && !isl_val_is_zero(offset)) {
+    p = isl_printer_print_str(p, " + ");
+    p = isl_printer_print_val(p, offset);
+  }
+  p = isl_printer_print_str(p, ");");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print out
+ * "[name]++;"
+ */
+static __isl_give isl_printer *top_gen_count(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env, const std::string &name)
+{
+  if (env) {
+    env->cnt[name]++;
+    return p;
+  }
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, name.c_str());
+  p = isl_printer_print_str(p, "++;");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
 /* Print out
  * "\/* [module_name] FIFO *\/"
  */
@@ -1124,23 +1316,17 @@ static __isl_give isl_printer *print_fifo_comment(
  * Increase the "pos"th index by the value of "val"
  */
 static __isl_give isl_printer *print_inst_ids_inc_suffix(
-  __isl_take isl_printer *p, int n, int pos, int val)
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env, 
+  int n, int pos, int val)
 {
   for (int i = 0; i < n; i++) {
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"_\");");
-    p = isl_printer_end_line(p);
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_int(p, c");
-    p = isl_printer_print_int(p, i);
-    if (i == pos) {
-      if (val != 0) {
-        p = isl_printer_print_str(p, " + ");
-        p = isl_printer_print_int(p, val);
-      }
-    }
-    p = isl_printer_print_str(p, ");");
-    p = isl_printer_end_line(p);
+    isl_val *inc = NULL;
+
+    if (i == pos && val != 0)
+      inc = isl_val_int_from_si(isl_printer_get_ctx(p), val);
+    p = top_gen_print_str(p, env, "_");
+    p = top_gen_print_iter(p, env, i, inc);
+    isl_val_free(inc);
   }
 
   return p;
@@ -1150,25 +1336,15 @@ static __isl_give isl_printer *print_inst_ids_inc_suffix(
  * "_c0_c1"
  */
 static __isl_give isl_printer *print_inst_ids_suffix(
-  __isl_take isl_printer *p, int n, __isl_keep isl_vec *offset)
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env, 
+  int n, __isl_keep isl_vec *offset)
 {
   for (int i = 0; i < n; i++) {
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"_\");");
-    p = isl_printer_end_line(p);
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_int(p, c");
-    p = isl_printer_print_int(p, i);
-    if (offset) {
-      isl_val *val = isl_vec_get_element_val(offset, i);
-      if (!isl_val_is_zero(val)) {
-        p = isl_printer_print_str(p, " + ");
-        p = isl_printer_print_val(p, val);
-      }
-      isl_val_free(val);
-    }
-    p = isl_printer_print_str(p, ");");
-    p = isl_printer_end_line(p);
+    isl_val *val = offset ? isl_vec_get_element_val(offset, i) : NULL;
+
+    p = top_gen_print_str(p, env, "_");
+    p = top_gen_print_iter(p, env, i, val);
+    isl_val_free(val);
   }
 
   return p;
@@ -1178,192 +1354,229 @@ static __isl_give isl_printer *print_inst_ids_suffix(
  * If the "offset" is set, it is added to the inst ids.
  */
 static __isl_give isl_printer *print_pretrans_inst_ids_suffix(
-  __isl_take isl_printer *p, int n_id, 
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env, int n_id, 
   __isl_keep isl_ast_expr *expr, __isl_keep isl_vec *offset)
 {
-  isl_ctx *ctx = isl_ast_expr_get_ctx(expr);
-  int n;
-
-  n = isl_ast_expr_op_get_n_arg(expr);
   for (int i = 0; i < n_id; i++) {
     isl_ast_expr *expr_i = isl_ast_expr_get_op_arg(expr, i + 1);
-    int format;
-      
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"_\");");
-    p = isl_printer_end_line(p);
+    isl_val *val = offset ? isl_vec_get_element_val(offset, i) : NULL;
 
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_int(p, ");
-    format = isl_printer_get_output_format(p);
-    p = isl_printer_set_output_format(p, ISL_FORMAT_C);
-    p = isl_printer_print_ast_expr(p, expr_i);
-    p = isl_printer_set_output_format(p, format);
-    if (offset) {
-      isl_val *val = isl_vec_get_element_val(offset, i);
-      if (!isl_val_is_zero(val)) {
-        p = isl_printer_print_str(p, " + ");
-        p = isl_printer_print_val(p, val);
-      }
-      isl_val_free(val);
-    }
-    p = isl_printer_print_str(p, ");");
-    p = isl_printer_end_line(p);
+    p = top_gen_print_str(p, env, "_");
+    p = top_gen_print_ast_expr(p, env, expr_i, val);
 
+    isl_val_free(val);
     isl_ast_expr_free(expr_i);
   }
 
   return p;
 }
 
-static __isl_give isl_printer *print_fifo_decl_single(
-  __isl_take isl_printer *p,
-  struct autosa_kernel_stmt *stmt, struct autosa_prog *prog, 
-  struct hls_info *hls, int pe_inout, const char *suffix)
+/* Print out the suffix of the fifo declared by "stmt" for the module
+ * instance.
+ */
+static __isl_give isl_printer *print_fifo_decl_inst_ids(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
+  struct autosa_kernel_stmt *stmt)
 {
   struct autosa_hw_module *module = stmt->u.m.module;
   struct autosa_array_ref_group *group = stmt->u.m.group;
   int boundary = stmt->u.m.boundary;
-  int n;
-  int n_lane;
-
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "// Count channel number");
-  p = isl_printer_end_line(p);
-
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "fifo_cnt++;");
-  p = isl_printer_end_line(p);
-
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "// Print channel declarations of module: ");
-  p = isl_printer_print_str(p, module->name);
-  p = isl_printer_end_line(p);
-
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-  p = isl_printer_end_line(p);
-
-  p = isl_printer_start_line(p);      
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
-  p = print_fifo_comment(p, module);
-  p = isl_printer_print_str(p, " ");
-  n_lane = get_io_group_n_lane(module, group);
-  if (hls->target == XILINX_HW)
-    p = print_fifo_type_xilinx(p, group, n_lane);
-  else if (hls->target == INTEL_HW)
-    p = print_fifo_type_intel(p, group, n_lane);
-  p = isl_printer_print_str(p, " ");
-  p = autosa_array_ref_group_print_fifo_name(group, p);
-  p = isl_printer_print_str(p, "_");
-  p = isl_printer_print_str(p, module->name);
-  if (pe_inout) {
-    p = isl_printer_print_str(p, suffix);
-  }
-  p = isl_printer_print_str(p, "\");");
-  p = isl_printer_end_line(p);
+  int n = isl_id_list_n_id(module->inst_ids);
 
-  n = isl_id_list_n_id(module->inst_ids);
   if (module->type == IO_MODULE || module->type == DRAIN_MODULE) {
     if (boundary) {
-      p = print_inst_ids_inc_suffix(p, n, n - 1, 1);
+      p = print_inst_ids_inc_suffix(p, env, n, n - 1, 1);
     } else {
-      p = print_inst_ids_suffix(p, n, NULL);
+      p = print_inst_ids_suffix(p, env, n, NULL);
     }
   } else if (module->type == PE_MODULE) {
     if (boundary) 
-      p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, group->dir);
+      p = print_pretrans_inst_ids_suffix(p, env, n, group->io_L1_pe_expr, 
+            group->dir);
     else
-      p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, NULL); 
+      p = print_pretrans_inst_ids_suffix(p, env, n, group->io_L1_pe_expr, 
+            NULL); 
   }
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \";\");");
-  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print out
+ * [fifo_name]_[module_name][suffix]
+ */
+static __isl_give isl_printer *print_fifo_decl_name(
+  __isl_take isl_printer *p, struct autosa_kernel_stmt *stmt, 
+  int pe_inout, const char *suffix)
+{
+  p = autosa_array_ref_group_print_fifo_name(stmt->u.m.group, p);
+  p = isl_printer_print_str(p, "_");
+  p = isl_printer_print_str(p, stmt->u.m.module->name);
+  if (pe_inout) {
+    p = isl_printer_print_str(p, suffix);
+  }
+
+  return p;
+}
+
+/* Return the depth of the FIFO declared by "stmt" for the instance 
+ * with the loop iterators "iters".
+ * The FIFOs inside the module chains keep the default depth, 
+ * see sa_size_fifos.
+ */
+int autosa_fifo_decl_inst_depth(struct autosa_kernel_stmt *stmt,
+  const std::map<std::string, long> &iters)
+{
+  int depth = stmt->u.m.fifo_depth > 0 ? stmt->u.m.fifo_depth : 
+                AUTOSA_FIFO_DEPTH;
+  int n = isl_id_list_n_id(stmt->u.m.module->inst_ids);
+
+  if (stmt->u.m.fifo_chain_dim < 0 || stmt->u.m.boundary)
+    return depth;
+  for (int i = stmt->u.m.fifo_chain_dim; i < n; i++) {
+    std::map<std::string, long>::const_iterator it = 
+      iters.find("c" + std::to_string(i));
+    if (it != iters.end() && it->second != 0)
+      return AUTOSA_FIFO_DEPTH;
+  }
+
+  return depth;
+}
+
+/* Print out the pragmas of the FIFO declared by "stmt" with depth "depth".
+ */
+static __isl_give isl_printer *print_fifo_decl_pragmas_xilinx(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
+  struct autosa_kernel_stmt *stmt, int n_lane, int pe_inout, 
+  const char *suffix, int depth)
+{
+  struct autosa_array_ref_group *group = stmt->u.m.group;
+
+  /* Print fifo pragma */
+  p = top_gen_start_line(p, env);
+  p = top_gen_open_str(p, env);
+  p = isl_printer_print_str(p, "#pragma HLS STREAM variable=");
+  p = print_fifo_decl_name(p, stmt, pe_inout, suffix);
+  p = top_gen_close_str(p, env);
+  p = print_fifo_decl_inst_ids(p, env, stmt);
+  p = top_gen_open_str(p, env);
+  p = isl_printer_print_str(p, " depth=");
+  p = isl_printer_print_int(p, depth);
+  p = top_gen_close_str(p, env);
+  p = top_gen_end_line(p, env);
+
+  /* If depth * width > 512 bits, HLS will use BRAM to implement FIFOs.
+   * Instead, we will insert pragmas to use SRL instead.
+   * FIFOs deeper than the shift registers are left to HLS.
+   */
+  /* Print fifo resource pragma. */
+  if (n_lane * group->array->size > 32 && depth <= AUTOSA_FIFO_SRL_DEPTH) {
+    p = top_gen_start_line(p, env);
+    p = top_gen_open_str(p, env);
+    p = isl_printer_print_str(p, "#pragma HLS RESOURCE variable=");
+    p = print_fifo_decl_name(p, stmt, pe_inout, suffix);
+    p = top_gen_close_str(p, env);
+    p = print_fifo_decl_inst_ids(p, env, stmt);
+    p = top_gen_print_str(p, env, " core=FIFO_SRL");
+    p = top_gen_end_line(p, env);
+  }
+
+  return p;
+}
+
+/* Print out the pragmas of the FIFO declared by "stmt".
+ * If the FIFOs inside the module chains keep the default depth, 
+ * the generator program selects the depth from the instance ids, i.e.,
+ *
+ * if (c1 == 0 && c2 == 0) {
+ *   [pragmas with fifo_depth]
+ * } else {
+ *   [pragmas with the default depth]
+ * }
+ */
+static __isl_give isl_printer *print_fifo_decl_inst_pragmas_xilinx(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
+  struct autosa_kernel_stmt *stmt, int n_lane, int pe_inout, 
+  const char *suffix)
+{
+  int n = isl_id_list_n_id(stmt->u.m.module->inst_ids);
+  int chain_dim = stmt->u.m.fifo_chain_dim;
+  std::map<std::string, long> no_iters;
+
+  if (env)
+    return print_fifo_decl_pragmas_xilinx(p, env, stmt, n_lane, pe_inout, 
+              suffix, autosa_fifo_decl_inst_depth(stmt, env->iters));
+  if (chain_dim < 0 || chain_dim >= n || stmt->u.m.boundary)
+    return print_fifo_decl_pragmas_xilinx(p, env, stmt, n_lane, pe_inout, 
+              suffix, autosa_fifo_decl_inst_depth(stmt, no_iters));
 
   p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
+  p = isl_printer_print_str(p, "if (");
+  for (int i = chain_dim; i < n; i++) {
+    if (i > chain_dim)
+      p = isl_printer_print_str(p, " && ");
+    p = isl_printer_print_str(p, "c");
+    p = isl_printer_print_int(p, i);
+    p = isl_printer_print_str(p, " == 0");
+  }
+  p = isl_printer_print_str(p, ") {");
   p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, 2);
+  p = print_fifo_decl_pragmas_xilinx(p, env, stmt, n_lane, pe_inout, 
+        suffix, autosa_fifo_decl_inst_depth(stmt, no_iters));
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "} else {");
+  p = isl_printer_indent(p, 2);
+  p = print_fifo_decl_pragmas_xilinx(p, env, stmt, n_lane, pe_inout, 
+        suffix, AUTOSA_FIFO_DEPTH);
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
 
-  if (hls->target == XILINX_HW) {
-    /* Print fifo pragma */
+  return p;
+}
+
+static __isl_give isl_printer *print_fifo_decl_single(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
+  struct autosa_kernel_stmt *stmt, struct autosa_prog *prog, 
+  struct hls_info *hls, int pe_inout, const char *suffix)
+{
+  struct autosa_hw_module *module = stmt->u.m.module;
+  struct autosa_array_ref_group *group = stmt->u.m.group;
+  int n_lane;
+
+  if (!env) {
     p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
+    p = isl_printer_print_str(p, "// Count channel number");
     p = isl_printer_end_line(p);
-    
+  }
+
+  p = top_gen_count(p, env, "fifo_cnt");
+
+  if (!env) {
     p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS STREAM variable=");
-    p = autosa_array_ref_group_print_fifo_name(group, p);
-    p = isl_printer_print_str(p, "_");
+    p = isl_printer_print_str(p, "// Print channel declarations of module: ");
     p = isl_printer_print_str(p, module->name);
-    if (pe_inout) {
-      p = isl_printer_print_str(p, suffix);
-    }
-    p = isl_printer_print_str(p, "\");");
     p = isl_printer_end_line(p);
+  }
 
-    if (module->type == IO_MODULE || module->type == DRAIN_MODULE) {
-      if (boundary) {
-        p = print_inst_ids_inc_suffix(p, n, n - 1, 1);
-      } else {
-        p = print_inst_ids_suffix(p, n, NULL);
-      }
-    } else if (module->type == PE_MODULE) {
-      if (boundary) {
-        p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, group->dir);
-      } else {
-        p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, NULL);
-      }
-    }
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \" depth=2\");");
-    p = isl_printer_end_line(p);
- 
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-    p = isl_printer_end_line(p);   
+  p = top_gen_start_line(p, env);
+  p = top_gen_open_str(p, env);
+  p = print_fifo_comment(p, module);
+  p = isl_printer_print_str(p, " ");
+  n_lane = get_io_group_n_lane(module, group);
+  if (hls->target == XILINX_HW)
+    p = print_fifo_type_xilinx(p, group, n_lane);
+  else if (hls->target == INTEL_HW)
+    p = print_fifo_type_intel(p, group, n_lane);
+  p = isl_printer_print_str(p, " ");
+  p = print_fifo_decl_name(p, stmt, pe_inout, suffix);
+  p = top_gen_close_str(p, env);
+  p = print_fifo_decl_inst_ids(p, env, stmt);
+  p = top_gen_print_str(p, env, ";");
+  p = top_gen_end_line(p, env);
 
-    /* If depth * width > 512 bits, HLS will use BRAM to implement FIFOs.
-     * Instead, we will insert pragmas to use SRL instead.
-     */
-    /* Print fifo resource pragma. */
-    if (n_lane * group->array->size > 32) {
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-      p = isl_printer_end_line(p);
-      
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS RESOURCE variable=");
-      p = autosa_array_ref_group_print_fifo_name(group, p);
-      p = isl_printer_print_str(p, "_");
-      p = isl_printer_print_str(p, module->name);
-      if (pe_inout) {
-        p = isl_printer_print_str(p, suffix);
-      }
-      p = isl_printer_print_str(p, "\");");
-      p = isl_printer_end_line(p);
-  
-      if (module->type == IO_MODULE || module->type == DRAIN_MODULE) {
-        if (boundary) {
-          p = print_inst_ids_inc_suffix(p, n, n - 1, 1);
-        } else {
-          p = print_inst_ids_suffix(p, n, NULL);
-        }
-      } else if (module->type == PE_MODULE) {
-        if (boundary) {
-          p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, group->dir);
-        } else {
-          p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, NULL);
-        }
-      }
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \" core=FIFO_SRL\");");
-      p = isl_printer_end_line(p);
-   
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-      p = isl_printer_end_line(p);   
-    }
-  }
+  if (hls->target == XILINX_HW)
+    p = print_fifo_decl_inst_pragmas_xilinx(p, env, stmt, n_lane, pe_inout,
+          suffix);
 
   return p;
 }
@@ -1379,7 +1592,8 @@ static __isl_give isl_printer *print_fifo_decl_single(
  *     print [fifo_name]_[module_name]_[inst_id]
  */
 static __isl_give isl_printer *print_fifo_decl(__isl_take isl_printer *p,
-  struct autosa_kernel_stmt *stmt, struct autosa_prog *prog, struct hls_info *hls)
+  struct autosa_top_gen_env *env, struct autosa_kernel_stmt *stmt, 
+  struct autosa_prog *prog, struct hls_info *hls)
 {
   struct autosa_hw_module *module = stmt->u.m.module;
   struct autosa_array_ref_group *group = stmt->u.m.group;
@@ -1393,44 +1607,43 @@ static __isl_give isl_printer *print_fifo_decl(__isl_take isl_printer *p,
   }
 
   if (pe_inout) {
-    p = print_fifo_decl_single(p, stmt, prog, hls, 1, "_in");
-    p = print_fifo_decl_single(p, stmt, prog, hls, 1, "_out");
+    p = print_fifo_decl_single(p, env, stmt, prog, hls, 1, "_in");
+    p = print_fifo_decl_single(p, env, stmt, prog, hls, 1, "_out");
   } else {
-    p = print_fifo_decl_single(p, stmt, prog, hls, 0, NULL);
+    p = print_fifo_decl_single(p, env, stmt, prog, hls, 0, NULL);
   }
 
   return p;
 }
 
+/* Print the fifo declaration "stmt" of the top module.
+ * If "env" is NULL, print the code that prints the declaration.
+ * Otherwise, print the declaration for the loop iterators in "env".
+ */
 __isl_give isl_printer *autosa_kernel_print_fifo_decl(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_kernel_stmt *stmt, struct autosa_prog *prog, struct hls_info *hls)
 {
-  p = ppcg_start_block(p);
+  if (!env)
+    p = ppcg_start_block(p);
 
   /* Build the fifo_decl. */
-  p = print_fifo_decl(p, stmt, prog, hls);
+  p = print_fifo_decl(p, env, stmt, prog, hls);
 
-  p = ppcg_end_block(p);
+  if (!env)
+    p = ppcg_end_block(p);
 
   return p;
 }
 
 static __isl_give isl_printer *print_delimiter(__isl_take isl_printer *p, 
-  int *first)
+  struct autosa_top_gen_env *env, int *first)
 {
   if (!(*first)) {
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \",\");");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-    p = isl_printer_end_line(p);
+    p = top_gen_print_str(p, env, ",");
+    p = top_gen_end_line(p, env);
   }
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-  p = isl_printer_end_line(p);
+  p = top_gen_start_line(p, env);
 
   *first = 0;
 
@@ -1438,12 +1651,10 @@ static __isl_give isl_printer *print_delimiter(__isl_take isl_printer *p,
 }
 
 static __isl_give isl_printer *print_fifo_annotation(__isl_take isl_printer *p, 
-  struct autosa_hw_module *module, 
+  struct autosa_top_gen_env *env, struct autosa_hw_module *module, 
   struct autosa_array_ref_group *group, int in, int lower)
 {
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* fifo */ \");");
-  p = isl_printer_end_line(p);
+  p = top_gen_print_str(p, env, "/* fifo */ ");
 
   return p;
 }
@@ -1452,15 +1663,14 @@ static __isl_give isl_printer *print_fifo_annotation(__isl_take isl_printer *p,
  * [fifo_name]_[module_name]
  */
 static __isl_give isl_printer *print_fifo_prefix(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env,
   struct autosa_hw_module *module, struct autosa_array_ref_group *group)
 {  
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
+  p = top_gen_open_str(p, env);
   p = autosa_array_ref_group_print_fifo_name(group, p);
   p = isl_printer_print_str(p, "_");
   p = isl_printer_print_str(p, module->name);
-  p = isl_printer_print_str(p, "\");");
-  p = isl_printer_end_line(p);
+  p = top_gen_close_str(p, env);
 
   return p;
 }
@@ -1472,7 +1682,8 @@ static __isl_give isl_printer *print_fifo_prefix(__isl_take isl_printer *p,
  * - arrays
  * - inter-module fifos
  */
-__isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p, 
+static __isl_give isl_printer *print_module_call_upper(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_kernel_stmt *stmt, struct autosa_prog *prog)
 {
   struct autosa_hw_module *module = stmt->u.m.module;
@@ -1486,68 +1697,47 @@ __isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p,
   char *module_name = stmt->u.m.module_name;
   isl_space *space;
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "// Print calls of module: ");
-  p = isl_printer_print_str(p, module_name);
-  if (boundary) {
-    p = isl_printer_print_str(p, "_boundary");
+  if (!env) {
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "// Print calls of module: ");
+    p = isl_printer_print_str(p, module_name);
+    if (boundary) {
+      p = isl_printer_print_str(p, "_boundary");
+    }
+    p = isl_printer_end_line(p);
   }
-  p = isl_printer_end_line(p);
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-  p = isl_printer_end_line(p);
+  p = top_gen_start_line(p, env);
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
+  p = top_gen_open_str(p, env);
   p = isl_printer_print_str(p, module_name);
   if (boundary) {
     p = isl_printer_print_str(p, "_boundary");
   }
   p = isl_printer_print_str(p, "_wrapper");
-  p = isl_printer_print_str(p, "(\");");
-  p = isl_printer_end_line(p);
-
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-  p = isl_printer_end_line(p);
+  p = isl_printer_print_str(p, "(");
+  p = top_gen_close_str(p, env);
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_indent(p, 4);");
-  p = isl_printer_end_line(p);
+  p = top_gen_end_line(p, env);
+  p = top_gen_indent(p, env, 4);
 
   /* module identifiers */
   if (!dummy) {
     for (int i = 0; i < isl_id_list_n_id(module->inst_ids); i++) {
-      p = print_delimiter(p, &first); 
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* module id */ \");");
-      p = isl_printer_end_line(p);
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_int(p, c");
-      p = isl_printer_print_int(p, i);
-      p = isl_printer_print_str(p, ");");
-      p = isl_printer_end_line(p);
+      p = print_delimiter(p, env, &first); 
+      p = top_gen_print_str(p, env, "/* module id */ ");
+      p = top_gen_print_iter(p, env, i, NULL);
     }
   } else {
     isl_ast_expr *expr = pe_dummy_module->io_group->io_L1_pe_expr;
-    int n_arg = isl_ast_expr_op_get_n_arg(expr);
 
     for (int i = 0; i < isl_id_list_n_id(module->inst_ids); i++) {
-      int format;
-      p = print_delimiter(p, &first);
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* module id */ \");");
-      p = isl_printer_end_line(p);
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_int(p, ");
-
       isl_ast_expr *expr_i = isl_ast_expr_get_op_arg(expr, i + 1);
-      p = isl_printer_print_ast_expr(p, expr_i);
+
+      p = print_delimiter(p, env, &first);
+      p = top_gen_print_str(p, env, "/* module id */ ");
+      p = top_gen_print_ast_expr(p, env, expr_i, NULL);
       isl_ast_expr_free(expr_i);
-    
-      p = isl_printer_print_str(p, ");");
-      p = isl_printer_end_line(p);
     }
   }
 
@@ -1555,43 +1745,51 @@ __isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p,
   space = isl_union_set_get_space(module->kernel->arrays);
   n = isl_space_dim(space, isl_dim_param);
   for (int i = 0; i < n; i++) {
-    p = print_delimiter(p, &first);
+    p = print_delimiter(p, env, &first);
 
     const char *name = isl_space_get_dim_name(space, isl_dim_set, i);
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* param */");
+    p = top_gen_open_str(p, env);
+    p = isl_printer_print_str(p, "/* param */");
     p = isl_printer_print_str(p, name);
-    p = isl_printer_print_str(p, "\");");
-    p = isl_printer_end_line(p);
+    p = top_gen_close_str(p, env);
   }
   isl_space_free(space);
 
   /* host iterators */
   n = isl_space_dim(module->kernel->space, isl_dim_set);
   for (int i = 0; i < n; i++) {
-    p = print_delimiter(p, &first);
+    p = print_delimiter(p, env, &first);
 
     const char *name = isl_space_get_dim_name(module->kernel->space, isl_dim_set, i);
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* host iter */ ");
+    p = top_gen_open_str(p, env);
+    p = isl_printer_print_str(p, "/* host iter */ ");
     p = isl_printer_print_str(p, name);
-    p = isl_printer_print_str(p, "\");");
-    p = isl_printer_end_line(p);
+    p = top_gen_close_str(p, env);
   }
 
   /* scalar and arrays */
   if (module->type != PE_MODULE && module->level == 3) {
-    p = print_delimiter(p, &first);
+    p = print_delimiter(p, env, &first);
 
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* array */ ");
+    p = top_gen_open_str(p, env);
+    p = isl_printer_print_str(p, "/* array */ ");
     p = isl_printer_print_str(p, module->io_groups[0]->array->name);
-    if (module->io_groups[0]->local_array->n_io_group_refs > 1) {
+    if (module->io_groups[0]->n_hbm_port > 1) {
+      /* Each HBM channel, i.e., the first module identifier,
+       * uses its own pointer. */
+      isl_val *ref = isl_val_int_from_si(isl_printer_get_ctx(p), 
+                                         module->n_array_ref);
       p = isl_printer_print_str(p, "_");
-      p = isl_printer_print_int(p, module->n_array_ref);
+      p = top_gen_close_str(p, env);
+      p = top_gen_print_iter(p, env, 0, ref);
+      isl_val_free(ref);
+    } else {
+      if (module->io_groups[0]->local_array->n_io_group_refs > 1) {
+        p = isl_printer_print_str(p, "_");
+        p = isl_printer_print_int(p, module->n_array_ref);
+      }
+      p = top_gen_close_str(p, env);
     }
-    p = isl_printer_print_str(p, "\");");
-    p = isl_printer_end_line(p);
   } else if (module->type == PE_MODULE) {
     for (int i = 0; i < prog->n_array; i++) {
       int required;
@@ -1603,13 +1801,12 @@ __isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p,
         continue;
 
       if (autosa_array_is_read_only_scalar(&prog->array[i])) {
-        p = print_delimiter(p, &first);
+        p = print_delimiter(p, env, &first);
     
-        p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* scalar */ ");
+        p = top_gen_open_str(p, env);
+        p = isl_printer_print_str(p, "/* scalar */ ");
         p = isl_printer_print_str(p, module->io_groups[0]->array->name);
-        p = isl_printer_print_str(p, "\");");
-        p = isl_printer_end_line(p);
+        p = top_gen_close_str(p, env);
       }
     }
   }
@@ -1619,47 +1816,43 @@ __isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p,
   if (module->type == PE_MODULE) {
     if (dummy) {
       struct autosa_array_ref_group *group = pe_dummy_module->io_group;
-      p = print_delimiter(p, &first);
-      p = print_fifo_annotation(p, module, group, 1, 0);
-      p = print_fifo_prefix(p, module, group);
+      p = print_delimiter(p, env, &first);
+      p = print_fifo_annotation(p, env, module, group, 1, 0);
+      p = print_fifo_prefix(p, env, module, group);
       if (isl_vec_is_zero(group->dir)) {
-        p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"_in\")");
-        p = isl_printer_end_line(p);
+        p = top_gen_print_str(p, env, "_in");
       }
-      p = print_pretrans_inst_ids_suffix(p, n, group->io_L1_pe_expr, group->dir);
+      p = print_pretrans_inst_ids_suffix(p, env, n, group->io_L1_pe_expr, 
+            group->dir);
     } else {
       for (int i = 0; i < module->n_io_group; i++) {
         struct autosa_array_ref_group *group = module->io_groups[i];
         if (group->pe_io_dir == IO_INOUT) {
-          p = print_delimiter(p, &first);
-          p = print_fifo_annotation(p, module, group, 1, 0);
-          p = print_fifo_prefix(p, module, group);
+          p = print_delimiter(p, env, &first);
+          p = print_fifo_annotation(p, env, module, group, 1, 0);
+          p = print_fifo_prefix(p, env, module, group);
           if (isl_vec_is_zero(group->old_dir)) {
-            p = isl_printer_start_line(p);
-            p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"_in\");");
-            p = isl_printer_end_line(p);
+            p = top_gen_print_str(p, env, "_in");
           }
-          p = print_inst_ids_suffix(p, n, NULL);
+          p = print_inst_ids_suffix(p, env, n, NULL);
   
-          p = print_delimiter(p, &first);
-          p = print_fifo_annotation(p, module, group, 0, 0);
-          p = print_fifo_prefix(p, module, group);
+          p = print_delimiter(p, env, &first);
+          p = print_fifo_annotation(p, env, module, group, 0, 0);
+          p = print_fifo_prefix(p, env, module, group);
           if (isl_vec_is_zero(group->old_dir)) {
-            p = isl_printer_start_line(p);
-            p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"_out\");");
-            p = isl_printer_end_line(p);
+            p = top_gen_print_str(p, env, "_out");
           }
           if (isl_vec_is_zero(group->old_dir)) {
-            p = print_inst_ids_suffix(p, n, NULL);
+            p = print_inst_ids_suffix(p, env, n, NULL);
           } else {
-            p = print_inst_ids_suffix(p, n, group->dir);
+            p = print_inst_ids_suffix(p, env, n, group->dir);
           }
         } else {
-          p = print_delimiter(p, &first);
-          p = print_fifo_annotation(p, module, group, group->pe_io_dir == IO_IN? 1 : 0, 0);
-          p = print_fifo_prefix(p, module, group);
-          p = print_inst_ids_suffix(p, n, NULL);
+          p = print_delimiter(p, env, &first);
+          p = print_fifo_annotation(p, env, module, group, 
+                group->pe_io_dir == IO_IN? 1 : 0, 0);
+          p = print_fifo_prefix(p, env, module, group);
+          p = print_inst_ids_suffix(p, env, n, NULL);
         }
       }
     }
@@ -1668,29 +1861,29 @@ __isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p,
       for (int i = 0; i < module->n_io_group; i++) {
         struct autosa_array_ref_group *group = module->io_groups[i]; 
         if (module->in) {
-          p = print_delimiter(p, &first);
-          p = print_fifo_annotation(p, module, group, 1, 0);
-          p = print_fifo_prefix(p, module, group);
-          p = print_inst_ids_suffix(p, n, NULL);
+          p = print_delimiter(p, env, &first);
+          p = print_fifo_annotation(p, env, module, group, 1, 0);
+          p = print_fifo_prefix(p, env, module, group);
+          p = print_inst_ids_suffix(p, env, n, NULL);
   
           if (!boundary) {
-            p = print_delimiter(p, &first);
-            p = print_fifo_annotation(p, module, group, 0, 0);
-            p = print_fifo_prefix(p, module, group);
-            p = print_inst_ids_inc_suffix(p, n, n - 1, 1);
+            p = print_delimiter(p, env, &first);
+            p = print_fifo_annotation(p, env, module, group, 0, 0);
+            p = print_fifo_prefix(p, env, module, group);
+            p = print_inst_ids_inc_suffix(p, env, n, n - 1, 1);
           }
         } else {
           if (!boundary) {
-            p = print_delimiter(p, &first);
-            p = print_fifo_annotation(p, module, group, 0, 0);
-            p = print_fifo_prefix(p, module, group);
-            p = print_inst_ids_inc_suffix(p, n, n - 1, 1);
+            p = print_delimiter(p, env, &first);
+            p = print_fifo_annotation(p, env, module, group, 0, 0);
+            p = print_fifo_prefix(p, env, module, group);
+            p = print_inst_ids_inc_suffix(p, env, n, n - 1, 1);
           }
 
-          p = print_delimiter(p, &first);
-          p = print_fifo_annotation(p, module, group, 1, 0);
-          p = print_fifo_prefix(p, module, group);
-          p = print_inst_ids_suffix(p, n, NULL);
+          p = print_delimiter(p, env, &first);
+          p = print_fifo_annotation(p, env, module, group, 1, 0);
+          p = print_fifo_prefix(p, env, module, group);
+          p = print_inst_ids_suffix(p, env, n, NULL);
         }
       }
     }
@@ -1732,13 +1925,12 @@ static char *build_io_module_lower_name(struct autosa_hw_module *module)
 /* Print the prefix of fifos to the lower-level modules. 
  */
 static __isl_give isl_printer *print_fifo_prefix_lower(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_hw_module *module, struct autosa_array_ref_group *group)
 {
   int lower_is_PE;
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
+  p = top_gen_open_str(p, env);
   p = autosa_array_ref_group_print_fifo_name(group, p);
   p = isl_printer_print_str(p, "_");
   assert(module->type != PE_MODULE);
@@ -1755,8 +1947,7 @@ static __isl_give isl_printer *print_fifo_prefix_lower(
   } else {
     p = isl_printer_print_str(p, "PE");
   }
-  p = isl_printer_print_str(p, "\");");
-  p = isl_printer_end_line(p);
+  p = top_gen_close_str(p, env);
 
   return p;
 }
@@ -1765,6 +1956,7 @@ static __isl_give isl_printer *print_fifo_prefix_lower(
  * fifos to the lower-level modules.
  */
 static __isl_give isl_printer *print_module_call_lower(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env,
   struct autosa_kernel_stmt *stmt, struct autosa_prog *prog)
 {
   struct autosa_hw_module *module = stmt->u.m.module;
@@ -1777,10 +1969,10 @@ static __isl_give isl_printer *print_module_call_lower(__isl_take isl_printer *p
   if (lower) {
     struct autosa_array_ref_group *group = module->io_groups[0];
 
-    p = print_delimiter(p, &first);
+    p = print_delimiter(p, env, &first);
 
-    p = print_fifo_annotation(p, module, group, module->in? 0 : 1, 1); 
-    p = print_fifo_prefix_lower(p, module, group);
+    p = print_fifo_annotation(p, env, module, group, module->in? 0 : 1, 1); 
+    p = print_fifo_prefix_lower(p, env, module, group);
 
     if (module->to_pe)
       lower_is_PE = 1;
@@ -1790,40 +1982,63 @@ static __isl_give isl_printer *print_module_call_lower(__isl_take isl_printer *p
     if (isl_vec_is_zero(group->old_dir) 
         && lower_is_PE && group->pe_io_dir == IO_INOUT) {
       /* Add in/out suffix. */
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
-      p = isl_printer_print_str(p, module->in? "_in": "_out");
-      p = isl_printer_print_str(p, "\");");
-      p = isl_printer_end_line(p);
+      p = top_gen_print_str(p, env, module->in? "_in": "_out");
     }
 
     if (lower_is_PE) {
-      p = print_pretrans_inst_ids_suffix(p, module->kernel->n_sa_dim, 
+      p = print_pretrans_inst_ids_suffix(p, env, module->kernel->n_sa_dim, 
               boundary? group->io_pe_expr_boundary : group->io_pe_expr, NULL);
     } else {
-      p = print_inst_ids_suffix(p, n + 1, NULL);
+      p = print_inst_ids_suffix(p, env, n + 1, NULL);
     }
   } 
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-  p = isl_printer_end_line(p);
+  p = top_gen_end_line(p, env);
+  p = top_gen_indent(p, env, -4);
+  p = top_gen_start_line(p, env);
+  p = top_gen_print_str(p, env, ");");
+  p = top_gen_end_line(p, env);
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_indent(p, -4);");
-  p = isl_printer_end_line(p);
+  return p;
+}
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-  p = isl_printer_end_line(p);
+/* Print out the counters of the module called by "stmt".
+ */
+static __isl_give isl_printer *print_module_call_counters(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
+  struct autosa_kernel_stmt *stmt)
+{
+  std::string module_name(stmt->u.m.module_name);
+  struct autosa_hw_module *module = stmt->u.m.module;
+  int boundary = stmt->u.m.boundary;
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \");\");");
-  p = isl_printer_end_line(p);
+  if (!env) {
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "// Count module number");
+    p = isl_printer_end_line(p);
+  }
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-  p = isl_printer_end_line(p);
+  p = top_gen_count(p, env, 
+        module_name + (boundary ? "_boundary" : "") + "_cnt");
+  if (module->is_filter && module->is_buffer) {
+    /* Print counter for inter_trans and intra_trans module. */
+    p = top_gen_count(p, env, module_name + "_intra_trans_cnt");
+    p = top_gen_count(p, env, module_name + 
+          (boundary ? "_inter_trans_boundary_cnt" : "_inter_trans_cnt"));
+  }
+
+  return p;
+}
+
+/* Print out
+ * "\/* Module Call *\/"
+ */
+static __isl_give isl_printer *print_module_call_mark(
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env)
+{
+  p = top_gen_start_line(p, env);
+  p = top_gen_print_str(p, env, "/* Module Call */");
+  p = top_gen_end_line(p, env);
 
   return p;
 }
@@ -1831,141 +2046,42 @@ static __isl_give isl_printer *print_module_call_lower(__isl_take isl_printer *p
 /* Print out the module calls:
  * - module_call_upper
  * - module_call_lower
+ * If "env" is NULL, print the code that prints the module call.
+ * Otherwise, print the module call for the loop iterators in "env".
  */
 __isl_give isl_printer *autosa_kernel_print_module_call(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_kernel_stmt *stmt, struct autosa_prog *prog)
 {
   int upper = stmt->u.m.upper;
   int lower = stmt->u.m.lower;
   int complete = (upper == 0 && lower == 0);
-  int dummy = stmt->u.m.dummy;
-  int boundary = stmt->u.m.boundary;
-  char *module_name = stmt->u.m.module_name;
-  struct autosa_hw_module *module = stmt->u.m.module;
-  p = ppcg_start_block(p);
+
+  if (!env)
+    p = ppcg_start_block(p);
 
   /* Build the module name. */  
   if (complete) {
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "// Count module number");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, module_name);
-    if (boundary) 
-      p = isl_printer_print_str(p, "_boundary");
-    p = isl_printer_print_str(p, "_cnt++;");
-    p = isl_printer_end_line(p);
-    if (module->is_filter && module->is_buffer) {
-      /* Print counter for inter_trans and intra_trans module. */
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, module_name);
-      p = isl_printer_print_str(p, "_intra_trans_cnt++;");
-      p = isl_printer_end_line(p);
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, module_name);
-      if (boundary)        
-        p = isl_printer_print_str(p, "_inter_trans_boundary_cnt++;");
-      else
-        p = isl_printer_print_str(p, "_inter_trans_cnt++;");
-      p = isl_printer_end_line(p);
-    }
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-    p = isl_printer_end_line(p);
-    
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* Module Call */\");");
-    p = isl_printer_end_line(p);
-    
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-    p = isl_printer_end_line(p);
-
-    p = print_module_call_upper(p, stmt, prog);
-    p = print_module_call_lower(p, stmt, prog);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-    p = isl_printer_end_line(p);
-    
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* Module Call */\");");
-    p = isl_printer_end_line(p);
-    
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-    p = isl_printer_end_line(p);
+    p = print_module_call_counters(p, env, stmt);
+    p = print_module_call_mark(p, env);
+    p = print_module_call_upper(p, env, stmt, prog);
+    p = print_module_call_lower(p, env, stmt, prog);
+    p = print_module_call_mark(p, env);
+    p = top_gen_end_line(p, env);
   } else {
     if (upper) {
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "// Count module number");
-      p = isl_printer_end_line(p);
-  
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, module_name);
-      if (boundary) 
-        p = isl_printer_print_str(p, "_boundary");
-      p = isl_printer_print_str(p, "_cnt++;");
-      p = isl_printer_end_line(p);
-      if (module->is_filter && module->is_buffer) {
-        /* Print counter for inter_trans and intra_trans module */
-        p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, module_name);
-        p = isl_printer_print_str(p, "_intra_trans_cnt++;");
-        p = isl_printer_end_line(p);
-
-        p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, module_name);
-        if (boundary)
-          p = isl_printer_print_str(p, "_inter_trans_boundary_cnt++;");
-        else
-          p = isl_printer_print_str(p, "_inter_trans_cnt++;");
-        p = isl_printer_end_line(p);
-      }
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-      p = isl_printer_end_line(p);
-      
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* Module Call */\");");
-      p = isl_printer_end_line(p);
-      
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-      p = isl_printer_end_line(p);
-
-      p = print_module_call_upper(p, stmt, prog);
+      p = print_module_call_counters(p, env, stmt);
+      p = print_module_call_mark(p, env);
+      p = print_module_call_upper(p, env, stmt, prog);
     } else { 
-      p = print_module_call_lower(p, stmt, prog);
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
-      p = isl_printer_end_line(p);
-      
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"/* Module Call */\");");
-      p = isl_printer_end_line(p);
-      
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-      p = isl_printer_end_line(p);
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "p = isl_printer_end_line(p);");
-      p = isl_printer_end_line(p);
+      p = print_module_call_lower(p, env, stmt, prog);
+      p = print_module_call_mark(p, env);
+      p = top_gen_end_line(p, env);
     }
   }
 
-  p = ppcg_end_block(p);
+  if (!env)
+    p = ppcg_end_block(p);
 
   return p;
 }
@@ -2044,7 +2160,7 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
     n_arg = isl_ast_expr_get_op_n_arg(local_index_packed);
     arg = isl_ast_expr_get_op_arg(local_index_packed, n_arg - 1);
     div = isl_ast_expr_from_val(isl_val_int_from_si(ctx, data_pack));
-    arg = isl_ast_expr_div(arg, div);
+    arg = autosa_ast_expr_simplify(isl_ast_expr_div(arg, div));
     local_index_packed = isl_ast_expr_set_op_arg(local_index_packed, n_arg - 1, arg);
   }
 
@@ -2327,7 +2443,7 @@ static __isl_give isl_printer *autosa_kernel_print_io_transfer_default(
     n_arg = isl_ast_expr_get_op_n_arg(local_index_packed);
     arg = isl_ast_expr_get_op_arg(local_index_packed, n_arg - 1);
     div = isl_ast_expr_from_val(isl_val_int_from_si(ctx, n_lane));
-    arg = isl_ast_expr_div(arg, div);
+    arg = autosa_ast_expr_simplify(isl_ast_expr_div(arg, div));
     local_index_packed = isl_ast_expr_set_op_arg(local_index_packed, n_arg - 1, arg);
   }
 
@@ -2528,7 +2644,7 @@ static __isl_give isl_printer *autosa_kernel_print_io_transfer_data_pack(
     n_arg = isl_ast_expr_get_op_n_arg(local_index_packed);
     arg = isl_ast_expr_get_op_arg(local_index_packed, n_arg - 1);
     div = isl_ast_expr_from_val(isl_val_int_from_si(ctx, n_lane));
-    arg = isl_ast_expr_div(arg, div);
+    arg = autosa_ast_expr_simplify(isl_ast_expr_div(arg, div));
     local_index_packed = isl_ast_expr_set_op_arg(local_index_packed, n_arg - 1, arg);
   }
 
@@ -2636,6 +2752,7 @@ static __isl_give isl_printer *autosa_kernel_print_io_transfer_data_pack(
   r = n_lane / nxt_n_lane;
   val = isl_val_int_from_si(ctx, nxt_n_lane);
   op = isl_ast_expr_div(op, isl_ast_expr_from_val(val));
+  op = autosa_ast_expr_simplify(op);
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "int split_i = (");
   p = isl_printer_print_ast_expr(p, op);
@@ -2863,7 +2980,7 @@ __isl_give isl_printer *autosa_kernel_print_io_dram(__isl_take isl_printer *p,
     n_arg = isl_ast_expr_get_op_n_arg(local_index_packed);
     arg = isl_ast_expr_get_op_arg(local_index_packed, n_arg - 1);
     div = isl_ast_expr_from_val(isl_val_int_from_si(ctx, n_lane));
-    arg = isl_ast_expr_div(arg, div);
+    arg = autosa_ast_expr_simplify(isl_ast_expr_div(arg, div));
     local_index_packed = isl_ast_expr_set_op_arg(local_index_packed, n_arg - 1, arg);
   }
 
@@ -1,10 +1,24 @@
 #ifndef _AUTOSA_PRINT_H
 #define _AUTOSA_PRINT_H
 
+#include <map>
+#include <string>
+
 #include <isl/printer.h>
 
 #include "autosa_common.h"
 
+/* The values of the loop iterators "iters" and of the fifo and module 
+ * counters "cnt" of the top module, when the top module is printed directly
+ * instead of printing the program that prints it.
+ * "error" is set if an iterator can't be evaluated.
+ */
+struct autosa_top_gen_env {
+  std::map<std::string, long> iters;
+  std::map<std::string, long> cnt;
+  bool error;
+};
+
 /* Arrays */
 __isl_give isl_printer *autosa_array_info_print_call_argument(
 	__isl_take isl_printer *p, struct autosa_array_info *array);
@@ -61,8 +75,20 @@ __isl_give isl_printer *print_top_gen_headers(
 __isl_give isl_printer *print_top_gen_arguments(__isl_take isl_printer *p,
   struct autosa_prog *prog, struct autosa_kernel *kernel, int types);
 __isl_give isl_printer *autosa_kernel_print_module_call(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_kernel_stmt *stmt, struct autosa_prog *prog);  
+__isl_give isl_printer *top_gen_start_line(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env);
+__isl_give isl_printer *top_gen_end_line(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env);
+__isl_give isl_printer *top_gen_indent(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env, int indent);
+__isl_give isl_printer *top_gen_open_str(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env);
+__isl_give isl_printer *top_gen_close_str(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env);
+__isl_give isl_printer *top_gen_print_str(__isl_take isl_printer *p,
+  struct autosa_top_gen_env *env, const char *str);
 
 /* FIFOs */
 __isl_give isl_printer *autosa_fifo_print_declaration_arguments(
@@ -72,8 +98,10 @@ __isl_give isl_printer *autosa_fifo_print_call_argument(
   __isl_take isl_printer *p, struct autosa_array_ref_group *group,
   const char *suffix, enum platform target);	
 __isl_give isl_printer *autosa_kernel_print_fifo_decl(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_kernel_stmt *stmt, struct autosa_prog *prog, struct hls_info *hls);
+int autosa_fifo_decl_inst_depth(struct autosa_kernel_stmt *stmt,
+  const std::map<std::string, long> &iters);
 
 /* Statements */
 __isl_give isl_printer *autosa_kernel_print_domain(__isl_take isl_printer *p,
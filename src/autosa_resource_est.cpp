@@ -0,0 +1,594 @@
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+
+#include <isl/ast.h>
+#include <isl/ctx.h>
+
+#include "autosa_resource_est.h"
+#include "autosa_print.h"
+#include "autosa_utils.h"
+
+/* On-chip resource usage of a hardware block.
+ * "bram" is counted in BRAM18K blocks.
+ */
+struct sa_resource {
+  long dsp;
+  long bram;
+  long uram;
+  long lut;
+  long ff;
+};
+
+/* The resource types in the order of the budget file "hw_info.json".
+ */
+static const char *sa_resource_names[] = {"BRAM", "DSP", "FF", "LUT", "URAM"};
+#define SA_N_RESOURCE \
+  ((int)(sizeof(sa_resource_names) / sizeof(sa_resource_names[0])))
+
+static long *sa_resource_field(struct sa_resource *res, int i)
+{
+  long *fields[] = {&res->bram, &res->dsp, &res->ff, &res->lut, &res->uram};
+  return fields[i];
+}
+
+static void sa_resource_add(struct sa_resource *res,
+  const struct sa_resource *other, long n)
+{
+  res->dsp += other->dsp * n;
+  res->bram += other->bram * n;
+  res->uram += other->uram * n;
+  res->lut += other->lut * n;
+  res->ff += other->ff * n;
+}
+
+static cJSON *sa_resource_to_json(struct sa_resource *res)
+{
+  cJSON *json = cJSON_CreateObject();
+
+  for (int i = 0; i < SA_N_RESOURCE; i++)
+    cJSON_AddNumberToObject(json, sa_resource_names[i],
+                            *sa_resource_field(res, i));
+  return json;
+}
+
+static long ceil_div(long a, long b)
+{
+  return (a + b - 1) / b;
+}
+
+/* Resource usage of one multiply-accumulate on elements of type "type"
+ * of "size" bytes, i.e., of one SIMD lane of a PE.
+ * The numbers are coarse and follow the default operator implementations
+ * of Xilinx HLS.
+ */
+static struct sa_resource mac_resource(const char *type, int size)
+{
+  struct sa_resource res = {0, 0, 0, 0, 0};
+
+  if (!strcmp(type, "double")) {
+    res.dsp = 14; res.lut = 1000; res.ff = 1400;
+  } else if (!strcmp(type, "float")) {
+    res.dsp = 5; res.lut = 390; res.ff = 640;
+  } else if (size <= 2) {
+    res.dsp = 1; res.lut = 10 * size; res.ff = 30 * size;
+  } else if (size <= 4) {
+    res.dsp = 3; res.lut = 100; res.ff = 150;
+  } else {
+    res.dsp = 10; res.lut = 300; res.ff = 400;
+  }
+
+  return res;
+}
+
+/* Resource usage of one MAC unit of the PEs in "kernel",
+ * which computes on the widest data type of the arrays in the kernel.
+ */
+static struct sa_resource kernel_mac_resource(struct autosa_kernel *kernel)
+{
+  struct autosa_array_info *widest = NULL;
+  struct sa_resource res = {0, 0, 0, 0, 0};
+
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_array_info *array = kernel->array[i].array;
+    if (!widest || array->size > widest->size)
+      widest = array;
+  }
+  if (widest)
+    res = mac_resource(widest->type, widest->size);
+
+  return res;
+}
+
+/* Return the number of DSPs used by one SIMD lane of a PE in "kernel".
+ */
+int sa_kernel_mac_dsp(struct autosa_kernel *kernel)
+{
+  return kernel_mac_resource(kernel).dsp;
+}
+
+/* Resource usage of the local buffer "var" of "module".
+ * The memory type is chosen by extract_memory_type as in the generated code.
+ * Each partition is mapped separately:
+ * - BRAM18K: 1K x 18 bits or 512 x 36 bits per block
+ * - URAM: 4K x 72 bits per block
+ * - LUTRAM: 64 x 1 bit per LUT
+ * - FF: one register per bit
+ */
+static struct sa_resource buffer_resource(struct autosa_hw_module *module,
+  struct autosa_kernel_var *var, int uram)
+{
+  struct sa_resource res = {0, 0, 0, 0, 0};
+  long width = var->n_lane * var->array->size * 8;
+  long depth = 1;
+  long n_part = var->n_part > 0 ? var->n_part : 1;
+  long part_depth;
+
+  for (int i = 0; i < isl_vec_size(var->size); i++) {
+    isl_val *v = isl_vec_get_element_val(var->size, i);
+    depth *= isl_val_get_num_si(v);
+    isl_val_free(v);
+  }
+  part_depth = ceil_div(depth, n_part);
+
+  switch (extract_memory_type(module, var, uram)) {
+    case 0:
+      res.ff = width * depth;
+      break;
+    case 1:
+      res.lut = n_part * width * ceil_div(part_depth, 64);
+      break;
+    case 2:
+      if (width <= 18)
+        res.bram = n_part * ceil_div(width, 18) * ceil_div(part_depth, 1024);
+      else
+        res.bram = n_part * ceil_div(width, 36) * ceil_div(part_depth, 512);
+      break;
+    default:
+      res.uram = n_part * ceil_div(width, 72) * ceil_div(part_depth, 4096);
+      break;
+  }
+
+  return res;
+}
+
+/* Resource usage of a single instance of "module".
+ * Each module has a small controller. PEs contain "simd_w" MAC units
+ * of the widest data type in the kernel. I/O modules pack and unpack
+ * the data, which costs about one LUT and one FF per bit of the wider port.
+ * With double buffering, each local buffer is instantiated twice.
+ */
+static struct sa_resource module_resource(struct autosa_gen *gen,
+  struct autosa_hw_module *module)
+{
+  struct sa_resource res = {0, 0, 0, 200, 250};
+  struct autosa_kernel *kernel = gen->kernel;
+  int n_buf = module->double_buffer ? 2 : 1;
+
+  if (module->type == PE_MODULE) {
+    struct sa_resource mac = kernel_mac_resource(kernel);
+    sa_resource_add(&res, &mac, kernel->simd_w);
+  } else if (module->n_io_group > 0) {
+    struct autosa_array_info *array = module->io_groups[0]->array;
+    int n_lane = module->data_pack_inter > module->data_pack_intra ?
+                   module->data_pack_inter : module->data_pack_intra;
+    res.lut += n_lane * array->size * 8;
+    res.ff += n_lane * array->size * 8;
+  }
+
+  for (int i = 0; i < module->n_var; i++) {
+    struct sa_resource buf;
+    buf = buffer_resource(module, &module->var[i], gen->options->autosa->uram);
+    sa_resource_add(&res, &buf, n_buf);
+  }
+
+  return res;
+}
+
+/* Resource usage of a single instance of a PE dummy module,
+ * which only consumes the data at the boundary of the array.
+ */
+static struct sa_resource pe_dummy_resource()
+{
+  struct sa_resource res = {0, 0, 0, 50, 50};
+  return res;
+}
+
+/* Resource usage of a FIFO of "width" bytes and "depth" entries.
+ * FIFOs of up to AUTOSA_FIFO_SRL_DEPTH entries are implemented with 
+ * shift registers, which take about one LUT and one FF per bit, 
+ * plus a small controller. The deeper FIFOs are mapped to BRAM18K blocks.
+ */
+static struct sa_resource fifo_resource(long width, long depth)
+{
+  struct sa_resource res = {0, 0, 0, width * 8 + 8, width * 8 + 8};
+
+  if (depth > AUTOSA_FIFO_SRL_DEPTH) {
+    res.bram = ceil_div(width * 8, 36) * ceil_div(depth, 512);
+    res.lut = 50;
+    res.ff = 50;
+  }
+  return res;
+}
+
+/* Internal data structure for counting the module instances and FIFOs
+ * of the top module.
+ * "env" maps the loop iterators to their current values.
+ * "modules" maps the module names to their number of instances.
+ * "fifos" maps the depths of the FIFOs declared by the current declaration
+ * to their numbers.
+ * "error" is set if the loops can not be interpreted.
+ */
+struct sa_resource_count_data {
+  std::map<std::string, long> env;
+  std::map<std::string, long> modules;
+  std::map<long, long> fifos;
+  bool error;
+};
+
+/* Walk the AST "node" of the FIFO declarations or module calls of
+ * the top module and count the statements executed, in the same way
+ * as the top module generator does.
+ * A FIFO declaration of an inout PE group declares two FIFOs.
+ * A module call is split into an upper and a lower statement, only
+ * the upper statement is counted.
+ */
+static void count_top_stmts(__isl_keep isl_ast_node *node,
+  struct sa_resource_count_data *data)
+{
+  if (!node || data->error)
+    return;
+
+  switch (isl_ast_node_get_type(node)) {
+    case isl_ast_node_for:
+    {
+      isl_ast_expr *iterator = isl_ast_node_for_get_iterator(node);
+      isl_ast_expr *init = isl_ast_node_for_get_init(node);
+      isl_ast_expr *cond = isl_ast_node_for_get_cond(node);
+      isl_ast_expr *inc = isl_ast_node_for_get_inc(node);
+      isl_ast_node *body = isl_ast_node_for_get_body(node);
+      isl_id *id = isl_ast_expr_get_id(iterator);
+      std::string name(isl_id_get_name(id));
+      long step = autosa_eval_ast_expr(inc, data->env, &data->error);
+
+      if (step <= 0)
+        data->error = true;
+      data->env[name] = autosa_eval_ast_expr(init, data->env, &data->error);
+      while (!data->error &&
+             autosa_eval_ast_expr(cond, data->env, &data->error)) {
+        count_top_stmts(body, data);
+        data->env[name] += step;
+      }
+      data->env.erase(name);
+
+      isl_id_free(id);
+      isl_ast_node_free(body);
+      isl_ast_expr_free(inc);
+      isl_ast_expr_free(cond);
+      isl_ast_expr_free(init);
+      isl_ast_expr_free(iterator);
+      break;
+    }
+    case isl_ast_node_if:
+    {
+      isl_ast_expr *cond = isl_ast_node_if_get_cond(node);
+      isl_ast_node *child_node;
+      if (autosa_eval_ast_expr(cond, data->env, &data->error))
+        child_node = isl_ast_node_if_get_then_node(node);
+      else
+        child_node = isl_ast_node_if_get_else_node(node);
+      if (child_node) {
+        count_top_stmts(child_node, data);
+        isl_ast_node_free(child_node);
+      }
+      isl_ast_expr_free(cond);
+      break;
+    }
+    case isl_ast_node_block:
+    {
+      isl_ast_node_list *children = isl_ast_node_block_get_children(node);
+      int n = isl_ast_node_list_n_ast_node(children);
+      for (int i = 0; i < n; i++) {
+        isl_ast_node *child = isl_ast_node_list_get_ast_node(children, i);
+        count_top_stmts(child, data);
+        isl_ast_node_free(child);
+      }
+      isl_ast_node_list_free(children);
+      break;
+    }
+    case isl_ast_node_mark:
+    {
+      isl_ast_node *child = isl_ast_node_mark_get_node(node);
+      count_top_stmts(child, data);
+      isl_ast_node_free(child);
+      break;
+    }
+    case isl_ast_node_user:
+    {
+      isl_id *id = isl_ast_node_get_annotation(node);
+      struct autosa_kernel_stmt *stmt =
+        (struct autosa_kernel_stmt *)isl_id_get_user(id);
+
+      isl_id_free(id);
+      if (stmt->type == AUTOSA_KERNEL_STMT_FIFO_DECL) {
+        struct autosa_hw_module *module = stmt->u.m.module;
+        struct autosa_array_ref_group *group = stmt->u.m.group;
+        long depth = autosa_fifo_decl_inst_depth(stmt, data->env);
+        if (isl_vec_is_zero(group->old_dir) &&
+            module->type == PE_MODULE && group->pe_io_dir == IO_INOUT)
+          data->fifos[depth] += 2;
+        else
+          data->fifos[depth] += 1;
+      } else if (stmt->type == AUTOSA_KERNEL_STMT_MODULE_CALL &&
+                 !stmt->u.m.lower) {
+        std::string name(stmt->u.m.module_name);
+        if (stmt->u.m.boundary)
+          name += "_boundary";
+        data->modules[name]++;
+      }
+      break;
+    }
+    default:
+      data->error = true;
+  }
+}
+
+/* Return the hardware information file given by --AutoSA-hw-info,
+ * defaulting to "autosa_config/hw_info.json" if it exists, or NULL.
+ * The default changes the results of the auto modes, so its use is 
+ * reported once.
+ */
+const char *sa_hw_info_file(struct autosa_options *options)
+{
+  static bool reported = false;
+
+  if (options->hw_info)
+    return options->hw_info;
+  if (access("autosa_config/hw_info.json", R_OK) == 0) {
+    if (!reported) {
+      printf("[AutoSA] No hardware information file is given, "
+             "use autosa_config/hw_info.json.\n");
+      reported = true;
+    }
+    return "autosa_config/hw_info.json";
+  }
+  return NULL;
+}
+
+/* Load the resource budget from the file "hw_info".
+ */
+static cJSON *sa_load_hw_info(const char *hw_info)
+{
+  char *buffer;
+  cJSON *info;
+
+  buffer = ppcg_read_file(hw_info);
+  if (!buffer) {
+    printf("[AutoSA] Error: Can't open the hardware information file: %s\n",
+           hw_info);
+    exit(1);
+  }
+  info = cJSON_Parse(buffer);
+  free(buffer);
+  if (!info) {
+    printf("[AutoSA] Error: Can't parse the hardware information file: %s\n",
+           hw_info);
+    exit(1);
+  }
+
+  return info;
+}
+
+/* Return the parsed hardware information file of "options", or NULL if 
+ * there is none. Each file is parsed once, the returned object is kept 
+ * for the rest of the compilation and should not be freed.
+ */
+cJSON *sa_hw_info(struct autosa_options *options)
+{
+  static std::map<std::string, cJSON *> parsed;
+  const char *hw_info_file = sa_hw_info_file(options);
+  std::map<std::string, cJSON *>::iterator it;
+
+  if (!hw_info_file)
+    return NULL;
+  it = parsed.find(hw_info_file);
+  if (it != parsed.end())
+    return it->second;
+
+  return parsed[hw_info_file] = sa_load_hw_info(hw_info_file);
+}
+
+/* Return the width in bits of the DRAM port of the array "name".
+ * The "port_width" of the hardware information file is either the width
+ * of all the ports, or an object that maps the array names to the widths
+ * of their ports, with "default" for the other arrays.
+ * The ports are 512 bits wide by default.
+ */
+int sa_port_width(struct autosa_options *options, const char *name)
+{
+  cJSON *hw_info = sa_hw_info(options);
+  cJSON *port_width, *item;
+  int width = 512;
+
+  if (!hw_info)
+    return width;
+  port_width = cJSON_GetObjectItemCaseSensitive(hw_info, "port_width");
+  item = port_width;
+  if (cJSON_IsObject(port_width)) {
+    item = cJSON_GetObjectItemCaseSensitive(port_width, name);
+    if (!item)
+      item = cJSON_GetObjectItemCaseSensitive(port_width, "default");
+  }
+  if (cJSON_IsNumber(item))
+    width = item->valueint;
+  if (width < 8 || width > 1024 || width % 8 != 0) {
+    printf("[AutoSA] Error: Unsupported DRAM port width of array %s: %d bits. "
+           "The width should be a multiple of 8 bits up to 1024 bits.\n",
+           name, width);
+    exit(1);
+  }
+
+  return width;
+}
+
+/* Return 1 if the data pack factors are restricted to powers of two
+ * times the SIMD lanes, which is the default. Setting "pow2_data_pack" 
+ * to false in the hardware information file allows any multiple of 
+ * the SIMD lanes, e.g., to fill a DRAM port with 12 floats if the last 
+ * dimension of the buffers is not a multiple of 16.
+ */
+int sa_pow2_data_pack(struct autosa_options *options)
+{
+  cJSON *hw_info = sa_hw_info(options);
+  cJSON *pow2;
+  int ret = 1;
+
+  if (!hw_info)
+    return ret;
+  pow2 = cJSON_GetObjectItemCaseSensitive(hw_info, "pow2_data_pack");
+  if (cJSON_IsBool(pow2))
+    ret = cJSON_IsTrue(pow2);
+
+  return ret;
+}
+
+/* Add the resource usage of "n" instances of the module "name" with
+ * resource usage "res" to "modules" and "total".
+ */
+static void add_module_resource(cJSON *modules, const std::string &name,
+  long n, struct sa_resource *res, struct sa_resource *total)
+{
+  cJSON *module;
+
+  if (n == 0)
+    return;
+  module = sa_resource_to_json(res);
+  cJSON_AddNumberToObject(module, "instances", n);
+  cJSON_AddItemToObject(modules, name.c_str(), module);
+  sa_resource_add(total, res, n);
+}
+
+/* Estimate the on-chip resource usage of the generated array and
+ * check it against the budget in "gen->options->autosa->hw_info".
+ * The module instances and FIFOs are counted from the top module.
+ * The usage of each module and the utilization of the budget are written
+ * to "<output_dir>/resource_est/resource.json".
+ * Return isl_stat_error if the design exceeds the budget.
+ */
+isl_stat sa_estimate_resource(struct autosa_gen *gen)
+{
+  struct autosa_hw_top_module *top = gen->hw_top_module;
+  struct sa_resource_count_data data;
+  struct sa_resource total = {0, 0, 0, 0, 0};
+  cJSON *hw_info, *report, *modules, *fifos, *util;
+  isl_stat ok = isl_stat_ok;
+  long n_fifo = 0;
+  char *json_str;
+  isl_printer *p_str;
+  char *file_path;
+  FILE *fp;
+
+  hw_info = sa_hw_info(gen->options->autosa);
+  data.error = false;
+  report = cJSON_CreateObject();
+  modules = cJSON_CreateObject();
+  fifos = cJSON_CreateObject();
+
+  /* Module instances */
+  for (int i = 0; i < top->n_module_call_wrapped && !data.error; i++)
+    count_top_stmts(top->module_call_wrapped_trees[i], &data);
+  for (int i = 0; i < gen->n_hw_modules; i++) {
+    struct autosa_hw_module *module = gen->hw_modules[i];
+    struct sa_resource res = module_resource(gen, module);
+    std::string name(module->name);
+
+    add_module_resource(modules, name, data.modules[name], &res, &total);
+    add_module_resource(modules, name + "_boundary",
+                        data.modules[name + "_boundary"], &res, &total);
+    for (int j = 0; j < module->n_pe_dummy_modules; j++) {
+      struct autosa_array_ref_group *group =
+        module->pe_dummy_modules[j]->io_group;
+      struct sa_resource dummy = pe_dummy_resource();
+      char *dummy_name;
+
+      p_str = isl_printer_to_str(gen->ctx);
+      p_str = autosa_array_ref_group_print_prefix(group, p_str);
+      p_str = isl_printer_print_str(p_str, "_PE_dummy");
+      dummy_name = isl_printer_get_str(p_str);
+      isl_printer_free(p_str);
+      add_module_resource(modules, dummy_name, data.modules[dummy_name],
+                          &dummy, &total);
+      free(dummy_name);
+    }
+  }
+
+  /* FIFOs, the declaration names are in the format of
+   * [fifo_name].[fifo_width] */
+  for (int i = 0; i < top->n_fifo_decl_wrapped && !data.error; i++) {
+    const char *width = strrchr(top->fifo_decl_names[i], '.');
+
+    data.fifos.clear();
+    count_top_stmts(top->fifo_decl_wrapped_trees[i], &data);
+    for (std::map<long, long>::iterator it = data.fifos.begin(); 
+         it != data.fifos.end(); it++) {
+      struct sa_resource res = 
+        fifo_resource(width ? atol(width + 1) : 0, it->first);
+      sa_resource_add(&total, &res, it->second);
+      n_fifo += it->second;
+    }
+  }
+  cJSON_AddNumberToObject(fifos, "count", n_fifo);
+
+  if (data.error)
+    printf("[AutoSA] Warning: Can't count the module instances of the top "
+           "module. The resource estimate is incomplete.\n");
+
+  cJSON_AddItemToObject(report, "modules", modules);
+  cJSON_AddItemToObject(report, "fifos", fifos);
+  cJSON_AddItemToObject(report, "total", sa_resource_to_json(&total));
+
+  /* Check against the budget */
+  util = cJSON_CreateObject();
+  printf("[AutoSA] Estimated resource usage:");
+  for (int i = 0; i < SA_N_RESOURCE; i++) {
+    const char *name = sa_resource_names[i];
+    cJSON *budget = cJSON_GetObjectItemCaseSensitive(hw_info, name);
+    long used = *sa_resource_field(&total, i);
+    double ratio;
+
+    if (!cJSON_IsNumber(budget))
+      continue;
+    if (budget->valuedouble > 0)
+      ratio = used / budget->valuedouble;
+    else
+      ratio = used > 0 ? 1e9 : 0;
+    cJSON_AddNumberToObject(util, name, ratio);
+    printf(" %s %ld (%.1f%%)", name, used, ratio * 100);
+    if (used > budget->valuedouble)
+      ok = isl_stat_error;
+  }
+  printf("\n");
+  cJSON_AddItemToObject(report, "budget", cJSON_Duplicate(hw_info, 1));
+  cJSON_AddItemToObject(report, "utilization", util);
+  cJSON_AddBoolToObject(report, "fit", ok == isl_stat_ok);
+
+  json_str = cJSON_Print(report);
+  p_str = isl_printer_to_str(gen->ctx);
+  p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
+  p_str = isl_printer_print_str(p_str, "/resource_est/resource.json");
+  file_path = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+  fp = fopen(file_path, "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Cannot open file: %s\n", file_path);
+    exit(1);
+  }
+  fprintf(fp, "%s", json_str);
+  fclose(fp);
+  free(file_path);
+  free(json_str);
+  cJSON_Delete(report);
+
+  return ok;
+}
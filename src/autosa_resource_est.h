@@ -0,0 +1,13 @@
+#ifndef _AUTOSA_RESOURCE_EST_H
+#define _AUTOSA_RESOURCE_EST_H
+
+#include "autosa_common.h"
+
+isl_stat sa_estimate_resource(struct autosa_gen *gen);
+const char *sa_hw_info_file(struct autosa_options *options);
+cJSON *sa_hw_info(struct autosa_options *options);
+int sa_port_width(struct autosa_options *options, const char *name);
+int sa_pow2_data_pack(struct autosa_options *options);
+int sa_kernel_mac_dsp(struct autosa_kernel *kernel);
+
+#endif
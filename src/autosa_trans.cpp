@@ -1,10 +1,21 @@
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "autosa_trans.h"
 #include "autosa_utils.h"
 #include "autosa_schedule_tree.h"
 #include "autosa_comm.h"
 #include "autosa_codegen.h"
+#include "autosa_latency_est.h"
+#include "autosa_resource_est.h"
+#include "autosa_tuning_db.h"
 
 /* A program is legal to be transformed to systolic array if and only if 
  * it satisfies the following constraints:
@@ -70,23 +81,13 @@ static cJSON *load_tuning_config(char *config_file)
   return config;
 }
 
-/* Generate asyncrhonized systolic arrays with the given dimension.
- * For sync arrays, time loops are placed inside the space loops.
- * We will first select space loop candidates from the outermost loop band 
- * which carry dependences with distance less than or equal to 1. 
- * Then we will enumerate different space loop combinations by picking up "dim" 
- * space loops from the candidate pool.
+/* Select the space loop candidates from the permutable band "band".
+ * Space loops carry dependences with distance less or equal to 1.
+ * The returned array has "band_w" entries, set to 1 for candidate loops.
  */
-struct autosa_kernel **sa_space_time_transform_at_dim_async(
-    __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
-    isl_size dim, isl_size *num_sa) 
+static isl_size *sa_space_loop_candidates(__isl_keep isl_schedule_node *band,
+    struct ppcg_scop *scop)
 {
-  struct autosa_kernel **sas = NULL;  
-
-  /* Select space loop candidates.
-   * Space loops carry dependences with distance less or equal to 1.
-   */
-  isl_schedule_node *band = get_outermost_permutable_node(schedule);
   isl_size band_w = isl_schedule_node_band_n_member(band);
   isl_size *is_space_loop = (isl_size *)malloc(band_w * sizeof(isl_size));
   isl_union_map *dep_flow = scop->dep_flow;
@@ -116,307 +117,255 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
     is_space_loop[h] = (n == ndeps);
   }
 
-  /* Perform loop permutation to generate all candidates. */
-  if (dim == 1) {
-    for (int i = 0; i < band_w; i++) {
-      if (is_space_loop[i]) {
-        isl_schedule *new_schedule = isl_schedule_dup(schedule);       
-        /* Make the loop i the outermost loop. */
-        for (int d = i; d > 0; d--) {
-          isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
-          isl_schedule_free(new_schedule);
-          new_schedule = loop_interchange_at_node(band, d, d - 1);
-        }
+  isl_basic_map_list_free(deps);
+  isl_union_map_free(dep_total);
 
-        /* Update the hyperplane types. */
-        struct autosa_kernel *sa = autosa_kernel_from_schedule(new_schedule);
-        sa->scop = scop;
-        sa->type = AUTOSA_SA_TYPE_ASYNC;
-
-        /* Update the array dimension. */
-        sa->n_sa_dim = dim;
-        sa->array_part_w = 0;
-        sa->space_w = dim;
-        // TODO: incorrect, to fix.
-        sa->time_w = band_w - dim;
-
-        /* Add the new variant into the list. */
-        sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
-                sizeof(struct autosa_kernel *));
-        sas[*num_sa] = sa;
-        *num_sa = *num_sa + 1;
-      } 
-    }
-  } else if (dim == 2) {
-    for (int i = 0; i < band_w; i++) {
-      if (is_space_loop[i]) {
-        for (int j = i + 1; j < band_w; j++) {
-          if (is_space_loop[j]) {
-            isl_schedule *new_schedule = isl_schedule_dup(schedule);
-            /* Make the loop i, j the outermost loops. */
-            for (int d = j; d > 0; d--) {
-              isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
-              isl_schedule_free(new_schedule);
-              new_schedule = loop_interchange_at_node(band, d, d - 1);
-            }
-            for (int d = i + 1; d > 0; d--) {
-              isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
-              isl_schedule_free(new_schedule);
-              new_schedule = loop_interchange_at_node(band, d, d - 1);
-            }
+  return is_space_loop;
+}
 
-            /* Update the hyperplane types. */
-            struct autosa_kernel *sa = autosa_kernel_from_schedule(new_schedule);
-            sa->scop = scop;
-            sa->type = AUTOSA_SA_TYPE_ASYNC;
-
-            /* Update the array dimension. */
-            sa->n_sa_dim = dim;
-            sa->array_part_w = 0;
-            sa->space_w = dim;
-            // TODO: incorrect, to fix.
-            sa->time_w = band_w - dim;
-
-            /* Add the new variant into the list. */
-            sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
-                    sizeof(struct autosa_kernel *));
-            sas[*num_sa] = sa;
-            *num_sa = *num_sa + 1;
-          }
-        }
+/* Enumerate all the combinations of "dim" space loops picked from the 
+ * candidate pool "is_space_loop" in lexicographic order.
+ * The loop indices of each combination are appended to "loops".
+ */
+static void sa_space_loop_combinations(isl_size *is_space_loop, 
+    isl_size band_w, isl_size dim, int start, std::vector<int> &prefix,
+    std::vector<int> &loops)
+{
+  if (prefix.size() == dim) {
+    loops.insert(loops.end(), prefix.begin(), prefix.end());
+    return;
+  }
+  for (int i = start; i < band_w; i++) {
+    if (is_space_loop[i]) {
+      prefix.push_back(i);
+      sa_space_loop_combinations(is_space_loop, band_w, dim, i + 1, prefix, 
+          loops);
+      prefix.pop_back();
+    }
+  }
+}
+
+/* Permute the space loops "loops" of the permutable band in "schedule".
+ * For async arrays, the space loops are moved to the outermost positions.
+ * For sync arrays, the space loops are moved to the innermost positions.
+ * The relative order of the space loops is kept.
+ */
+static __isl_give isl_schedule *sa_space_time_permute(
+    __isl_keep isl_schedule *schedule, int type, isl_size band_w, 
+    isl_size dim, const int *loops)
+{
+  isl_schedule *new_schedule = isl_schedule_dup(schedule);
+
+  if (type == AUTOSA_SA_TYPE_ASYNC) {
+    /* Make the loops the outermost loops, starting from the last one. 
+     * Each loop moved to the front shifts the remaining loops by one. 
+     */
+    for (int p = dim - 1; p >= 0; p--) {
+      for (int d = loops[p] + (dim - 1 - p); d > 0; d--) {
+        isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
+        isl_schedule_free(new_schedule);
+        new_schedule = loop_interchange_at_node(band, d, d - 1);
       }
     }
-  } else if (dim == 3) {
-     for (int i = 0; i < band_w; i++) {
-      if (is_space_loop[i]) {
-        for (int j = i + 1; j < band_w; j++) {
-          if (is_space_loop[j]) {
-            for (int k = j + 1; k < band_w; k++) {
-              if (is_space_loop[k]) {
-                isl_schedule *new_schedule = isl_schedule_dup(schedule);
-                /* Make the loop i, j, k the outermost loops. */
-                for (int d = k; d > 0; d--) {
-                  isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
-                  isl_schedule_free(new_schedule);
-                  new_schedule = loop_interchange_at_node(band, d, d - 1);             
-                }
-                for (int d = j + 1; d > 0; d--) {
-                  isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
-                  isl_schedule_free(new_schedule);
-                  new_schedule = loop_interchange_at_node(band, d, d - 1);
-                }
-                for (int d = i + 2; d > 0; d--) {
-                  isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
-                  isl_schedule_free(new_schedule);
-                  new_schedule = loop_interchange_at_node(band, d, d - 1);
-                }
-    
-                /* Update the hyperplane types. */
-                struct autosa_kernel *sa = autosa_kernel_from_schedule(new_schedule);
-                sa->scop = scop;
-                sa->type = AUTOSA_SA_TYPE_ASYNC;
-
-                /* Update the array dimension. */
-                sa->n_sa_dim = dim;
-                sa->array_part_w = 0;
-                sa->space_w = dim;
-                // TODO: incorrect, to fix.
-                sa->time_w = band_w - dim;
-    
-                /* Add the new variant into the list. */
-                sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
-                        sizeof(struct autosa_kernel *));
-                sas[*num_sa] = sa;
-                *num_sa = *num_sa + 1;
-              }
-            }
-          }
-        }
+  } else {
+    /* Make the loops the innermost loops, starting from the first one. 
+     * Each loop moved to the back shifts the remaining loops by one.
+     */
+    for (int p = 0; p < dim; p++) {
+      for (int d = loops[p] - p; d < band_w - 1; d++) {
+        isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
+        isl_schedule_free(new_schedule);
+        new_schedule = loop_interchange_at_node(band, d, d + 1);
       }
-    }   
+    }
   }
 
-  isl_basic_map_list_free(deps);
-  isl_union_map_free(dep_total);
-  isl_schedule_node_free(band);
-  free(is_space_loop);
+  return new_schedule;
+}
 
-  return sas;
+/* Build the candidate schedule of the space loops "loops" in a child 
+ * process and write it in the isl text format to the pipe "fd".
+ * The child inherits the schedule and the isl context of the parent.
+ */
+static void sa_space_time_permute_child(__isl_keep isl_schedule *schedule, 
+    int type, isl_size band_w, isl_size dim, const int *loops, int fd)
+{
+  isl_schedule *new_schedule = sa_space_time_permute(schedule, type, 
+      band_w, dim, loops);
+  char *str = isl_schedule_to_str(new_schedule);
+  size_t len = str ? strlen(str) : 0;
+  size_t done = 0;
+
+  while (done < len) {
+    ssize_t n = write(fd, str + done, len - done);
+    if (n <= 0)
+      _exit(1);
+    done += n;
+  }
+  close(fd);
+  _exit(str ? 0 : 1);
 }
 
-/* Generate syncrhonized systolic arrays with the given dimension.
- * For sync arrays, time loops are placed outside the space loops.
- * We will first select space loop candidates from the innermost loop band 
- * which carry dependences with distance less than or equal to 1. 
- * Then we will enumerate different space loop combinations by picking up "dim" 
- * space loops from the candidate pool.
+/* Read the candidate schedule written by the child process "pid" to 
+ * the pipe "fd" into the context "ctx".
+ * Return NULL if the child failed.
  */
-struct autosa_kernel **sa_space_time_transform_at_dim_sync(
-    __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
-    isl_size dim, isl_size *num_sa)
+static __isl_give isl_schedule *sa_space_time_permute_collect(isl_ctx *ctx,
+    pid_t pid, int fd)
 {
-  struct autosa_kernel **sas = NULL;  
+  std::string str;
+  char buffer[4096];
+  ssize_t n;
+  int ret;
+
+  while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+    str.append(buffer, n);
+  close(fd);
+  if (waitpid(pid, &ret, 0) < 0 || !WIFEXITED(ret) || 
+      WEXITSTATUS(ret) != 0 || str.empty())
+    return NULL;
 
-  /* Select space loop candidates.
-   * Space loops carry dependences with distance less or equal to 1.
-   */
-  isl_schedule_node *band = get_innermost_permutable_node(schedule);
-  isl_size band_w = isl_schedule_node_band_n_member(band);
-  isl_size *is_space_loop = (isl_size *)malloc(band_w * sizeof(isl_size));
-  isl_union_map *dep_flow = scop->dep_flow;
-  isl_union_map *dep_rar = scop->dep_rar;
-  isl_union_map *dep_total = isl_union_map_union(isl_union_map_copy(dep_flow), 
-      isl_union_map_copy(dep_rar));
-  isl_basic_map_list *deps = isl_union_map_get_basic_map_list(dep_total);
-  isl_size ndeps = isl_union_map_n_basic_map(dep_total);
+  return isl_schedule_read_from_str(ctx, str.c_str());
+}
 
-  for (int h = 0; h < band_w; h++) {
-    int n;
-    for (n = 0; n < ndeps; n++) {
-      isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
-      isl_vec *dep_dis = get_dep_dis_at_node(dep, band);
-      isl_val *val = isl_vec_get_element_val(dep_dis, h);
-      if (!(isl_val_is_one(val) || isl_val_is_zero(val))) {
-        isl_vec_free(dep_dis);
-        isl_val_free(val);
-        isl_basic_map_free(dep);
-        break;         
+/* Build the candidate schedules of all the space loop combinations 
+ * "loops" of "dim" loops each.
+ * With "n_jobs" larger than one, each candidate is built in a child 
+ * process, with at most "n_jobs" children running at the same time.
+ * The children return the schedules in the isl text format, which are 
+ * collected by candidate index, so that the candidates are the same as 
+ * in a serial run. The candidates are built before sa_loop_init,
+ * so the AutoSA band properties that the text format drops are still 
+ * at their defaults. A candidate whose child fails is built serially.
+ */
+static std::vector<isl_schedule *> sa_space_time_permute_all(
+    __isl_keep isl_schedule *schedule, int type, isl_size band_w, 
+    isl_size dim, std::vector<int> &loops, int n_jobs)
+{
+  int n = loops.size() / dim;
+  std::vector<isl_schedule *> schedules(n, NULL);
+  std::vector<pid_t> pids(n, -1);
+  std::vector<int> fds(n, -1);
+  isl_ctx *ctx = isl_schedule_get_ctx(schedule);
+  int next = 0;
+
+  if (n_jobs > 1 && n > 1)
+    fflush(NULL);
+  for (int c = 0; c < n; c++) {
+    if (next < c)
+      next = c;
+    /* Launch the children of the next candidates. */
+    while (n_jobs > 1 && n > 1 && next < n && next < c + n_jobs) {
+      int fd[2];
+      pid_t pid;
+
+      if (pipe(fd) < 0)
+        break;
+      pid = fork();
+      if (pid < 0) {
+        close(fd[0]);
+        close(fd[1]);
+        break;
       }
-
-      isl_val_free(val);
-      isl_vec_free(dep_dis);
-      isl_basic_map_free(dep);
+      if (pid == 0) {
+        close(fd[0]);
+        sa_space_time_permute_child(schedule, type, band_w, dim, 
+            &loops[next * dim], fd[1]);
+      }
+      close(fd[1]);
+      pids[next] = pid;
+      fds[next] = fd[0];
+      next++;
     }
-    is_space_loop[h] = (n == ndeps);
+
+    if (fds[c] >= 0)
+      schedules[c] = sa_space_time_permute_collect(ctx, pids[c], fds[c]);
+    if (!schedules[c])
+      schedules[c] = sa_space_time_permute(schedule, type, band_w, dim, 
+          &loops[c * dim]);
   }
 
-  /* Perform loop permutation to generate all candidates. */
-  if (dim == 1) {
-    for (int i = 0; i < band_w; i++) {
-      if (is_space_loop[i]) {
-        isl_schedule *new_schedule = isl_schedule_dup(schedule);       
-        /* Make the loop i the innermost loop. */
-        for (int d = i; d < band_w - 1; d++) {
-          isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
-          isl_schedule_free(new_schedule);
-          new_schedule = loop_interchange_at_node(band, d, d + 1);
-        }
+  return schedules;
+}
 
-        /* Update the hyperplane types. */
-        struct autosa_kernel *sa = autosa_kernel_from_schedule(new_schedule);
-        sa->scop = scop;
-        sa->type = AUTOSA_SA_TYPE_SYNC;
-
-        /* Update the array dimension. */
-        sa->n_sa_dim = dim;
-        sa->array_part_w = 0;
-        sa->space_w = dim;
-        // TODO: this is incorrect, we need to consider other loop bands.
-        sa->time_w = band_w - dim; 
-
-        /* Add the new variant into the list. */
-        sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
-                sizeof(struct autosa_kernel *));
-        sas[*num_sa] = sa;
-        *num_sa = *num_sa + 1;
-      } 
-    }
-  } else if (dim == 2) {
-    for (int i = 0; i < band_w; i++) {
-      if (is_space_loop[i]) {
-        for (int j = i + 1; j < band_w; j++) {
-          if (is_space_loop[j]) {
-            isl_schedule *new_schedule = isl_schedule_dup(schedule);
-            /* Make the loop i, j the innermost loops. */
-            for (int d = i; d < band_w - 1; d++) {
-              isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
-              isl_schedule_free(new_schedule);
-              new_schedule = loop_interchange_at_node(band, d, d + 1);
-            }
-            for (int d = j - 1; d < band_w - 1; d++) {
-              isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
-              isl_schedule_free(new_schedule);
-              new_schedule = loop_interchange_at_node(band, d, d + 1);
-            }
+/* Generate systolic arrays of type "type" with the given dimension.
+ * "band" is the permutable band where the space loops are selected.
+ * We will first select space loop candidates from the band which carry 
+ * dependences with distance less than or equal to 1.
+ * Then we will enumerate different space loop combinations by picking up "dim" 
+ * space loops from the candidate pool.
+ * The candidates are built in parallel with --AutoSA-jobs.
+ */
+static struct autosa_kernel **sa_space_time_transform_at_dim_type(
+    __isl_keep isl_schedule *schedule, __isl_take isl_schedule_node *band,
+    struct ppcg_scop *scop, int type, isl_size dim, isl_size *num_sa)
+{
+  struct autosa_kernel **sas = NULL;
+  isl_size band_w = isl_schedule_node_band_n_member(band);
+  isl_size *is_space_loop = sa_space_loop_candidates(band, scop);
+  std::vector<int> prefix;
+  std::vector<int> loops;
+  std::vector<isl_schedule *> schedules;
 
-            /* Update the hyperplane types. */
-            struct autosa_kernel *sa = autosa_kernel_from_schedule(new_schedule);
-            sa->scop = scop;
-            sa->type = AUTOSA_SA_TYPE_SYNC;
-
-            /* Update the array dimension. */
-            sa->n_sa_dim = dim;
-            sa->array_part_w = 0;
-            sa->space_w = dim;
-            // TODO: incorrect, to fix.
-            sa->time_w = band_w - dim;
-
-            /* Add the new variant into the list. */
-            sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
-                    sizeof(struct autosa_kernel *));
-            sas[*num_sa] = sa;
-            *num_sa = *num_sa + 1;
-          }
-        }
-      }
-    }
-  } else if (dim == 3) {
-     for (int i = 0; i < band_w; i++) {
-      if (is_space_loop[i]) {
-        for (int j = i + 1; j < band_w; j++) {
-          if (is_space_loop[j]) {
-            for (int k = j + 1; k < band_w; k++) {
-              if (is_space_loop[k]) {
-                isl_schedule *new_schedule = isl_schedule_dup(schedule);
-                /* Make the loop i, j, k the innermost loops. */
-                for (int d = i; d < band_w - 1; d++) {
-                  isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
-                  isl_schedule_free(new_schedule);
-                  new_schedule = loop_interchange_at_node(band, d, d + 1);                    
-                }
-                for (int d = j - 1; d < band_w - 1; d++) {
-                  isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
-                  isl_schedule_free(new_schedule);
-                  new_schedule = loop_interchange_at_node(band, d, d + 1);
-                }
-                for (int d = k - 2; d < band_w - 1; d++) {
-                  isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
-                  isl_schedule_free(new_schedule);
-                  new_schedule = loop_interchange_at_node(band, d, d + 1);
-                }
-    
-                /* Update the hyperplane types. */
-                struct autosa_kernel *sa = autosa_kernel_from_schedule(new_schedule);
-                sa->scop = scop;
-                sa->type = AUTOSA_SA_TYPE_SYNC;
-
-                /* Update the array dimension. */
-                sa->n_sa_dim = dim;
-                sa->array_part_w = 0;
-                sa->space_w = dim;
-                sa->time_w = band_w - dim;
-    
-                /* Add the new variant into the list. */
-                sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
-                        sizeof(struct autosa_kernel *));
-                sas[*num_sa] = sa;
-                *num_sa = *num_sa + 1;
-              }
-            }
-          }
-        }
-      }
-    }   
+  sa_space_loop_combinations(is_space_loop, band_w, dim, 0, prefix, loops);
+
+  /* Perform loop permutation to generate all candidates. */
+  schedules = sa_space_time_permute_all(schedule, type, band_w, dim, loops,
+      scop->options->autosa->n_jobs);
+  for (int c = 0; c < schedules.size(); c++) {
+    /* Update the hyperplane types. */
+    struct autosa_kernel *sa = autosa_kernel_from_schedule(schedules[c]);
+    sa->scop = scop;
+    sa->type = type;
+
+    /* Update the array dimension. */
+    sa->n_sa_dim = dim;
+    sa->array_part_w = 0;
+    sa->space_w = dim;
+    // TODO: incorrect, to fix.
+    sa->time_w = band_w - dim;
+
+    /* Add the new variant into the list. */
+    sas = (struct autosa_kernel **)realloc(sas, (*num_sa + 1) * 
+            sizeof(struct autosa_kernel *));
+    sas[*num_sa] = sa;
+    *num_sa = *num_sa + 1;
   }
 
-  isl_basic_map_list_free(deps);
-  isl_union_map_free(dep_total);
   isl_schedule_node_free(band);
   free(is_space_loop);
 
   return sas;
 }
 
+/* Generate asyncrhonized systolic arrays with the given dimension.
+ * For async arrays, time loops are placed inside the space loops.
+ * The space loops are selected from the outermost loop band.
+ */
+struct autosa_kernel **sa_space_time_transform_at_dim_async(
+    __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
+    isl_size dim, isl_size *num_sa) 
+{
+  isl_schedule_node *band = get_outermost_permutable_node(schedule);
+
+  return sa_space_time_transform_at_dim_type(schedule, band, scop, 
+      AUTOSA_SA_TYPE_ASYNC, dim, num_sa);
+}
+
+/* Generate syncrhonized systolic arrays with the given dimension.
+ * For sync arrays, time loops are placed outside the space loops.
+ * The space loops are selected from the innermost loop band.
+ */
+struct autosa_kernel **sa_space_time_transform_at_dim_sync(
+    __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
+    isl_size dim, isl_size *num_sa)
+{
+  isl_schedule_node *band = get_innermost_permutable_node(schedule);
+
+  return sa_space_time_transform_at_dim_type(schedule, band, scop, 
+      AUTOSA_SA_TYPE_SYNC, dim, num_sa);
+}
+
 /* Generate systolic array with "dim" space dimensions. 
  * Depending on the systolic array type set by users, we will generate 
  * async or sync arrays.
@@ -929,6 +878,497 @@ static isl_stat sa_io_update(struct autosa_kernel *sa) {
   return isl_stat_ok;
 }
 
+/* Record the box extents of the array footprint "set" in "user",
+ * indexed by the array name.
+ */
+static isl_stat sa_footprint_extents(__isl_take isl_set *set, void *user)
+{
+  std::map<std::string, std::vector<long> > *extents = 
+    (std::map<std::string, std::vector<long> > *)user;
+  isl_map *map;
+  isl_fixed_box *box;
+
+  if (!isl_set_has_tuple_name(set)) {
+    isl_set_free(set);
+    return isl_stat_ok;
+  }
+  std::string name(isl_set_get_tuple_name(set));
+  map = isl_map_from_range(set);
+  box = isl_map_get_range_simple_fixed_box_hull(map);
+  isl_map_free(map);
+  if (isl_fixed_box_is_valid(box)) {
+    isl_multi_val *size = isl_fixed_box_get_size(box);
+    std::vector<long> ext;
+    for (int i = 0; i < isl_multi_val_size(size); i++) {
+      isl_val *v = isl_multi_val_get_val(size, i);
+      ext.push_back(isl_val_get_num_si(v));
+      isl_val_free(v);
+    }
+    isl_multi_val_free(size);
+    (*extents)[name] = ext;
+  }
+  isl_fixed_box_free(box);
+
+  return isl_stat_ok;
+}
+
+/* Return the schedule of the band "node" on the statement instances
+ * that reach it.
+ */
+static __isl_give isl_union_map *sa_band_domain_schedule(
+  __isl_keep isl_schedule_node *node)
+{
+  isl_union_map *sched;
+  isl_union_pw_multi_aff *contraction;
+
+  sched = isl_schedule_node_band_get_partial_schedule_union_map(node);
+  sched = isl_union_map_intersect_domain(sched, 
+            isl_schedule_node_get_domain(node));
+  contraction = isl_schedule_node_get_subtree_contraction(node);
+  sched = isl_union_map_preimage_domain_union_pw_multi_aff(sched, contraction);
+
+  return sched;
+}
+
+/* Compute the box extents of the data footprint of each array accessed by 
+ * the tile of the band "node" with the tile sizes "tile_size" at the origin.
+ * "sched" maps the statement instances to the band and
+ * "access" maps them to the accessed array elements.
+ */
+static std::map<std::string, std::vector<long> > sa_array_part_footprint(
+  __isl_keep isl_schedule_node *node, __isl_keep isl_union_map *sched,
+  __isl_keep isl_union_map *access, const std::vector<long> &tile_size)
+{
+  std::map<std::string, std::vector<long> > extents;
+  isl_set *tile;
+  isl_union_map *umap;
+  isl_union_set *footprint;
+
+  tile = isl_set_universe(isl_schedule_node_band_get_space(node));
+  for (size_t i = 0; i < tile_size.size(); i++) {
+    tile = isl_set_lower_bound_si(tile, isl_dim_set, i, 0);
+    tile = isl_set_upper_bound_si(tile, isl_dim_set, i, tile_size[i] - 1);
+  }
+  umap = isl_union_map_intersect_range(isl_union_map_copy(sched), 
+            isl_union_set_from_set(tile));
+  footprint = isl_union_set_apply(isl_union_map_domain(umap), 
+                isl_union_map_copy(access));
+  isl_union_set_foreach_set(footprint, &sa_footprint_extents, &extents);
+  isl_union_set_free(footprint);
+
+  return extents;
+}
+
+/* Internal data structure for selecting the array partitioning tile sizes.
+ * "ubs" are the upper bounds of the band members and "divisors" the
+ * candidate tile sizes of each band member.
+ * "space" is set for the band members that are space loops.
+ * "ele_size" is the element size of each array and "port_bytes" the width
+ * of its DRAM port in bytes.
+ * "base" is the footprint extent of each array for a tile of size one,
+ * "slope" the increase of each extent per unit of each tile size and
+ * "full" the extent for the whole band.
+ * "dsp", "bram" are the budgets and "mac_dsp" is the number of DSPs 
+ * used by each PE. "n_buf" is 2 with double buffering.
+ * "best" and "best_score" keep the best feasible tile sizes found so far.
+ */
+struct sa_array_part_auto_data {
+  std::vector<long> ubs;
+  std::vector<std::vector<long> > divisors;
+  std::vector<bool> space;
+  std::map<std::string, int> ele_size;
+  std::map<std::string, int> port_bytes;
+  std::map<std::string, std::vector<long> > base;
+  std::map<std::string, std::vector<std::vector<long> > > slope;
+  std::map<std::string, std::vector<long> > full;
+  long dsp;
+  long bram;
+  long mac_dsp;
+  int n_buf;
+  std::vector<long> best;
+  double best_score;
+  long best_bram;
+};
+
+/* Score the tile sizes "tile".
+ * Each PE runs one iteration per cycle and the tiles are double buffered,
+ * so each tile takes the maximum of its compute time and the time to load
+ * the footprint of its arrays from DRAM. Each array is assumed to have 
+ * its own DRAM port (see sa_port_width) transferring one word per cycle.
+ * Tiles that exceed the DSP or BRAM budget are discarded.
+ */
+static void sa_array_part_auto_score(struct sa_array_part_auto_data *data,
+  const std::vector<long> &tile)
+{
+  long n_pe = 1, n_tile = 1, tile_iter = 1, bits = 0, bram;
+  double mem = 0, score;
+
+  for (size_t i = 0; i < tile.size(); i++) {
+    if (data->space[i])
+      n_pe *= tile[i];
+    n_tile *= (data->ubs[i] + tile[i] - 1) / tile[i];
+    tile_iter *= tile[i];
+  }
+  if (n_pe * data->mac_dsp > data->dsp)
+    return;
+
+  for (auto &it : data->base) {
+    const std::string &name = it.first;
+    long size = 1;
+    for (size_t d = 0; d < it.second.size(); d++) {
+      long ext = it.second[d];
+      for (size_t i = 0; i < tile.size(); i++)
+        ext += data->slope[name][d][i] * (tile[i] - 1);
+      if (data->full.count(name) && d < data->full[name].size())
+        ext = min(ext, data->full[name][d]);
+      size *= ext;
+    }
+    bits += size * data->ele_size[name] * 8 * data->n_buf;
+    mem = max(mem, 
+            (double)size * data->ele_size[name] / data->port_bytes[name]);
+  }
+  bram = (bits + 18 * 1024 - 1) / (18 * 1024);
+  if (bram > data->bram)
+    return;
+
+  score = n_tile * max((double)tile_iter / n_pe, mem);
+  if (data->best.empty() || score < data->best_score ||
+      (score == data->best_score && bram < data->best_bram)) {
+    data->best = tile;
+    data->best_score = score;
+    data->best_bram = bram;
+  }
+}
+
+/* Enumerate the candidate tile sizes of the band members from "pos" on.
+ */
+static void sa_array_part_auto_enumerate(struct sa_array_part_auto_data *data,
+  std::vector<long> &tile, size_t pos)
+{
+  if (pos == data->ubs.size()) {
+    sa_array_part_auto_score(data, tile);
+    return;
+  }
+  for (size_t i = 0; i < data->divisors[pos].size(); i++) {
+    tile.push_back(data->divisors[pos][i]);
+    sa_array_part_auto_enumerate(data, tile, pos + 1);
+    tile.pop_back();
+  }
+}
+
+/* Select the array partitioning tile sizes of the band "node" with 
+ * an analytical model in the auto mode.
+ * The candidates are the divisors of the loop bounds. The on-chip memory
+ * of a candidate is the data footprint of the arrays in a tile and
+ * the off-chip traffic is the footprint of all the tiles. The footprint
+ * extents are affine in the tile sizes, so they are probed once with isl
+ * and then evaluated for each candidate.
+ * The candidate with the lowest estimated latency that fits in the 
+ * DSP and BRAM (and URAM if enabled) budget of the hardware information 
+ * file is selected. The budget is read from --AutoSA-hw-info, 
+ * defaulting to "autosa_config/hw_info.json".
+ * Fall back to the default tile sizes if the model can't be applied.
+ */
+static int *sa_array_part_auto_tile_sizes(struct autosa_kernel *sa,
+  __isl_keep isl_schedule_node *node, int tile_len)
+{
+  struct autosa_options *options = sa->options->autosa;
+  struct sa_array_part_auto_data data;
+  const char *hw_info_file = sa_hw_info_file(options);
+  cJSON *hw_info, *dsp, *bram, *uram;
+  isl_union_map *sched, *accesses;
+  std::vector<long> tile;
+  int *ubs;
+  int *tile_size;
+
+  ubs = extract_band_upper_bounds(sa, node);
+  if (!hw_info_file || !ubs) {
+    printf("[AutoSA] Warning: Can't apply the array partitioning model, "
+           "use the default tile sizes.\n");
+    free(ubs);
+    return read_default_array_part_tile_sizes(sa, tile_len);
+  }
+
+  hw_info = sa_hw_info(options);
+  dsp = cJSON_GetObjectItemCaseSensitive(hw_info, "DSP");
+  bram = cJSON_GetObjectItemCaseSensitive(hw_info, "BRAM");
+  uram = cJSON_GetObjectItemCaseSensitive(hw_info, "URAM");
+  data.dsp = cJSON_IsNumber(dsp) ? (long)dsp->valuedouble : LONG_MAX;
+  data.bram = cJSON_IsNumber(bram) ? (long)bram->valuedouble : LONG_MAX;
+  /* One URAM holds 288Kb, i.e., 16 BRAM18K. */
+  if (options->uram && cJSON_IsNumber(uram) && data.bram != LONG_MAX)
+    data.bram += 16 * (long)uram->valuedouble;
+  data.mac_dsp = max(sa_kernel_mac_dsp(sa), 1);
+  data.n_buf = options->double_buffer ? 2 : 1;
+  for (int i = 0; i < tile_len; i++) {
+    data.ubs.push_back(max(ubs[i], 1));
+    if (sa->type == AUTOSA_SA_TYPE_SYNC)
+      data.space.push_back(i >= tile_len - sa->n_sa_dim);
+    else
+      data.space.push_back(i < sa->n_sa_dim);
+  }
+  free(ubs);
+  /* The candidates are the divisors of the upper bounds. The space loops 
+   * are tiled by at least two, since arrays of size one in any dimension 
+   * are not supported. */
+  data.divisors.resize(tile_len);
+  for (int i = 0; i < tile_len; i++) {
+    for (long t = data.space[i] ? 2 : 1; t <= data.ubs[i]; t++)
+      if (data.ubs[i] % t == 0)
+        data.divisors[i].push_back(t);
+  }
+  for (int i = 0; i < sa->n_array; i++) {
+    const char *name = sa->array[i].array->name;
+    data.ele_size[name] = sa->array[i].array->size;
+    data.port_bytes[name] = sa_port_width(options, name) / 8;
+  }
+
+  /* Probe the footprint extents. */
+  sched = sa_band_domain_schedule(node);
+  accesses = isl_union_map_union(isl_union_map_copy(sa->scop->reads),
+             isl_union_map_copy(sa->scop->may_writes));
+
+  tile.assign(tile_len, 1);
+  data.base = sa_array_part_footprint(node, sched, accesses, tile);
+  data.full = sa_array_part_footprint(node, sched, accesses, data.ubs);
+  for (auto &it : data.base)
+    data.slope[it.first].assign(it.second.size(), 
+                                std::vector<long>(tile_len, 0));
+  for (int i = 0; i < tile_len; i++) {
+    std::map<std::string, std::vector<long> > probe;
+    if (data.ubs[i] < 2)
+      continue;
+    tile.assign(tile_len, 1);
+    tile[i] = 2;
+    probe = sa_array_part_footprint(node, sched, accesses, tile);
+    for (auto &it : data.base) {
+      if (!probe.count(it.first) || 
+          probe[it.first].size() != it.second.size())
+        continue;
+      for (size_t d = 0; d < it.second.size(); d++)
+        data.slope[it.first][d][i] = 
+          max(probe[it.first][d] - it.second[d], 0L);
+    }
+  }
+  isl_union_map_free(sched);
+  isl_union_map_free(accesses);
+
+  /* Search the candidates. */
+  tile.clear();
+  sa_array_part_auto_enumerate(&data, tile, 0);
+  if (data.best.empty()) {
+    printf("[AutoSA] Warning: No array partitioning fits in the budget of %s, "
+           "use the default tile sizes.\n", hw_info_file);
+    return read_default_array_part_tile_sizes(sa, tile_len);
+  }
+
+  tile_size = isl_alloc_array(sa->ctx, int, tile_len);
+  printf("[AutoSA] Array partitioning tile sizes selected by the model:");
+  for (int i = 0; i < tile_len; i++) {
+    tile_size[i] = data.best[i];
+    printf(" %d", tile_size[i]);
+  }
+  printf(" (estimated %.0f cycles, %ld BRAM18K)\n", 
+         data.best_score, data.best_bram);
+  set_sa_used_sizes(sa, "array_part", sa->id, tile_size, tile_len);
+
+  return tile_size;
+}
+
+/* Internal data structure for sa_candidates_model_pick.
+ * "prog" contains the arrays and "root" is the root of the schedule of 
+ * the candidate. "dirs" collects for each array the distinct dependence 
+ * directions on the space loops, the all-zero direction standing for 
+ * the dependences that are not carried by the space loops.
+ */
+struct sa_space_time_model_data {
+  struct autosa_prog *prog;
+  isl_schedule_node *root;
+  std::vector<std::set<std::vector<long> > > dirs;
+};
+
+/* Record the space direction of each dependence in "map" with the array
+ * accessed by its source reference.
+ */
+static isl_bool sa_space_time_model_update(__isl_keep isl_map *map, void *user)
+{
+  struct sa_space_time_model_data *data = 
+    (struct sa_space_time_model_data *)user;
+  isl_basic_map_list *bmap_list = isl_map_get_basic_map_list(map);
+
+  for (int i = 0; i < isl_map_n_basic_map(map); i++) {
+    isl_basic_map *dep = isl_basic_map_list_get_basic_map(bmap_list, i);
+    isl_space *space = isl_space_unwrap(isl_space_domain(
+                         isl_basic_map_get_space(dep)));
+    isl_id *src_id = isl_space_get_tuple_id(space, isl_dim_out);
+    isl_space_free(space);
+    for (int a = 0; a < data->prog->n_array; a++) {
+      struct autosa_array_info *array = &data->prog->array[a];
+      int found = 0;
+      for (int r = 0; r < array->n_ref; r++)
+        if (array->refs[r]->ref_id == src_id)
+          found = 1;
+      if (!found)
+        continue;
+
+      struct dep_space_test_internal_data internal_data = { NULL, dep };
+      std::vector<long> dir;
+      isl_schedule_node_every_descendant(data->root, 
+          &not_carried_at_space, &internal_data);
+      if (internal_data.dirvec) {
+        for (int d = 0; d < isl_vec_size(internal_data.dirvec); d++) {
+          isl_val *val = isl_vec_get_element_val(internal_data.dirvec, d);
+          dir.push_back(isl_val_get_num_si(val));
+          isl_val_free(val);
+        }
+        isl_vec_free(internal_data.dirvec);
+      }
+      data->dirs[a].insert(dir);
+      break;
+    }
+    isl_id_free(src_id);
+    isl_basic_map_free(dep);
+  }
+  isl_basic_map_list_free(bmap_list);
+
+  return isl_bool_true;
+}
+
+/* Select one systolic array design with an analytical cost model.
+ * Each candidate is evaluated with the default array partitioning,
+ * i.e., each loop of the space band tiled by --AutoSA-sa-tile-size:
+ * - PE count: the product of the tile sizes of the space loops.
+ * - I/O module count: the dependences of each array are grouped by their
+ *   direction on the space loops as in the I/O construction. A group 
+ *   carried by the space loops is fed from the boundary of the array, 
+ *   i.e., by one I/O module per PE without a predecessor along the 
+ *   direction. Arrays without such a group are accessed by every PE 
+ *   through its own I/O module.
+ * - Off-chip bytes: the data footprint of each tile, loaded once per tile.
+ * - Latency: each tile takes the maximum of its compute time, with each PE 
+ *   running one iteration per cycle, and the time to load its footprint
+ *   as in the array partitioning model.
+ * The throughput is the inverse of the latency and the resource is the 
+ * number of PEs and I/O modules. The candidate with the highest throughput
+ * per resource is selected, ties broken by the lower latency.
+ * Fall back to sa_candidates_smart_pick if the model can't be applied.
+ */
+struct autosa_kernel *sa_candidates_model_pick(
+  struct autosa_kernel **sa_list, isl_size num_sa, struct autosa_prog *prog)
+{
+  int opt_id = -1;
+  double opt_score = 0, opt_latency = 0;
+  isl_union_map *accesses;
+  std::vector<int> port_bytes;
+
+  assert(num_sa > 0);
+  for (int a = 0; a < prog->n_array; a++)
+    port_bytes.push_back(
+      sa_port_width(prog->scop->options->autosa, prog->array[a].name) / 8);
+  accesses = isl_union_map_union(isl_union_map_copy(prog->scop->reads),
+             isl_union_map_copy(prog->scop->may_writes));
+  for (int i = 0; i < num_sa; i++) {
+    struct autosa_kernel *sa = sa_list[i];
+    struct sa_space_time_model_data data;
+    isl_schedule_node *node;
+    isl_union_map *sched;
+    std::map<std::string, std::vector<long> > footprint;
+    std::vector<long> tile, pe_dims;
+    long n_pe = 1, n_tile = 1, tile_iter = 1, n_io = 0, bytes = 0;
+    double mem = 0, latency, score;
+    int *ubs;
+    int n;
+
+    sa_loop_init(sa);
+    sa_space_time_loop_setup(sa);
+    if (sa->type == AUTOSA_SA_TYPE_SYNC)
+      node = get_innermost_permutable_node(sa->schedule);
+    else
+      node = get_outermost_permutable_node(sa->schedule);
+    ubs = extract_band_upper_bounds(sa, node);
+    if (!ubs) {
+      isl_schedule_node_free(node);
+      isl_union_map_free(accesses);
+      printf("[AutoSA] Warning: Can't apply the space-time cost model, "
+             "use the heuristics.\n");
+      return sa_candidates_smart_pick(sa_list, num_sa);
+    }
+
+    /* Default array partitioning. */
+    n = isl_schedule_node_band_n_member(node);
+    for (int j = 0; j < n; j++) {
+      long t = min(max(ubs[j], 1), 
+                 prog->scop->options->autosa->sa_tile_size);
+      tile.push_back(max(t, 1L));
+      n_tile *= (max(ubs[j], 1) + tile[j] - 1) / tile[j];
+      tile_iter *= tile[j];
+      if (isl_schedule_node_band_member_get_space_time(node, j) == 
+          autosa_loop_space) {
+        pe_dims.push_back(tile[j]);
+        n_pe *= tile[j];
+      }
+    }
+    free(ubs);
+
+    /* I/O group counting. */
+    data.prog = prog;
+    data.root = isl_schedule_get_root(sa->schedule);
+    data.dirs.resize(prog->n_array);
+    isl_union_map_every_map(sa->scop->tagged_dep_rar, 
+        &sa_space_time_model_update, &data);
+    isl_union_map_every_map(sa->scop->tagged_dep_flow, 
+        &sa_space_time_model_update, &data);
+    isl_schedule_node_free(data.root);
+    for (int a = 0; a < prog->n_array; a++) {
+      long n_ext = 0;
+      if (!prog->array[a].accessed || prog->array[a].n_ref == 0)
+        continue;
+      for (auto &dir : data.dirs[a]) {
+        long n_inner = 1;
+        if (std::count(dir.begin(), dir.end(), 0) == (long)dir.size())
+          continue;
+        for (size_t d = 0; d < pe_dims.size() && d < dir.size(); d++)
+          n_inner *= max(pe_dims[d] - std::abs(dir[d]), 0L);
+        n_ext += n_pe - n_inner;
+      }
+      n_io += n_ext > 0 ? n_ext : n_pe;
+    }
+
+    /* Off-chip traffic. */
+    sched = sa_band_domain_schedule(node);
+    footprint = sa_array_part_footprint(node, sched, accesses, tile);
+    isl_union_map_free(sched);
+    isl_schedule_node_free(node);
+    for (int a = 0; a < prog->n_array; a++) {
+      long size = 1;
+      if (!footprint.count(prog->array[a].name))
+        continue;
+      for (long ext : footprint[prog->array[a].name])
+        size *= ext;
+      size *= prog->array[a].size;
+      bytes += size;
+      mem = max(mem, (double)size / port_bytes[a]);
+    }
+
+    latency = n_tile * max((double)tile_iter / n_pe, mem);
+    score = 1.0 / (max(latency, 1.0) * (n_pe + n_io));
+    if (prog->scop->options->autosa->verbose)
+      printf("[AutoSA] Systolic array %d: %ld PEs, %ld I/O modules, "
+             "%ld off-chip bytes, %.0f cycles.\n", 
+             i, n_pe, n_io, n_tile * bytes, latency);
+    if (opt_id < 0 || score > opt_score || 
+        (score == opt_score && latency < opt_latency)) {
+      opt_id = i;
+      opt_score = score;
+      opt_latency = latency;
+    }
+  }
+  isl_union_map_free(accesses);
+
+  printf("[AutoSA] Systolic array %d selected by the cost model.\n", opt_id);
+  return sa_candidates_manual_pick(sa_list, num_sa, opt_id);
+}
+
 /* Apply array partitioning.
  * Apply loop tiling on the band that contains the space loops.
  * In addition, if L2 array partitioning is abled, we will tile the tile loops
@@ -1032,8 +1472,8 @@ isl_stat sa_array_partitioning_optimize(struct autosa_kernel *sa,
     }   
   } else {
     /* Auto mode.
-     * Perform the array partitioning following the default policy. */
-    tile_size = read_default_array_part_tile_sizes(sa, tile_len);
+     * Select the tile sizes with the analytical model. */
+    tile_size = sa_array_part_auto_tile_sizes(sa, node, tile_len);
   }
 
   /* Tile the band. */  
@@ -1517,11 +1957,13 @@ static __isl_give isl_schedule_node *autosa_latency_tile_band_loop(
 struct count_latency_hiding_loop_data {
   int tile_len;
   int *ubs;
+  int *space;
   struct autosa_kernel *kernel;
 };
 
 /* Count the number of latency hiding candidate loops.
- * Extract the loop upper bounds of the candidate loops.
+ * Extract the loop upper bounds of the candidate loops and whether
+ * they are space loops.
  */
 static isl_bool count_latency_hiding_loop(
   __isl_keep isl_schedule_node *node, void *user)
@@ -1547,6 +1989,9 @@ static isl_bool count_latency_hiding_loop(
         int *ubs = extract_band_upper_bounds(data->kernel, node_copy);
         data->ubs = (int *)realloc(data->ubs, sizeof(int) * data->tile_len);      
         data->ubs[data->tile_len - 1] = ubs[0];
+        data->space = (int *)realloc(data->space, sizeof(int) * data->tile_len);
+        data->space[data->tile_len - 1] = 
+          isl_schedule_node_band_member_get_space_time(node, i) == autosa_loop_space;
         isl_schedule_node_free(node_copy);
         free(ubs);
       }
@@ -1556,6 +2001,121 @@ static isl_bool count_latency_hiding_loop(
   return isl_bool_true;
 }
 
+/* Return the latency in cycles of the accumulation in the PEs of "sa".
+ * The latency is taken from the adder of the widest data type, 
+ * assuming the floating-point cores of Xilinx HLS at 300MHz and 
+ * a DSP pipeline for the integer types.
+ */
+static int sa_accumulate_latency(struct autosa_kernel *sa)
+{
+  struct autosa_array_info *widest = NULL;
+
+  for (int i = 0; i < sa->n_array; i++) {
+    struct autosa_array_info *array = sa->array[i].array;
+    if (!widest || array->size > widest->size)
+      widest = array;
+  }
+  if (!widest)
+    return 1;
+  if (!strcmp(widest->type, "double"))
+    return 10;
+  if (!strcmp(widest->type, "float"))
+    return 8;
+  if (!strcmp(widest->type, "half"))
+    return 6;
+  return widest->size > 1 ? 3 : 1;
+}
+
+/* Internal data structure for sa_latency_auto_tile_sizes.
+ * "target" is the latency to cover.
+ * "best" and "best_prod" keep the best latency hiding factors found so far
+ * and their product. "best_n" is the number of loops tiled by "best".
+ */
+struct sa_latency_auto_data {
+  int target;
+  int tile_len;
+  int *ubs;
+  int *space;
+  std::vector<int> best;
+  long best_prod;
+  int best_n;
+};
+
+/* Enumerate the latency hiding factors of the candidate loops from "pos" on.
+ * The factors are divisors of the loop bounds. A space loop keeps at least 
+ * two PEs in its dimension.
+ * The factors with the smallest product that covers the target latency
+ * are kept, preferring the ones that tile fewer loops. If no factors
+ * cover the target, the ones with the largest product are kept.
+ */
+static void sa_latency_auto_enumerate(struct sa_latency_auto_data *data,
+  std::vector<int> &tile, int pos, long prod, int n)
+{
+  if (pos == data->tile_len) {
+    bool covered = prod >= data->target;
+    bool best_covered = data->best_prod >= data->target;
+    if (data->best.empty() ||
+        (covered && !best_covered) ||
+        (covered && (prod < data->best_prod || 
+                     (prod == data->best_prod && n < data->best_n))) ||
+        (!covered && !best_covered && prod > data->best_prod)) {
+      data->best = tile;
+      data->best_prod = prod;
+      data->best_n = n;
+    }
+    return;
+  }
+  for (int f = 1; f <= data->ubs[pos]; f++) {
+    if (data->ubs[pos] % f != 0)
+      continue;
+    if (data->space[pos] && f > 1 && data->ubs[pos] / f < 2)
+      continue;
+    tile.push_back(f);
+    sa_latency_auto_enumerate(data, tile, pos + 1, prod * f, n + (f > 1));
+    tile.pop_back();
+  }
+}
+
+/* Select the latency hiding factors of the candidate loops in the auto mode.
+ * The product of the factors is the number of independent iterations 
+ * interleaved in the PE pipeline, which should cover the accumulation 
+ * latency for the PE to be pipelined with II=1. 
+ * "ubs" are the upper bounds of the candidate loops after array 
+ * partitioning and "space" is set for the space loops.
+ */
+static int *sa_latency_auto_tile_sizes(struct autosa_kernel *sa,
+  int *ubs, int *space, int tile_len)
+{
+  struct sa_latency_auto_data data;
+  std::vector<int> tile;
+  int *tile_size;
+
+  data.target = sa_accumulate_latency(sa);
+  data.tile_len = tile_len;
+  data.ubs = ubs;
+  data.space = space;
+  data.best_prod = 0;
+  data.best_n = 0;
+  sa_latency_auto_enumerate(&data, tile, 0, 1, 0);
+
+  tile_size = isl_alloc_array(sa->ctx, int, tile_len);
+  if (!tile_size)
+    return NULL;
+  printf("[AutoSA] Latency hiding factors selected for the accumulation "
+         "latency of %d cycles:", data.target);
+  for (int i = 0; i < tile_len; i++) {
+    tile_size[i] = data.best[i];
+    printf(" %d", tile_size[i]);
+  }
+  printf("\n");
+  if (data.best_prod < data.target)
+    printf("[AutoSA] Warning: The latency hiding loops can't cover the "
+           "accumulation latency, the PEs may not achieve II=1.\n");
+  set_sa_used_sizes(sa, "latency", sa->id, tile_size, tile_len);
+
+  return tile_size;
+}
+
 /* Perform the latency hiding in either "Manual" or "Auto" mode.
  * We will tile each loop with a tiling factor greater than one, and place
  * the point loop as the innermost time loop. 
@@ -1570,6 +2130,7 @@ static __isl_give isl_schedule_node *autosa_latency_tile_loop(
   struct count_latency_hiding_loop_data data;
   data.tile_len = 0;
   data.ubs = NULL;
+  data.space = NULL;
   data.kernel = sa;
   int i;
   
@@ -1611,11 +2172,12 @@ static __isl_give isl_schedule_node *autosa_latency_tile_loop(
       exit(0);
     }
   } else {
-    /* Perform the latency hiding following the default policy. */
-    tile_size = read_default_latency_tile_sizes(sa, tile_len);
+    /* Select the latency hiding factors to cover the accumulation latency. */
+    tile_size = sa_latency_auto_tile_sizes(sa, data.ubs, data.space, tile_len);
   }
 
   free(data.ubs);
+  free(data.space);
   if (!tile_size) {
     isl_schedule_node_free(node);
     return NULL;
@@ -2196,9 +2758,7 @@ static isl_bool update_simd_acc(__isl_keep isl_schedule_node *node, void *user)
 }
 
 /* This function tiles the SIMD loop.
- * If it is executed in the auto mode, it will select the loop with the 
- * highest score.
- * Otherwise, it will select loops with positive tiling factors.
+ * It will select loops with positive tiling factors.
  * Loops with tiling factors of one or require layout transformation are skipped.
  * At last, it will also update the stride information for the array accesses
  * under the SIMD loop.
@@ -2214,22 +2774,12 @@ static __isl_give isl_schedule_node *autosa_simd_tile_loop(
   if (isl_schedule_node_get_type(node) == isl_schedule_node_band) {
     for (int i = 0; i < isl_schedule_node_band_n_member(node); i++) {
       if (isl_schedule_node_band_member_get_pe_opt(node, i) == autosa_loop_simd) {
-        if (!strcmp(data->mode, "auto")) {
-          /* Perform tiling on the loop with the highest score. */
-          if (data->scores[data->loop_cnt] != data->best_score) { 
-            node = isl_schedule_node_band_member_set_pe_opt(node, i, 
-                      autosa_loop_default);
-            data->loop_cnt++;   
-            continue;
-          }
-        } else {
-          /* Peform tiling on the loop with positive tiling factor */
-          if (data->tile_size[data->loop_cnt] <= 0) {          
-            node = isl_schedule_node_band_member_set_pe_opt(node, i, 
-                      autosa_loop_default);
-            data->loop_cnt++;   
-            continue;
-          }
+        /* Peform tiling on the loop with positive tiling factor */
+        if (data->tile_size[data->loop_cnt] <= 0) {          
+          node = isl_schedule_node_band_member_set_pe_opt(node, i, 
+                    autosa_loop_default);
+          data->loop_cnt++;   
+          continue;
         }
         if (data->tile_size[data->loop_cnt] == 1) {
           /* Skip if the tiling factor is one. */
@@ -2275,6 +2825,73 @@ static __isl_give isl_schedule_node *autosa_simd_tile_loop(
   return node;
 }
 
+/* Select the SIMD loop and the SIMD factor in the auto mode.
+ * Among the candidate loops that don't require layout transformation,
+ * the one with the highest score is selected. The SIMD factor is the
+ * largest divisor of the loop bound such that:
+ * - the SIMD lanes of all the arrays are aligned to their DRAM ports,
+ *   as required by compute_io_group_data_pack;
+ * - the MAC units of all the PEs fit in the DSP budget of the hardware
+ *   information file, if any.
+ * The tiling factor of the other candidate loops is set to -1.
+ * Return NULL if all the candidate loops require layout transformation.
+ */
+static int *sa_simd_auto_tile_sizes(struct autosa_kernel *sa,
+  struct simd_vectorization_data *data)
+{
+  cJSON *hw_info = sa_hw_info(sa->options->autosa);
+  int *tile_size;
+  int sel = -1;
+  int max_n_lane = INT_MAX;
+  int pow2 = sa_pow2_data_pack(sa->options->autosa);
+  long n_pe = 1;
+  long dsp_per_pe = LONG_MAX;
+  int mac_dsp;
+  int w;
+
+  tile_size = isl_alloc_array(sa->ctx, int, data->n_loops);
+  if (!tile_size)
+    return NULL;
+  for (int i = 0; i < data->n_loops; i++) {
+    tile_size[i] = -1;
+    if (data->legal[i] && (sel == -1 || data->scores[i] > data->scores[sel]))
+      sel = i;
+  }
+  if (sel == -1) {
+    printf("[AutoSA] Layout transformation is required to proceed.\n");
+    free(tile_size);
+    return NULL;
+  }
+  if (data->layout_trans)
+    printf("[AutoSA] Select the best loop without layout transformation.\n");
+
+  for (int i = 0; i < sa->n_array; i++) {
+    int port_n_lane = sa_port_width(sa->options->autosa, 
+                        sa->array[i].array->name) / 8 / sa->array[i].array->size;
+    max_n_lane = min(max_n_lane, max(port_n_lane, 1));
+  }
+  if (hw_info) {
+    cJSON *dsp = cJSON_GetObjectItemCaseSensitive(hw_info, "DSP");
+    for (int i = 0; i < sa->n_sa_dim; i++)
+      n_pe *= sa->sa_dim[i];
+    if (cJSON_IsNumber(dsp))
+      dsp_per_pe = (long)dsp->valuedouble / max(n_pe, 1L);
+  }
+  mac_dsp = max(sa_kernel_mac_dsp(sa), 1);
+
+  for (w = min(data->ubs[sel], max_n_lane); w > 1; w--) {
+    if (data->ubs[sel] % w == 0 && (!pow2 || max_n_lane % w == 0) && 
+        (long)w * mac_dsp <= dsp_per_pe)
+      break;
+  }
+  tile_size[sel] = w;
+  printf("[AutoSA] SIMD factor selected for the loop with score %f: %d\n",
+         data->scores[sel], w);
+  set_sa_used_sizes(sa, "simd", sa->id, tile_size, data->n_loops);
+
+  return tile_size;
+}
+
 /* Load the SIMD information for the kernel. 
  */
 static __isl_give char *load_simd_info(struct autosa_kernel *sa)
@@ -2349,9 +2966,10 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
   int n_loops = 0;
   struct simd_vectorization_data data;
   data.best_score = 0;
+  data.layout_trans = 0;
   data.mode = mode;
   data.ubs = NULL;
-  int *tile_size;
+  int *tile_size = NULL;
 
   printf("[AutoSA] Apply SIMD vectorization.\n");
   isl_schedule *schedule = sa->schedule; 
@@ -2391,8 +3009,10 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
   }
   isl_schedule_free(schedule);
 
-  if (!strcmp(mode, "auto") && data.layout_trans) {
-    printf("[AutoSA] Layout transformation is required to proceed.\n");
+  if (!strcmp(mode, "auto"))
+    tile_size = sa_simd_auto_tile_sizes(sa, &data);
+
+  if (!strcmp(mode, "auto") && !tile_size) {
     printf("[AutoSA] SIMD vectorization is skipped.\n");
   } else {
     /* Select the candidate loop with the highest score.
@@ -2473,10 +3093,408 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
   return isl_stat_ok;
 }
 
+/* Names of the PE optimization stages that are checkpointed, in the order
+ * in which they are applied in sa_pe_optimize.
+ */
+static const char *sa_pe_stage_names[] = {"array_part", "latency", "simd"};
+
+/* Version of the checkpoint files. Increase it whenever the content of
+ * the checkpoints or the PE optimization stages change.
+ */
+#define AUTOSA_CHECKPOINT_VERSION 3
+
+/* Record the space_time properties of the band nodes in "user" and clear
+ * them, so that the schedule can be printed in a form that isl can read back.
+ */
+static __isl_give isl_schedule_node *take_space_time_prop(
+  __isl_take isl_schedule_node *node, void *user)
+{
+  std::vector<int> *space_time = (std::vector<int> *)user;
+
+  if (isl_schedule_node_get_type(node) != isl_schedule_node_band)
+    return node;
+  space_time->push_back(isl_schedule_node_band_n_member(node));
+  for (int i = 0; i < isl_schedule_node_band_n_member(node); i++) {
+    space_time->push_back(
+        isl_schedule_node_band_member_get_space_time(node, i));
+    node = isl_schedule_node_band_member_set_space_time(node, i,
+        autosa_loop_default);
+  }
+
+  return node;
+}
+
+/* Data used to restore the space_time properties recorded by 
+ * take_space_time_prop. "pos" is the position of the next entry to read.
+ */
+struct restore_space_time_data {
+  std::vector<int> *space_time;
+  size_t pos;
+  bool error;
+};
+
+static __isl_give isl_schedule_node *restore_space_time_prop(
+  __isl_take isl_schedule_node *node, void *user)
+{
+  struct restore_space_time_data *data = 
+    (struct restore_space_time_data *)user;
+  int n;
+
+  if (isl_schedule_node_get_type(node) != isl_schedule_node_band)
+    return node;
+  n = isl_schedule_node_band_n_member(node);
+  if (data->pos + n + 1 > data->space_time->size() || 
+      (*data->space_time)[data->pos] != n) {
+    data->error = true;
+    return node;
+  }
+  data->pos++;
+  for (int i = 0; i < n; i++) {
+    node = isl_schedule_node_band_member_set_space_time(node, i,
+        (enum autosa_loop_type)(*data->space_time)[data->pos++]);
+  }
+
+  return node;
+}
+
+/* Print "schedule" to a string that can be read back by isl.
+ * The space_time properties of the band nodes, which isl can't read back, 
+ * are stored in "space_time" in the order in which the band nodes are 
+ * visited by isl_schedule_map_schedule_node_bottom_up.
+ */
+static std::string sa_checkpoint_schedule_to_str(
+  __isl_keep isl_schedule *schedule, std::vector<int> &space_time)
+{
+  char *str;
+  std::string ret;
+
+  schedule = isl_schedule_copy(schedule);
+  schedule = isl_schedule_map_schedule_node_bottom_up(
+      schedule, &take_space_time_prop, &space_time);
+  str = isl_schedule_to_str(schedule);
+  ret = str ? str : "";
+  free(str);
+  isl_schedule_free(schedule);
+
+  return ret;
+}
+
+static isl_stat add_map_str(__isl_take isl_map *map, void *user)
+{
+  std::vector<std::string> *strs = (std::vector<std::string> *)user;
+  char *str = isl_map_to_str(map);
+
+  strs->push_back(str ? str : "");
+  free(str);
+  isl_map_free(map);
+
+  return isl_stat_ok;
+}
+
+/* Print the maps in "umap" to a string in sorted order. */
+static std::string sa_checkpoint_umap_to_str(__isl_keep isl_union_map *umap)
+{
+  std::vector<std::string> strs;
+  std::string ret;
+
+  if (!umap)
+    return "NULL\n";
+  isl_union_map_foreach_map(umap, &add_map_str, &strs);
+  std::sort(strs.begin(), strs.end());
+  for (size_t i = 0; i < strs.size(); i++)
+    ret += strs[i] + "\n";
+
+  return ret;
+}
+
+/* Print the sizes of type "type" of the kernel "sa" to a string. */
+static std::string sa_checkpoint_sizes_to_str(struct autosa_kernel *sa, 
+  const char *type)
+{
+  isl_set *size;
+  char *str;
+  std::string ret;
+
+  size = extract_sa_sizes(sa->sizes, type, sa->id);
+  str = isl_set_to_str(size);
+  ret = std::string(type) + ": " + (str ? str : "NULL") + "\n";
+  free(str);
+  isl_set_free(size);
+
+  return ret;
+}
+
+/* Return the hash of the content of the file "name" in hexadecimal,
+ * or "NULL" if there is no such file.
+ */
+static std::string sa_checkpoint_file_hash(const char *name)
+{
+  char hash_str[17];
+  char *content;
+
+  if (!name)
+    return "NULL";
+  content = ppcg_read_file(name);
+  if (!content)
+    return "NULL";
+  snprintf(hash_str, sizeof(hash_str), "%016llx", ppcg_hash_str(content));
+  free(content);
+
+  return hash_str;
+}
+
+/* Compute the keys of the PE optimization stages of "sa".
+ * The key of each stage consists of all the inputs of the stage,
+ * i.e., the key of the previous stage and the tuning mode and
+ * the sizes of the stage itself. The key of the first stage starts 
+ * with the schedule before PE optimization, the dependences and 
+ * the accesses of the program and the options used by the stages.
+ * The SIMD and hardware information files are represented by the hashes 
+ * of their contents, so that editing a file invalidates the checkpoints.
+ * This covers the DRAM port widths and "pow2_data_pack" of the hardware 
+ * information file used by the SIMD and array partitioning stages.
+ */
+static std::vector<std::string> sa_pe_checkpoint_keys(
+  struct autosa_kernel *sa, bool pass_en[], char *pass_mode[])
+{
+  struct autosa_options *options = sa->options->autosa;
+  std::vector<std::string> keys;
+  std::vector<int> space_time;
+  std::string key;
+
+  key = "version: " + std::to_string(AUTOSA_CHECKPOINT_VERSION) + "\n";
+  key += "kernel: " + std::to_string(sa->type) + " " + 
+    std::to_string(sa->n_sa_dim) + " " + std::to_string(sa->space_w) + " " +
+    std::to_string(sa->time_w) + " " + std::to_string(sa->id) + "\n";
+  key += "options: " + std::to_string(options->two_level_buffer) + " " + 
+    std::to_string(options->credit_control) + " " + 
+    std::to_string(options->sa_tile_size) + " " +
+    sa_checkpoint_file_hash(options->simd_info) + " " +
+    sa_checkpoint_file_hash(sa_hw_info_file(options)) + " " +
+    std::to_string(options->uram) + " " + 
+    std::to_string(options->double_buffer) + "\n";
+  key += "schedule: " + sa_checkpoint_schedule_to_str(sa->schedule, space_time);
+  key += "\nspace_time:";
+  for (size_t i = 0; i < space_time.size(); i++)
+    key += " " + std::to_string(space_time[i]);
+  key += "\ndep_flow:\n" + sa_checkpoint_umap_to_str(sa->scop->dep_flow);
+  key += "dep_rar:\n" + sa_checkpoint_umap_to_str(sa->scop->dep_rar);
+  key += "dep_waw:\n" + sa_checkpoint_umap_to_str(sa->scop->dep_waw);
+  key += "reads:\n" + sa_checkpoint_umap_to_str(sa->scop->reads);
+  key += "writes:\n" + sa_checkpoint_umap_to_str(sa->scop->may_writes);
+
+  /* Array partitioning */
+  key += std::string("array_part: ") + std::to_string(pass_en[0]) + " " + 
+    pass_mode[0] + " " + std::to_string(pass_en[1]) + " " + pass_mode[1] + "\n";
+  key += sa_checkpoint_sizes_to_str(sa, "array_part");
+  key += sa_checkpoint_sizes_to_str(sa, "array_part_L2");
+  keys.push_back(key);
+  /* Latency hiding */
+  key += std::string("latency: ") + std::to_string(pass_en[2]) + " " + 
+    pass_mode[2] + "\n";
+  key += sa_checkpoint_sizes_to_str(sa, "latency");
+  keys.push_back(key);
+  /* SIMD vectorization */
+  key += std::string("simd: ") + std::to_string(pass_en[3]) + " " + 
+    pass_mode[3] + "\n";
+  key += sa_checkpoint_sizes_to_str(sa, "simd");
+  keys.push_back(key);
+
+  return keys;
+}
+
+/* Return the name of the checkpoint file of the stage "stage" with key "key".
+ * The file name contains the 64-bit FNV-1a hash of the key.
+ */
+static std::string sa_pe_checkpoint_file(struct autosa_kernel *sa, int stage,
+  const std::string &key)
+{
+  char hash_str[17];
+
+  snprintf(hash_str, sizeof(hash_str), "%016llx", 
+           ppcg_hash_str(key.c_str()));
+
+  return std::string(sa->options->autosa->checkpoint_dir) + "/" + 
+    sa_pe_stage_names[stage] + "_" + hash_str + ".json";
+}
+
+/* Save the state of "sa" after the PE optimization stage "stage"
+ * with key "key" to the checkpoint directory. 
+ * The state consists of the schedule, the systolic array dimensions,
+ * the latency hiding and SIMD factors, the two-level buffering option,
+ * which is turned off by the array partitioning if it is not applicable,
+ * and the tile sizes used so far.
+ * The checkpoint is written to a temporary file first and then renamed,
+ * so that runs sharing the checkpoint directory never see a partial file.
+ * Failure to write the checkpoint is not fatal.
+ */
+static void sa_pe_checkpoint_save(struct autosa_kernel *sa, int stage, 
+  const std::string &key)
+{
+  std::string path = sa_pe_checkpoint_file(sa, stage, key);
+  std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  std::vector<int> space_time;
+  std::string schedule;
+  cJSON *checkpoint, *array;
+  char *content;
+  FILE *fp;
+
+  schedule = sa_checkpoint_schedule_to_str(sa->schedule, space_time);
+
+  checkpoint = cJSON_CreateObject();
+  cJSON_AddStringToObject(checkpoint, "key", key.c_str());
+  cJSON_AddStringToObject(checkpoint, "schedule", schedule.c_str());
+  array = cJSON_CreateArray();
+  for (size_t i = 0; i < space_time.size(); i++)
+    cJSON_AddItemToArray(array, cJSON_CreateNumber(space_time[i]));
+  cJSON_AddItemToObject(checkpoint, "space_time", array);
+  array = cJSON_CreateArray();
+  for (int i = 0; i < sa->n_sa_dim; i++)
+    cJSON_AddItemToArray(array, cJSON_CreateNumber(sa->sa_dim[i]));
+  cJSON_AddItemToObject(checkpoint, "sa_dim", array);
+  cJSON_AddNumberToObject(checkpoint, "lat_hide_len", sa->lat_hide_len);
+  cJSON_AddNumberToObject(checkpoint, "simd_w", sa->simd_w);
+  cJSON_AddNumberToObject(checkpoint, "two_level_buffer", 
+      sa->options->autosa->two_level_buffer);
+  if (sa->used_sizes) {
+    char *used_sizes = isl_union_map_to_str(sa->used_sizes);
+    cJSON_AddStringToObject(checkpoint, "used_sizes", used_sizes);
+    free(used_sizes);
+  }
+  content = cJSON_Print(checkpoint);
+  cJSON_Delete(checkpoint);
+
+  if (mkdir(sa->options->autosa->checkpoint_dir, 0755) < 0 && 
+      errno != EEXIST) {
+    printf("[AutoSA] Warning: Can't create the checkpoint directory: %s\n",
+           sa->options->autosa->checkpoint_dir);
+    free(content);
+    return;
+  }
+  fp = fopen(tmp_path.c_str(), "w");
+  if (!fp) {
+    printf("[AutoSA] Warning: Can't write the checkpoint: %s\n", 
+           tmp_path.c_str());
+    free(content);
+    return;
+  }
+  fprintf(fp, "%s", content);
+  free(content);
+  if (fclose(fp) != 0 || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    printf("[AutoSA] Warning: Can't write the checkpoint: %s\n", path.c_str());
+    remove(tmp_path.c_str());
+  }
+}
+
+/* Load the state of "sa" after the PE optimization stage "stage" with
+ * key "key" from the checkpoint directory.
+ * Return isl_bool_true if the state is restored, and isl_bool_false 
+ * if there is no valid checkpoint, in which case "sa" is left untouched.
+ *
+ * The identifiers in the schedule that is read back have no user pointers.
+ * The checkpoint is only used if the statement domain of the restored 
+ * schedule is the same as that of the current schedule, which fails 
+ * if any identifier in the domain carries a user pointer.
+ */
+static isl_bool sa_pe_checkpoint_load(struct autosa_kernel *sa, int stage,
+  const std::string &key)
+{
+  std::string path = sa_pe_checkpoint_file(sa, stage, key);
+  cJSON *checkpoint, *item, *sa_dim_json, *space_time_json;
+  cJSON *lat_hide_len_json, *simd_w_json, *two_level_buffer_json;
+  std::vector<int> space_time;
+  struct restore_space_time_data data;
+  isl_schedule *schedule;
+  isl_union_set *domain, *old_domain;
+  isl_bool equal;
+  char *buffer;
+
+  buffer = ppcg_read_file(path.c_str());
+  if (!buffer)
+    return isl_bool_false;
+  checkpoint = cJSON_Parse(buffer);
+  free(buffer);
+  if (!checkpoint)
+    return isl_bool_false;
+
+  item = cJSON_GetObjectItemCaseSensitive(checkpoint, "key");
+  if (!cJSON_IsString(item) || key != item->valuestring) {
+    cJSON_Delete(checkpoint);
+    return isl_bool_false;
+  }
+  item = cJSON_GetObjectItemCaseSensitive(checkpoint, "schedule");
+  sa_dim_json = cJSON_GetObjectItemCaseSensitive(checkpoint, "sa_dim");
+  space_time_json = cJSON_GetObjectItemCaseSensitive(checkpoint, "space_time");
+  lat_hide_len_json = cJSON_GetObjectItemCaseSensitive(
+      checkpoint, "lat_hide_len");
+  simd_w_json = cJSON_GetObjectItemCaseSensitive(checkpoint, "simd_w");
+  two_level_buffer_json = cJSON_GetObjectItemCaseSensitive(
+      checkpoint, "two_level_buffer");
+  if (!cJSON_IsString(item) || !cJSON_IsArray(sa_dim_json) || 
+      !cJSON_IsArray(space_time_json) ||
+      cJSON_GetArraySize(sa_dim_json) != sa->n_sa_dim ||
+      !cJSON_IsNumber(lat_hide_len_json) || !cJSON_IsNumber(simd_w_json) ||
+      !cJSON_IsNumber(two_level_buffer_json)) {
+    cJSON_Delete(checkpoint);
+    return isl_bool_false;
+  }
+
+  schedule = isl_schedule_read_from_str(sa->ctx, item->valuestring);
+  if (!schedule) {
+    cJSON_Delete(checkpoint);
+    return isl_bool_false;
+  }
+  domain = isl_schedule_get_domain(schedule);
+  old_domain = isl_schedule_get_domain(sa->schedule);
+  equal = isl_union_set_is_equal(domain, old_domain);
+  isl_union_set_free(domain);
+  isl_union_set_free(old_domain);
+  if (equal != isl_bool_true) {
+    isl_schedule_free(schedule);
+    cJSON_Delete(checkpoint);
+    return isl_bool_false;
+  }
+
+  cJSON_ArrayForEach(item, space_time_json) {
+    space_time.push_back(item->valueint);
+  }
+  data.space_time = &space_time;
+  data.pos = 0;
+  data.error = false;
+  schedule = isl_schedule_map_schedule_node_bottom_up(
+      schedule, &restore_space_time_prop, &data);
+  if (data.error || data.pos != space_time.size()) {
+    isl_schedule_free(schedule);
+    cJSON_Delete(checkpoint);
+    return isl_bool_false;
+  }
+
+  isl_schedule_free(sa->schedule);
+  sa->schedule = schedule;
+  for (int i = 0; i < sa->n_sa_dim; i++) 
+    sa->sa_dim[i] = cJSON_GetArrayItem(sa_dim_json, i)->valueint;
+  sa->lat_hide_len = lat_hide_len_json->valueint;
+  sa->simd_w = simd_w_json->valueint;
+  sa->options->autosa->two_level_buffer = two_level_buffer_json->valueint;
+  item = cJSON_GetObjectItemCaseSensitive(checkpoint, "used_sizes");
+  if (cJSON_IsString(item)) {
+    isl_union_map_free(sa->used_sizes);
+    sa->used_sizes = isl_union_map_read_from_str(sa->ctx, item->valuestring);
+  }
+  cJSON_Delete(checkpoint);
+
+  return isl_bool_true;
+}
+
 /* Apply PE optimization including:
  * - latency hiding
  * - SIMD vectorization
  * - array partitioning
+ *
+ * If a checkpoint directory is specified, the state of the kernel is saved
+ * after each stage. Before applying the stages, we look for the deepest 
+ * stage whose inputs are unchanged from a previous run and resume from 
+ * its checkpoint.
  */
 isl_stat sa_pe_optimize(struct autosa_kernel *sa, bool pass_en[], char *pass_mode[])
 {
@@ -2504,13 +3522,46 @@ isl_stat sa_pe_optimize(struct autosa_kernel *sa, bool pass_en[], char *pass_mod
   isl_union_set *domain = isl_schedule_get_domain(sa->schedule);
   sa->core = isl_union_set_universe(domain);
 
+  /* Resume from the checkpoint of the deepest unchanged stage. */
+  std::vector<std::string> keys;
+  int n_stage = pass_en[3] ? 3 : 2;
+  int start = 0;
+  if (sa->options->autosa->checkpoint_dir) {
+    keys = sa_pe_checkpoint_keys(sa, pass_en, pass_mode);
+    for (int i = n_stage - 1; i >= 0; i--) {
+      if (sa_pe_checkpoint_load(sa, i, keys[i]) == isl_bool_true) {
+        printf("[AutoSA] Resume PE optimization after the %s stage from the checkpoint.\n",
+               sa_pe_stage_names[i]);
+        start = i + 1;
+        break;
+      }
+    }
+  }
+
   /* Array partitioning. */
-  sa_array_partitioning_optimize(sa, pass_en[0], pass_mode[0], pass_en[1], pass_mode[1]);
+  if (start <= 0) {
+    autosa_profile_begin("array_partitioning");
+    sa_array_partitioning_optimize(sa, pass_en[0], pass_mode[0], pass_en[1], pass_mode[1]);
+    autosa_profile_end();
+    if (!keys.empty())
+      sa_pe_checkpoint_save(sa, 0, keys[0]);
+  }
   /* Latency hiding. */
-  sa_latency_hiding_optimize(sa, pass_en[2], pass_mode[2]);
+  if (start <= 1) {
+    autosa_profile_begin("latency_hiding");
+    sa_latency_hiding_optimize(sa, pass_en[2], pass_mode[2]);
+    autosa_profile_end();
+    if (!keys.empty())
+      sa_pe_checkpoint_save(sa, 1, keys[1]);
+  }
   /* SIMD vectorization. */
-  if (pass_en[3])
+  if (pass_en[3] && start <= 2) {
+    autosa_profile_begin("simd_vectorization");
     sa_simd_vectorization_optimize(sa, pass_mode[3]);
+    autosa_profile_end();
+    if (!keys.empty())
+      sa_pe_checkpoint_save(sa, 2, keys[2]);
+  }
 
   return isl_stat_ok;
 }
@@ -2691,6 +3742,7 @@ isl_stat sa_comm_management(struct autosa_kernel *sa, struct autosa_gen *gen)
   printf("[AutoSA] Apply communication management.\n");
 
   sa_io_construct_optimize(sa, gen);
+  sa_stream_order(sa, gen);
   
   return isl_stat_ok;
 }
@@ -2834,7 +3886,9 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
   /* Generate systolic arrays using space-time mapping. */
   schedule = isl_schedule_node_get_schedule(node);
   isl_schedule_node_free(node);
+  autosa_profile_begin("space_time_transform");
   sa_candidates = sa_space_time_transform(schedule, gen->prog->scop, &num_sa);
+  autosa_profile_end();
   if (num_sa > 0)
     printf("[AutoSA] %d systolic arrays generated.\n", num_sa);
   space_time_json = cJSON_GetObjectItemCaseSensitive(gen->tuning_config, "space_time");
@@ -2842,9 +3896,18 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
   space_time_mode = space_time_mode_json->valuestring;
   if (!strcmp(space_time_mode, "auto")) {
     /* Space-time transformation is set in AUTO mode. We will pick up
-     * one systolic array to proceed based on heuristics. 
+     * one systolic array to proceed from the tuning database if any,
+     * or based on the cost model or heuristics. 
      */
-    kernel = sa_candidates_smart_pick(sa_candidates, num_sa);
+    int kernel_id = -1;
+    if (gen->options->autosa->tuning_db)
+      kernel_id = sa_tuning_db_pick_space_time(gen, num_sa);
+    if (kernel_id >= 0)
+      kernel = sa_candidates_manual_pick(sa_candidates, num_sa, kernel_id);
+    else if (gen->options->autosa->space_time_model)
+      kernel = sa_candidates_model_pick(sa_candidates, num_sa, gen->prog);
+    else
+      kernel = sa_candidates_smart_pick(sa_candidates, num_sa);
   } else {
     /* Space-time transformation is set in MANUAL mode. We will take the user
      * specification to select one systolic array to proceed.
@@ -2924,7 +3987,9 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
   pe_opt_mode[2] = latency_mode_json->valuestring;
   pe_opt_mode[3] = simd_mode_json->valuestring;
 
+  autosa_profile_begin("pe_optimize");
   sa_pe_optimize(kernel, pe_opt_en, pe_opt_mode);
+  autosa_profile_end();
 
   /* Create the autosa_kernel object and attach to the schedule. */
   if (!kernel) {
@@ -3013,7 +4078,9 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
   kernel->schedule = isl_schedule_node_get_schedule(node);
 
   /* Communication Management */
+  autosa_profile_begin("comm_management");
   sa_comm_management(kernel, gen);
+  autosa_profile_end();
 
   /* Localize the array bounds using parameters from the host domain. */
   localize_bounds(kernel, host_domain);
@@ -3391,10 +4458,12 @@ __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
   isl_schedule *hw_schedule;
   struct autosa_kernel *kernel;
   isl_id *id;
-  cJSON *tuning_config = NULL;
+  cJSON *tuning_config = gen->tuning_config;
 
-  /* Load the tuning configuration file */
-  tuning_config = load_tuning_config(gen->options->autosa->config);
+  /* Load the tuning configuration file, unless it is already kept in memory
+   * by the compile server. */
+  if (!tuning_config)
+    tuning_config = load_tuning_config(gen->options->autosa->config);
   if (!tuning_config) {
     isl_schedule_free(schedule);
     printf("[AutoSA] Error: AutoSA configuration file not found: %s\n", 
@@ -3426,7 +4495,9 @@ __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
 
   /* Perform compute and comm optimization.
    */
+  autosa_profile_begin("compute_and_comm_optimize");
   node = compute_and_comm_optimize(gen, node);
+  autosa_profile_end();
   
   id = isl_schedule_node_mark_get_id(node);
   kernel = (struct autosa_kernel *)isl_id_get_user(id);
@@ -3434,7 +4505,9 @@ __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
   schedule = isl_schedule_node_get_schedule(node);
 
   /* Generate hw modules in the systolic array. */
+  autosa_profile_begin("generate_hw_modules");
   generate_hw_modules(schedule, gen, kernel);
+  autosa_profile_end();
 
   /* Add copy statements for the default schedule (used for correctness verification). */
   node = sa_add_copies(gen, node); 
@@ -3458,6 +4531,318 @@ __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
   return gen->schedule;
 }
 
+/* Read the design points from the sweep file "path".
+ * Each line contains one "sa_sizes" string, e.g.,
+ * {kernel[0]->space_time[3];kernel[0]->array_part[16,16,16]}
+ * Empty lines and lines starting with "#" are skipped.
+ */
+static std::vector<std::string> read_sa_sizes_sweep(const char *path)
+{
+  std::vector<std::string> points;
+  FILE *fp;
+  char *line = NULL;
+  size_t cap = 0;
+
+  fp = fopen(path, "r");
+  if (!fp) {
+    printf("[AutoSA] Error: Can't open the sweep file: %s\n", path);
+    exit(1);
+  }
+  while (getline(&line, &cap, fp) > 0) {
+    std::string point(line);
+    size_t start = point.find_first_not_of(" \t\r\n");
+    size_t end = point.find_last_not_of(" \t\r\n");
+    if (start == std::string::npos || point[start] == '#')
+      continue;
+    points.push_back(point.substr(start, end - start + 1));
+  }
+  free(line);
+  fclose(fp);
+
+  return points;
+}
+
+/* Create the output directory "dir" of a single design point, together with 
+ * the sub-directories expected by the code generator.
+ */
+static void sa_sweep_make_output_dir(const char *dir)
+{
+  const char *sub_dirs[] = {"", "/src", "/latency_est", "/resource_est"};
+
+  for (int i = 0; i < 4; i++) {
+    std::string path = std::string(dir) + sub_dirs[i];
+    if (mkdir(path.c_str(), 0755) < 0 && errno != EEXIST) {
+      printf("[AutoSA] Error: Can't create the directory: %s\n", path.c_str());
+      exit(1);
+    }
+  }
+}
+
+/* Fork a child process that compiles the design point with the tile sizes 
+ * "sa_sizes" into the output directory "output_dir".
+ * The child inherits the scop, the dependences and the schedule computed 
+ * so far. It updates the options, redirects the output files to 
+ * "output_dir" and continues with the remaining compilation stages.
+ *
+ * Return 0 in the child and the process id of the child in the parent.
+ */
+static pid_t sa_fork_design_point(struct autosa_gen *gen, const char *sa_sizes,
+  const char *output_dir)
+{
+  struct autosa_options *options = gen->options->autosa;
+  pid_t pid;
+
+  if (!gen->redirect) {
+    printf("[AutoSA] Error: Multiple design points are not supported for "
+           "this target.\n");
+    exit(1);
+  }
+
+  sa_sweep_make_output_dir(output_dir);
+  /* Flush all the output streams so that the child doesn't print
+   * the buffered content again. */
+  fflush(NULL);
+  pid = fork();
+  if (pid < 0) {
+    printf("[AutoSA] Error: Failed to fork design point: %s\n", output_dir);
+    exit(1);
+  }
+  if (pid == 0) {
+    if (options->verbose)
+      printf("[AutoSA] Design point: %s\n", sa_sizes ? sa_sizes : "");
+    options->sa_sizes = sa_sizes ? strdup(sa_sizes) : NULL;
+    options->output_dir = strdup(output_dir);
+    gen->redirect(gen->print_user, options->output_dir);
+  }
+
+  return pid;
+}
+
+/* Dump the status of all the design points of the sweep to 
+ * "output_dir/sweep.json".
+ */
+static void sa_sweep_dump_status(struct autosa_gen *gen,
+  std::vector<std::string> &points, std::vector<std::string> &dirs,
+  std::vector<int> &status)
+{
+  cJSON *sweep, *points_json;
+  FILE *fp;
+  char *content;
+  isl_printer *p_str;
+  char *sweep_path;
+
+  sweep = cJSON_CreateObject();
+  points_json = cJSON_CreateArray();
+  cJSON_AddItemToObject(sweep, "points", points_json);
+  for (int i = 0; i < points.size(); i++) {
+    cJSON *point = cJSON_CreateObject();
+    cJSON_AddItemToObject(point, "id", cJSON_CreateNumber(i));
+    cJSON_AddItemToObject(point, "sa_sizes", 
+        cJSON_CreateString(points[i].c_str()));
+    cJSON_AddItemToObject(point, "output_dir", 
+        cJSON_CreateString(dirs[i].c_str()));
+    cJSON_AddItemToObject(point, "status", cJSON_CreateNumber(status[i]));
+    cJSON_AddItemToArray(points_json, point);
+  }
+
+  p_str = isl_printer_to_str(gen->ctx);
+  p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
+  p_str = isl_printer_print_str(p_str, "/sweep.json");
+  sweep_path = isl_printer_get_str(p_str);
+  fp = fopen(sweep_path, "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Can't open the sweep status file: %s\n", 
+        sweep_path);
+    exit(1);
+  }
+  content = cJSON_Print(sweep);
+  fprintf(fp, "%s", content);
+  fclose(fp);
+  free(content);
+  cJSON_Delete(sweep);
+  isl_printer_free(p_str);
+  free(sweep_path);
+}
+
+/* Compile all the design points listed in the file 
+ * "gen->options->autosa->sa_sizes_sweep".
+ * The scop, the dependences and the schedule "schedule" are computed only 
+ * once. For each design point, we fork a child process that inherits 
+ * this state, updates the "sa_sizes" and the output directory 
+ * "output_dir/point_<id>", redirects the output files and continues 
+ * with the remaining compilation stages. 
+ * At most "sweep_jobs" design points are compiled at the same time.
+ *
+ * This function only returns in the child processes.
+ * The parent process waits for all the design points, dumps their exit 
+ * status to "output_dir/sweep.json", discards its own partial output 
+ * files and exits.
+ */
+static void sa_sweep(struct autosa_gen *gen, __isl_keep isl_schedule *schedule)
+{
+  struct autosa_options *options = gen->options->autosa;
+  std::vector<std::string> points = read_sa_sizes_sweep(options->sa_sizes_sweep);
+  std::vector<std::string> dirs;
+  std::vector<int> status(points.size(), -1);
+  std::vector<pid_t> pids(points.size(), -1);
+  int n_jobs = options->sweep_jobs > 1 ? options->sweep_jobs : 1;
+  int n_running = 0;
+  int n_failed = 0;
+
+  printf("[AutoSA] Sweep %d design points.\n", (int)points.size());
+  for (int i = 0; i < points.size(); i++) {
+    dirs.push_back(std::string(options->output_dir) + "/point_" + 
+        std::to_string(i));
+  }
+
+  for (int i = 0; i <= points.size(); i++) {
+    /* Wait for a running design point if all the jobs are occupied,
+     * or for all of them after the last design point is launched. */
+    while (n_running > 0 && (n_running >= n_jobs || i == points.size())) {
+      int ret;
+      pid_t pid = wait(&ret);
+      if (pid < 0)
+        break;
+      for (int j = 0; j < i; j++) {
+        if (pids[j] == pid) {
+          status[j] = WIFEXITED(ret) ? WEXITSTATUS(ret) : -1;
+          if (status[j] != 0)
+            n_failed++;
+        }
+      }
+      n_running--;
+    }
+    if (i == points.size())
+      break;
+
+    pids[i] = sa_fork_design_point(gen, points[i].c_str(), dirs[i].c_str());
+    if (pids[i] == 0)
+      return;
+    n_running++;
+  }
+
+  sa_sweep_dump_status(gen, points, dirs, status);
+  /* The output files opened in "output_dir/src" by the parent only hold 
+   * the headers printed before the sweep. */
+  gen->redirect(gen->print_user, NULL);
+  printf("[AutoSA] Sweep completed: %d/%d design points succeeded.\n", 
+      (int)points.size() - n_failed, (int)points.size());
+  exit(0);
+}
+
+/* Answer a single request "line" of the compile server.
+ * The request is a JSON object with the optional fields
+ * - "sa_sizes": the tile sizes of the design point
+ * - "output_dir": the output directory, default "output_dir/request_<id>"
+ * The design point is compiled in a child process. The response contains 
+ * the request id, the exit status of the child, the output directory and,
+ * if the child stopped at a manual tuning step, the content of "tuning.json".
+ *
+ * Return 0 in the child and 1 in the parent.
+ */
+static int sa_serve_request(struct autosa_gen *gen, const char *line, int id)
+{
+  cJSON *request, *response, *sa_sizes_json, *output_dir_json;
+  const char *sa_sizes = NULL;
+  std::string output_dir;
+  std::string tuning_path;
+  char *content;
+  pid_t pid;
+  int ret;
+  int status;
+
+  response = cJSON_CreateObject();
+  cJSON_AddItemToObject(response, "id", cJSON_CreateNumber(id));
+  request = cJSON_Parse(line);
+  if (!request || !cJSON_IsObject(request)) {
+    cJSON_AddItemToObject(response, "status", cJSON_CreateNumber(-1));
+    cJSON_AddItemToObject(response, "error", 
+        cJSON_CreateString("invalid request"));
+  } else {
+    sa_sizes_json = cJSON_GetObjectItemCaseSensitive(request, "sa_sizes");
+    if (cJSON_IsString(sa_sizes_json))
+      sa_sizes = sa_sizes_json->valuestring;
+    output_dir_json = cJSON_GetObjectItemCaseSensitive(request, "output_dir");
+    if (cJSON_IsString(output_dir_json))
+      output_dir = output_dir_json->valuestring;
+    else
+      output_dir = std::string(gen->options->autosa->output_dir) + 
+                     "/request_" + std::to_string(id);
+    tuning_path = output_dir + "/tuning.json";
+    unlink(tuning_path.c_str());
+
+    pid = sa_fork_design_point(gen, sa_sizes, output_dir.c_str());
+    if (pid == 0) {
+      /* Keep the standard output free for the responses. */
+      dup2(STDERR_FILENO, STDOUT_FILENO);
+      cJSON_Delete(request);
+      cJSON_Delete(response);
+      return 0;
+    }
+    status = -1;
+    if (waitpid(pid, &ret, 0) == pid && WIFEXITED(ret))
+      status = WEXITSTATUS(ret);
+
+    cJSON_AddItemToObject(response, "status", cJSON_CreateNumber(status));
+    cJSON_AddItemToObject(response, "output_dir", 
+        cJSON_CreateString(output_dir.c_str()));
+    if (access(tuning_path.c_str(), F_OK) == 0) {
+      cJSON *tuning = load_tuning_config(&tuning_path[0]);
+      if (tuning)
+        cJSON_AddItemToObject(response, "tuning", tuning);
+    }
+  }
+
+  content = cJSON_PrintUnformatted(response);
+  fprintf(stdout, "%s\n", content);
+  fflush(stdout);
+  free(content);
+  cJSON_Delete(response);
+  cJSON_Delete(request);
+
+  return 1;
+}
+
+/* Run the compile server.
+ * The scop, the dependences, the schedule "schedule" and the tuning 
+ * configuration are kept in memory, while the requests are read from 
+ * the standard input, one JSON object per line. 
+ * Each request is answered with one JSON object per line on the standard
+ * output. See sa_serve_request for the format.
+ *
+ * This function only returns in the child processes that compile 
+ * the design points. The server exits at the end of the input.
+ */
+static void sa_serve(struct autosa_gen *gen, __isl_keep isl_schedule *schedule)
+{
+  char *line = NULL;
+  size_t cap = 0;
+  int id = 0;
+
+  /* Load the tuning configuration once for all the requests. */
+  gen->tuning_config = load_tuning_config(gen->options->autosa->config);
+  if (!gen->tuning_config) {
+    printf("[AutoSA] Error: AutoSA configuration file not found: %s\n", 
+      gen->options->autosa->config);
+    exit(1);
+  }
+
+  fprintf(stderr, "[AutoSA] Compile server ready.\n");
+  while (getline(&line, &cap, stdin) > 0) {
+    if (strspn(line, " \t\r\n") == strlen(line))
+      continue;
+    if (!sa_serve_request(gen, line, id)) {
+      free(line);
+      return;
+    }
+    id++;
+  }
+
+  free(line);
+  cJSON_Delete(gen->tuning_config);
+  exit(0);
+}
+
 /* Generate HLS code for "scop" and print it to "p".
  * After generating an AST for the transformed scop as explained below,
  * we call "gen->print" to print the AST in the desired output format 
@@ -3528,11 +4913,18 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
     return isl_printer_free(p);
 
   gen->prog = prog;
+  if (options->autosa->profile)
+    autosa_profile_enable(options->autosa);
+
   /* Scheduling */
+  autosa_profile_begin("scheduling");
   schedule = get_schedule(gen); 
+  autosa_profile_end();
 
   /* Legality check */
+  autosa_profile_begin("legality_check");
   isl_bool is_legal = sa_legality_check(schedule, scop);
+  autosa_profile_end();
   if (is_legal < 0 || !is_legal) {
     if (is_legal < 0)
       p = isl_printer_free(p);
@@ -3540,23 +4932,40 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
       p = print_cpu(p, scop, options);
     isl_schedule_free(schedule);
   } else {
+    /* In the server and sweep modes, each design point continues from here 
+     * in a separate process. */
+    if (options->autosa->serve)
+      sa_serve(gen, schedule);
+    else if (options->autosa->sa_sizes_sweep)
+      sa_sweep(gen, schedule);
+
     /* Perform opt. stages:
      * Computation Management -> Communication Management     
      */    
+    autosa_profile_begin("map_to_device");
     gen->schedule = sa_map_to_device(gen, schedule);
+    autosa_profile_end();
 
     /* Generate the AST tree. */    
+    autosa_profile_begin("generate_code");
     gen->tree = sa_generate_code(gen, gen->schedule);
+    autosa_profile_end();
+    autosa_profile_begin("module_generate_code");
     for (int i = 0; i < gen->n_hw_modules; i++) {
+      autosa_profile_begin(gen->hw_modules[i]->name);
       if (gen->hw_modules[i]->is_filter == 1 && 
           gen->hw_modules[i]->is_buffer == 1) {
         sa_filter_buffer_io_module_generate_code(gen, gen->hw_modules[i]);
       } else {
         sa_module_generate_code(gen, gen->hw_modules[i]); 
       }
+      autosa_profile_end();
     }
+    autosa_profile_end();
+    autosa_profile_begin("top_module_generate_code");
     sa_top_module_generate_code(gen);
-
+    autosa_profile_end();
+    autosa_profile_begin("extract_info");
     /* Extract loop structure for latency estimation */
     for (int i = 0; i < gen->n_hw_modules; i++) {
       sa_extract_loop_info(gen, gen->hw_modules[i]);
@@ -3565,12 +4974,44 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
     sa_extract_array_info(gen->kernel);
     /* Extract design information for resource estimation */
     sa_extract_design_info(gen);
+    autosa_profile_end();
+    if (gen->options->autosa->fifo_sizing || 
+        gen->options->autosa->fifo_depth_file) {
+      /* Size the FIFOs from the loop structures of the modules */
+      autosa_profile_begin("fifo_sizing");
+      sa_size_fifos(gen);
+      autosa_profile_end();
+    }
+    if (gen->options->autosa->hw_info) {
+      /* Reject the design early if it doesn't fit on the FPGA */
+      autosa_profile_begin("resource_check");
+      isl_stat fit = sa_estimate_resource(gen);
+      autosa_profile_end();
+      if (fit != isl_stat_ok) {
+        printf("[AutoSA] Error: The design exceeds the resource budget "
+               "in %s.\n", gen->options->autosa->hw_info);
+        if (gen->options->autosa->tuning_db)
+          sa_tuning_db_record(gen);
+        exit(1);
+      }
+    }
+
+    if (gen->options->autosa->estimate) {
+      autosa_profile_begin("estimate");
+      sa_estimate_latency(gen);
+      autosa_profile_end();
+    }
+    if (gen->options->autosa->tuning_db)
+      sa_tuning_db_record(gen);
 
     /* Code generation */
+    autosa_profile_begin("print");
     p = ppcg_set_macro_names(p);
     p = ppcg_print_exposed_declarations(p, prog->scop);
     p = gen->print(p, gen->prog, gen->tree, gen->hw_modules, gen->n_hw_modules, 
           gen->hw_top_module, &gen->types, gen->print_user);
+    autosa_profile_end();
+    autosa_profile_dump();
     
     /* Clean up */
     isl_ast_node_free(gen->tree);
@@ -3606,7 +5047,8 @@ int generate_sa(isl_ctx *ctx, const char *input, FILE *out,
     struct autosa_prog *prog, __isl_keep isl_ast_node *trees, 
     struct autosa_hw_module **modules, int n_module,
     struct autosa_hw_top_module *module,
-    struct autosa_types *types, void *user), void *user)
+    struct autosa_types *types, void *user), void *user,
+  void (*redirect)(void *user, const char *output_dir))
 {
   struct autosa_gen gen;  
   int r;
@@ -3618,6 +5060,7 @@ int generate_sa(isl_ctx *ctx, const char *input, FILE *out,
   gen.kernel_id = 0;
   gen.print = print;
   gen.print_user = user;
+  gen.redirect = redirect;
   gen.types.n = 0;
   gen.types.name = NULL;
   gen.hw_modules = NULL;
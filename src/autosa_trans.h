@@ -30,7 +30,8 @@ int generate_sa(isl_ctx *ctx, const char *input, FILE *out,
     struct autosa_prog *prog, __isl_keep isl_ast_node *tree, 
     struct autosa_hw_module **modules, int n_modules,
     struct autosa_hw_top_module *top_module,
-    struct autosa_types *types, void *user), void *user);
+    struct autosa_types *types, void *user), void *user,
+  void (*redirect)(void *user, const char *output_dir));
 __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
     __isl_take isl_schedule *schedule);
 isl_bool sa_legality_check(__isl_keep isl_schedule *schedule, struct ppcg_scop *scop);
@@ -47,6 +48,8 @@ struct autosa_kernel **sa_space_time_transform_at_dim(
     isl_size dim, isl_size *num_sa);
 struct autosa_kernel *sa_candidates_smart_pick(
     struct autosa_kernel **sa_list, __isl_keep isl_size num_sa);
+struct autosa_kernel *sa_candidates_model_pick(
+    struct autosa_kernel **sa_list, isl_size num_sa, struct autosa_prog *prog);
 struct autosa_kernel *sa_candidates_manual_pick(
     struct autosa_kernel **sa_list, isl_size num_sa, int sa_id);
 struct autosa_kernel **sa_space_time_transform(
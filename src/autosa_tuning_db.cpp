@@ -0,0 +1,313 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include <isl/ctx.h>
+
+#include "autosa_tuning_db.h"
+#include "autosa_resource_est.h"
+
+/* The tuning database is a file with one JSON object per line, one for
+ * each compiled design. Each design is keyed by
+ * - "scop": a hash of the context, the iteration domain and the accesses
+ *   of the program,
+ * - "shape": the same hash with all the numbers abstracted away, which 
+ *   matches programs with the same loop structure but different sizes,
+ * - "hw": a hash of the hardware information file.
+ * The "source" of a record is "estimated" for the records written by AutoSA,
+ * with the latency estimated by --AutoSA-estimate, and "measured" for the
+ * records with a "measured" latency added by autosa_tuner.py.
+ * Records are appended with a single write, so that several AutoSA 
+ * processes can share the same database.
+ */
+
+/* Compute the 64-bit FNV-1a hash of "str" in hexadecimal.
+ */
+static std::string tuning_db_hash(const std::string &str)
+{
+  char buf[17];
+
+  snprintf(buf, sizeof(buf), "%016llx", ppcg_hash_str(str.c_str()));
+
+  return std::string(buf);
+}
+
+/* Append the string representation of "obj" printed by "print" to "str".
+ */
+template <typename T>
+static void tuning_db_append(std::string &str, T *obj, char *(*print)(T *))
+{
+  char *s = obj ? print(obj) : NULL;
+
+  if (s)
+    str += s;
+  str += "\n";
+  free(s);
+}
+
+/* Return the canonical representation of the program of "gen".
+ */
+static std::string tuning_db_scop_str(struct autosa_gen *gen)
+{
+  struct ppcg_scop *scop = gen->prog->scop;
+  std::string str;
+
+  tuning_db_append(str, scop->context, &isl_set_to_str);
+  tuning_db_append(str, scop->domain, &isl_union_set_to_str);
+  tuning_db_append(str, scop->reads, &isl_union_map_to_str);
+  tuning_db_append(str, scop->may_writes, &isl_union_map_to_str);
+  tuning_db_append(str, scop->must_writes, &isl_union_map_to_str);
+
+  return str;
+}
+
+/* Replace each number in "str" by "N".
+ */
+static std::string tuning_db_shape_str(const std::string &str)
+{
+  std::string shape;
+
+  for (size_t i = 0; i < str.size(); i++) {
+    if (isdigit(str[i])) {
+      if (i == 0 || !isdigit(str[i - 1]))
+        shape += 'N';
+    } else {
+      shape += str[i];
+    }
+  }
+
+  return shape;
+}
+
+/* Return the canonical representation of the hardware information file,
+ * or "none" if there is none.
+ */
+static std::string tuning_db_hw_str(struct autosa_options *options)
+{
+  const char *hw_info_file = sa_hw_info_file(options);
+  cJSON *hw_info;
+  char *content;
+  std::string str;
+
+  if (!hw_info_file)
+    return "none";
+  hw_info = sa_hw_info(options);
+  content = cJSON_PrintUnformatted(hw_info);
+  str = content;
+  free(content);
+
+  return str;
+}
+
+/* Print the tile sizes used by "kernel" in the format of --sa-sizes.
+ */
+static std::string tuning_db_sa_sizes(struct autosa_kernel *kernel)
+{
+  const char *types[] = {"array_part", "array_part_L2", "latency", "simd", 
+                         "hbm"};
+  std::string str = "{kernel[0]->space_time[" + 
+                    std::to_string(kernel->space_time_id) + "]";
+
+  for (int i = 0; i < 5; i++) {
+    isl_set *size;
+    int n;
+
+    if (!kernel->used_sizes)
+      break;
+    size = extract_sa_sizes(kernel->used_sizes, types[i], kernel->id);
+    n = isl_set_dim(size, isl_dim_set);
+    if (n > 0) {
+      str += std::string(";kernel[0]->") + types[i] + "[";
+      for (int j = 0; j < n; j++) {
+        isl_val *v = isl_set_plain_get_val_if_fixed(size, isl_dim_set, j);
+        if (j > 0)
+          str += ",";
+        str += std::to_string(isl_val_get_num_si(v));
+        isl_val_free(v);
+      }
+      str += "]";
+    }
+    isl_set_free(size);
+  }
+  str += "}";
+
+  return str;
+}
+
+/* Add the field "field" of the JSON file "path" to "entry" under "name",
+ * if the file exists.
+ */
+static void tuning_db_add_file(cJSON *entry, const char *name, 
+  const std::string &path, const char *field)
+{
+  cJSON *content, *item;
+  char *buffer;
+
+  buffer = ppcg_read_file(path.c_str());
+  if (!buffer)
+    return;
+  content = cJSON_Parse(buffer);
+  free(buffer);
+
+  item = cJSON_GetObjectItemCaseSensitive(content, field);
+  if (item)
+    cJSON_AddItemToObject(entry, name, cJSON_Duplicate(item, 1));
+  cJSON_Delete(content);
+}
+
+/* Append the design compiled by "gen" to the tuning database.
+ * Besides the keys, the record contains the tile sizes, the array 
+ * configuration and, if they have been computed, the estimated latency,
+ * resource usage and whether the design fits in the budget.
+ * Failure to write the record is not fatal.
+ */
+void sa_tuning_db_record(struct autosa_gen *gen)
+{
+  struct autosa_options *options = gen->options->autosa;
+  struct autosa_kernel *kernel = gen->kernel;
+  std::string scop = tuning_db_scop_str(gen);
+  std::string output_dir = options->output_dir;
+  cJSON *entry, *sa_dim;
+  char *content;
+  std::string line;
+  int fd;
+
+  entry = cJSON_CreateObject();
+  cJSON_AddStringToObject(entry, "scop", tuning_db_hash(scop).c_str());
+  cJSON_AddStringToObject(entry, "shape", 
+      tuning_db_hash(tuning_db_shape_str(scop)).c_str());
+  cJSON_AddStringToObject(entry, "hw", 
+      tuning_db_hash(tuning_db_hw_str(options)).c_str());
+  cJSON_AddStringToObject(entry, "source", "estimated");
+  cJSON_AddStringToObject(entry, "output_dir", output_dir.c_str());
+  cJSON_AddStringToObject(entry, "sa_sizes", 
+      tuning_db_sa_sizes(kernel).c_str());
+  cJSON_AddNumberToObject(entry, "space_time", kernel->space_time_id);
+  cJSON_AddStringToObject(entry, "sa_type", 
+      kernel->type == AUTOSA_SA_TYPE_SYNC ? "sync" : "async");
+  sa_dim = cJSON_CreateArray();
+  for (int i = 0; i < kernel->n_sa_dim; i++)
+    cJSON_AddItemToArray(sa_dim, cJSON_CreateNumber(kernel->sa_dim[i]));
+  cJSON_AddItemToObject(entry, "sa_dim", sa_dim);
+  cJSON_AddNumberToObject(entry, "lat_hide_len", kernel->lat_hide_len);
+  cJSON_AddNumberToObject(entry, "simd_w", kernel->simd_w);
+  cJSON_AddNumberToObject(entry, "data_pack", options->data_pack);
+  cJSON_AddNumberToObject(entry, "double_buffer", options->double_buffer);
+  cJSON_AddNumberToObject(entry, "two_level_buffer", options->two_level_buffer);
+  cJSON_AddNumberToObject(entry, "burst_buffer", options->burst_buffer);
+  cJSON_AddNumberToObject(entry, "uram", options->uram);
+  if (options->estimate)
+    tuning_db_add_file(entry, "latency", 
+        output_dir + "/latency_est/latency.json", "latency");
+  if (options->hw_info) {
+    tuning_db_add_file(entry, "resource", 
+        output_dir + "/resource_est/resource.json", "total");
+    tuning_db_add_file(entry, "fit", 
+        output_dir + "/resource_est/resource.json", "fit");
+  }
+
+  content = cJSON_PrintUnformatted(entry);
+  line = std::string(content) + "\n";
+  free(content);
+  cJSON_Delete(entry);
+
+  fd = open(options->tuning_db, O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0 || write(fd, line.c_str(), line.size()) != (ssize_t)line.size())
+    printf("[AutoSA] Warning: Can't write to the tuning database: %s\n",
+           options->tuning_db);
+  if (fd >= 0)
+    close(fd);
+}
+
+/* Return the objective of the record "entry", i.e., the measured latency
+ * of the "measured" records and the estimated latency of the others.
+ * Store 1 in "measured" for the "measured" records and 0 otherwise.
+ * Return -1 if the record has no objective or the design doesn't fit 
+ * in the budget.
+ */
+static double tuning_db_objective(cJSON *entry, int *measured)
+{
+  cJSON *fit = cJSON_GetObjectItemCaseSensitive(entry, "fit");
+  cJSON *source = cJSON_GetObjectItemCaseSensitive(entry, "source");
+  cJSON *latency;
+
+  *measured = cJSON_IsString(source) && 
+              !strcmp(source->valuestring, "measured");
+  latency = cJSON_GetObjectItemCaseSensitive(entry, 
+              *measured ? "measured" : "latency");
+  if (cJSON_IsFalse(fit))
+    return -1;
+  if (cJSON_IsNumber(latency))
+    return latency->valuedouble;
+  return -1;
+}
+
+/* Select the space-time transformation of the program of "gen" with
+ * "n_kernel" candidates from the tuning database.
+ * The best record on the same hardware for the same program is used.
+ * If there is none, the best record for a program of the same shape
+ * is used. Return -1 if there is no such record.
+ * Measured and estimated latencies are not comparable, so the best
+ * measured record is used if there is one, and the best estimated
+ * record otherwise.
+ */
+int sa_tuning_db_pick_space_time(struct autosa_gen *gen, int n_kernel)
+{
+  struct autosa_options *options = gen->options->autosa;
+  std::string scop_str = tuning_db_scop_str(gen);
+  std::string scop = tuning_db_hash(scop_str);
+  std::string shape = tuning_db_hash(tuning_db_shape_str(scop_str));
+  std::string hw = tuning_db_hash(tuning_db_hw_str(options));
+  double best[2][2] = {{-1, -1}, {-1, -1}};
+  int best_id[2][2] = {{-1, -1}, {-1, -1}};
+  char *line = NULL;
+  size_t cap = 0;
+  FILE *fp;
+
+  fp = fopen(options->tuning_db, "r");
+  if (!fp)
+    return -1;
+  while (getline(&line, &cap, fp) > 0) {
+    cJSON *entry = cJSON_Parse(line);
+    cJSON *scop_json = cJSON_GetObjectItemCaseSensitive(entry, "scop");
+    cJSON *shape_json = cJSON_GetObjectItemCaseSensitive(entry, "shape");
+    cJSON *hw_json = cJSON_GetObjectItemCaseSensitive(entry, "hw");
+    cJSON *id_json = cJSON_GetObjectItemCaseSensitive(entry, "space_time");
+    int measured;
+    double objective = tuning_db_objective(entry, &measured);
+    int match = -1;
+
+    if (cJSON_IsString(hw_json) && hw == hw_json->valuestring &&
+        cJSON_IsNumber(id_json) && id_json->valueint >= 0 &&
+        id_json->valueint < n_kernel && objective >= 0) {
+      if (cJSON_IsString(scop_json) && scop == scop_json->valuestring)
+        match = 0;
+      else if (cJSON_IsString(shape_json) && shape == shape_json->valuestring)
+        match = 1;
+    }
+    if (match >= 0 && (best_id[match][measured] < 0 || 
+                       objective < best[match][measured])) {
+      best[match][measured] = objective;
+      best_id[match][measured] = id_json->valueint;
+    }
+    cJSON_Delete(entry);
+  }
+  free(line);
+  fclose(fp);
+
+  for (int i = 0; i < 2; i++) {
+    for (int m = 1; m >= 0; m--) {
+      if (best_id[i][m] >= 0) {
+        printf("[AutoSA] Space-time transformation %d selected from the "
+               "tuning database (%s program, %s latency).\n", best_id[i][m], 
+               i == 0 ? "same" : "similar", m ? "measured" : "estimated");
+        return best_id[i][m];
+      }
+    }
+  }
+
+  return -1;
+}
@@ -0,0 +1,9 @@
+#ifndef _AUTOSA_TUNING_DB_H
+#define _AUTOSA_TUNING_DB_H
+
+#include "autosa_common.h"
+
+void sa_tuning_db_record(struct autosa_gen *gen);
+int sa_tuning_db_pick_space_time(struct autosa_gen *gen, int n_kernel);
+
+#endif
@@ -1,5 +1,16 @@
 #include <assert.h>
+#include <ctype.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <isl/aff.h>
+#include <isl/ast_build.h>
+#include <isl/set.h>
 
 #include "autosa_utils.h"
 
@@ -276,4 +287,672 @@ int suffixcmp(const char *s, const char *suffix)
     return 1;
   else
     return strncmp(s + start, suffix, strlen(suffix));
-}
\ No newline at end of file
+}
+
+/* Internal data structure for autosa_ast_expr_simplify.
+ * "ids" are the identifiers that appear in the expression. They are 
+ * treated as parameters of the affine expression.
+ * "context" collects the constraints under which the C semantics of
+ * the integer divisions and remainders in the expression coincide with 
+ * the floor semantics of isl, i.e., that their dividends are non-negative.
+ */
+struct autosa_ast_expr_simplify_data {
+  std::vector<isl_id *> ids;
+  isl_set *context;
+};
+
+/* Collect the identifiers in "expr" into "data->ids".
+ */
+static void collect_ast_expr_ids(__isl_keep isl_ast_expr *expr,
+  struct autosa_ast_expr_simplify_data *data)
+{
+  if (isl_ast_expr_get_type(expr) == isl_ast_expr_id) {
+    isl_id *id = isl_ast_expr_get_id(expr);
+    for (size_t i = 0; i < data->ids.size(); i++) {
+      if (data->ids[i] == id) {
+        isl_id_free(id);
+        return;
+      }
+    }
+    data->ids.push_back(id);
+  } else if (isl_ast_expr_get_type(expr) == isl_ast_expr_op) {
+    int n = isl_ast_expr_op_get_n_arg(expr);
+    for (int i = 0; i < n; i++) {
+      isl_ast_expr *arg = isl_ast_expr_op_get_arg(expr, i);
+      collect_ast_expr_ids(arg, data);
+      isl_ast_expr_free(arg);
+    }
+  }
+}
+
+/* Return the positive integer value of the constant "aff",
+ * or NULL if "aff" is not such a constant.
+ */
+static __isl_give isl_val *aff_get_positive_int(__isl_keep isl_aff *aff)
+{
+  isl_val *val;
+
+  if (isl_aff_is_cst(aff) != isl_bool_true)
+    return NULL;
+  val = isl_aff_get_constant_val(aff);
+  if (isl_val_is_int(val) != isl_bool_true || 
+      isl_val_is_pos(val) != isl_bool_true)
+    return isl_val_free(val);
+
+  return val;
+}
+
+/* Convert the quasi-affine AST expression "expr" into an isl_aff over 
+ * the parameter space "space".
+ * Return NULL if "expr" is not quasi-affine.
+ */
+static __isl_give isl_aff *ast_expr_to_aff(__isl_keep isl_ast_expr *expr,
+  __isl_keep isl_space *space, struct autosa_ast_expr_simplify_data *data)
+{
+  isl_local_space *ls = isl_local_space_from_space(isl_space_copy(space));
+  enum isl_ast_expr_type type = isl_ast_expr_get_type(expr);
+  isl_aff *arg0, *arg1;
+  isl_val *val;
+  int n;
+
+  if (type == isl_ast_expr_int)
+    return isl_aff_val_on_domain(ls, isl_ast_expr_get_val(expr));
+  if (type == isl_ast_expr_id) {
+    isl_id *id = isl_ast_expr_get_id(expr);
+    int pos = isl_space_find_dim_by_id(space, isl_dim_param, id);
+    isl_id_free(id);
+    return isl_aff_var_on_domain(ls, isl_dim_param, pos);
+  }
+  isl_local_space_free(ls);
+  if (type != isl_ast_expr_op)
+    return NULL;
+
+  n = isl_ast_expr_op_get_n_arg(expr);
+  if (n < 1 || n > 2)
+    return NULL;
+  isl_ast_expr *arg = isl_ast_expr_op_get_arg(expr, 0);
+  arg0 = ast_expr_to_aff(arg, space, data);
+  isl_ast_expr_free(arg);
+  arg1 = NULL;
+  if (n == 2) {
+    arg = isl_ast_expr_op_get_arg(expr, 1);
+    arg1 = ast_expr_to_aff(arg, space, data);
+    isl_ast_expr_free(arg);
+  }
+  if (!arg0 || (n == 2 && !arg1)) {
+    isl_aff_free(arg0);
+    isl_aff_free(arg1);
+    return NULL;
+  }
+
+  switch (isl_ast_expr_op_get_type(expr)) {
+    case isl_ast_expr_op_minus:
+      return isl_aff_neg(arg0);
+    case isl_ast_expr_op_add:
+      return isl_aff_add(arg0, arg1);
+    case isl_ast_expr_op_sub:
+      return isl_aff_sub(arg0, arg1);
+    case isl_ast_expr_op_mul:
+      if (isl_aff_is_cst(arg0) == isl_bool_true || 
+          isl_aff_is_cst(arg1) == isl_bool_true)
+        return isl_aff_mul(arg0, arg1);
+      break;
+    case isl_ast_expr_op_div:
+    case isl_ast_expr_op_pdiv_q:
+    case isl_ast_expr_op_fdiv_q:
+      val = aff_get_positive_int(arg1);
+      if (!val)
+        break;
+      isl_aff_free(arg1);
+      if (isl_ast_expr_op_get_type(expr) != isl_ast_expr_op_fdiv_q)
+        data->context = isl_set_intersect(data->context,
+                          isl_set_from_basic_set(
+                            isl_aff_nonneg_basic_set(isl_aff_copy(arg0))));
+      return isl_aff_floor(isl_aff_scale_down_val(arg0, val));
+    case isl_ast_expr_op_pdiv_r:
+    case isl_ast_expr_op_zdiv_r:
+      val = aff_get_positive_int(arg1);
+      if (!val)
+        break;
+      isl_aff_free(arg1);
+      data->context = isl_set_intersect(data->context,
+                        isl_set_from_basic_set(
+                          isl_aff_nonneg_basic_set(isl_aff_copy(arg0))));
+      return isl_aff_mod_val(arg0, val);
+    default:
+      break;
+  }
+
+  isl_aff_free(arg0);
+  isl_aff_free(arg1);
+  return NULL;
+}
+
+/* Does "expr" only consist of the operations that can be printed 
+ * as plain C integer arithmetic, i.e., without "floord", "min" or "max"?
+ * Store the number of nodes of "expr" in "size".
+ */
+static bool ast_expr_is_plain_c(__isl_keep isl_ast_expr *expr, int *size)
+{
+  (*size)++;
+  if (isl_ast_expr_get_type(expr) != isl_ast_expr_op)
+    return true;
+
+  switch (isl_ast_expr_op_get_type(expr)) {
+    case isl_ast_expr_op_minus:
+    case isl_ast_expr_op_add:
+    case isl_ast_expr_op_sub:
+    case isl_ast_expr_op_mul:
+    case isl_ast_expr_op_div:
+    case isl_ast_expr_op_pdiv_q:
+    case isl_ast_expr_op_pdiv_r:
+    case isl_ast_expr_op_zdiv_r:
+      break;
+    default:
+      return false;
+  }
+
+  int n = isl_ast_expr_op_get_n_arg(expr);
+  for (int i = 0; i < n; i++) {
+    isl_ast_expr *arg = isl_ast_expr_op_get_arg(expr, i);
+    bool plain = ast_expr_is_plain_c(arg, size);
+    isl_ast_expr_free(arg);
+    if (!plain)
+      return false;
+  }
+
+  return true;
+}
+
+/* Simplify the integer expression "expr", e.g., "(4 * c0 + 8) / 4" 
+ * is simplified to "c0 + 2".
+ * The expression is converted into an isl_aff, where the identifiers
+ * are treated as parameters, and printed back by the AST generator.
+ * The dividends of integer divisions and remainders are assumed
+ * to be non-negative, which holds for the array indices printed by AutoSA.
+ * The original expression is returned if it is not quasi-affine,
+ * or if the simplified expression is not plain C integer arithmetic 
+ * or is not smaller than the original one.
+ */
+__isl_give isl_ast_expr *autosa_ast_expr_simplify(__isl_take isl_ast_expr *expr)
+{
+  struct autosa_ast_expr_simplify_data data;
+  isl_ctx *ctx;
+  isl_space *space;
+  isl_aff *aff;
+  isl_ast_expr *res = NULL;
+
+  if (!expr || isl_ast_expr_get_type(expr) != isl_ast_expr_op)
+    return expr;
+
+  ctx = isl_ast_expr_get_ctx(expr);
+  collect_ast_expr_ids(expr, &data);
+  space = isl_space_params_alloc(ctx, data.ids.size());
+  for (size_t i = 0; i < data.ids.size(); i++)
+    space = isl_space_set_dim_id(space, isl_dim_param, i, data.ids[i]);
+  data.context = isl_set_universe(isl_space_copy(space));
+
+  aff = ast_expr_to_aff(expr, space, &data);
+  if (aff && isl_set_is_empty(data.context) == isl_bool_false) {
+    isl_ast_build *build = isl_ast_build_from_context(
+                             isl_set_copy(data.context));
+    res = isl_ast_build_expr_from_pw_aff(build, 
+            isl_pw_aff_from_aff(isl_aff_copy(aff)));
+    isl_ast_build_free(build);
+  }
+  isl_aff_free(aff);
+  isl_set_free(data.context);
+  isl_space_free(space);
+
+  if (res) {
+    int size = 0, res_size = 0;
+    ast_expr_is_plain_c(expr, &size);
+    if (ast_expr_is_plain_c(res, &res_size) && res_size <= size) {
+      isl_ast_expr_free(expr);
+      return res;
+    }
+    isl_ast_expr_free(res);
+  }
+
+  return expr;
+}
+
+/* Internal data structure for evaluating the C expressions printed 
+ * by isl, e.g., "c0 + 1" or "floord(c1, 2)".
+ * "s" is the expression and "pos" the current position.
+ * "env" maps the identifiers to their values.
+ * "error" is set if the expression can not be evaluated.
+ */
+struct autosa_c_expr {
+  const char *s;
+  size_t pos;
+  const std::map<std::string, long> *env;
+  bool error;
+};
+
+static long c_expr_parse_ternary(struct autosa_c_expr *e);
+
+static void c_expr_skip_space(struct autosa_c_expr *e)
+{
+  while (isspace(e->s[e->pos]))
+    e->pos++;
+}
+
+/* Consume the token "tok" if it appears at the current position.
+ */
+static bool c_expr_match(struct autosa_c_expr *e, const char *tok)
+{
+  c_expr_skip_space(e);
+  if (strncmp(e->s + e->pos, tok, strlen(tok)))
+    return false;
+  e->pos += strlen(tok);
+  return true;
+}
+
+static long c_expr_floord(long a, long b)
+{
+  long q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0)))
+    q--;
+  return q;
+}
+
+/* Parse a primary expression, i.e., an integer, a loop iterator,
+ * a parenthesized expression or a call to "floord", "min" or "max".
+ */
+static long c_expr_parse_primary(struct autosa_c_expr *e)
+{
+  c_expr_skip_space(e);
+  if (c_expr_match(e, "(")) {
+    long v = c_expr_parse_ternary(e);
+    if (!c_expr_match(e, ")"))
+      e->error = true;
+    return v;
+  }
+  if (isdigit(e->s[e->pos])) {
+    long v = 0;
+    while (isdigit(e->s[e->pos]))
+      v = v * 10 + (e->s[e->pos++] - '0');
+    return v;
+  }
+  if (isalpha(e->s[e->pos]) || e->s[e->pos] == '_') {
+    std::string name;
+    while (isalnum(e->s[e->pos]) || e->s[e->pos] == '_')
+      name += e->s[e->pos++];
+    if (c_expr_match(e, "(")) {
+      std::vector<long> args;
+      do {
+        args.push_back(c_expr_parse_ternary(e));
+      } while (c_expr_match(e, ","));
+      if (!c_expr_match(e, ")") || args.size() != 2) {
+        e->error = true;
+        return 0;
+      }
+      if (name == "floord" && args[1] != 0)
+        return c_expr_floord(args[0], args[1]);
+      if (name == "min")
+        return std::min(args[0], args[1]);
+      if (name == "max")
+        return std::max(args[0], args[1]);
+      e->error = true;
+      return 0;
+    }
+    std::map<std::string, long>::const_iterator it = e->env->find(name);
+    if (it == e->env->end()) {
+      e->error = true;
+      return 0;
+    }
+    return it->second;
+  }
+
+  e->error = true;
+  return 0;
+}
+
+static long c_expr_parse_unary(struct autosa_c_expr *e)
+{
+  if (c_expr_match(e, "-"))
+    return -c_expr_parse_unary(e);
+  if (c_expr_match(e, "!"))
+    return !c_expr_parse_unary(e);
+  return c_expr_parse_primary(e);
+}
+
+static long c_expr_parse_mul(struct autosa_c_expr *e)
+{
+  long v = c_expr_parse_unary(e);
+  while (!e->error) {
+    if (c_expr_match(e, "*")) {
+      v *= c_expr_parse_unary(e);
+    } else if (c_expr_match(e, "/") || c_expr_match(e, "%")) {
+      char op = e->s[e->pos - 1];
+      long r = c_expr_parse_unary(e);
+      if (r == 0) {
+        e->error = true;
+        return 0;
+      }
+      v = (op == '/') ? v / r : v % r;
+    } else {
+      break;
+    }
+  }
+  return v;
+}
+
+static long c_expr_parse_add(struct autosa_c_expr *e)
+{
+  long v = c_expr_parse_mul(e);
+  while (!e->error) {
+    if (c_expr_match(e, "+"))
+      v += c_expr_parse_mul(e);
+    else if (c_expr_match(e, "-"))
+      v -= c_expr_parse_mul(e);
+    else
+      break;
+  }
+  return v;
+}
+
+static long c_expr_parse_rel(struct autosa_c_expr *e)
+{
+  long v = c_expr_parse_add(e);
+  while (!e->error) {
+    if (c_expr_match(e, "<="))
+      v = v <= c_expr_parse_add(e);
+    else if (c_expr_match(e, ">="))
+      v = v >= c_expr_parse_add(e);
+    else if (c_expr_match(e, "=="))
+      v = v == c_expr_parse_add(e);
+    else if (c_expr_match(e, "!="))
+      v = v != c_expr_parse_add(e);
+    else if (c_expr_match(e, "<"))
+      v = v < c_expr_parse_add(e);
+    else if (c_expr_match(e, ">"))
+      v = v > c_expr_parse_add(e);
+    else
+      break;
+  }
+  return v;
+}
+
+static long c_expr_parse_logic(struct autosa_c_expr *e)
+{
+  long v = c_expr_parse_rel(e);
+  while (!e->error) {
+    if (c_expr_match(e, "&&")) {
+      long r = c_expr_parse_rel(e);
+      v = v && r;
+    } else if (c_expr_match(e, "||")) {
+      long r = c_expr_parse_rel(e);
+      v = v || r;
+    } else {
+      break;
+    }
+  }
+  return v;
+}
+
+static long c_expr_parse_ternary(struct autosa_c_expr *e)
+{
+  long c = c_expr_parse_logic(e);
+  if (c_expr_match(e, "?")) {
+    long a = c_expr_parse_ternary(e);
+    if (!c_expr_match(e, ":"))
+      e->error = true;
+    long b = c_expr_parse_ternary(e);
+    return c ? a : b;
+  }
+  return c;
+}
+
+/* Evaluate the C expression "s" with the identifiers bound to 
+ * their values in "env".
+ * "error" is set if the expression can not be evaluated.
+ */
+long autosa_eval_c_expr(const char *s, 
+  const std::map<std::string, long> &env, bool *error)
+{
+  struct autosa_c_expr e = { s, 0, &env, false };
+  long v = c_expr_parse_ternary(&e);
+
+  c_expr_skip_space(&e);
+  if (e.s[e.pos] != '\0')
+    e.error = true;
+  if (e.error && error)
+    *error = true;
+  return v;
+}
+
+/* Evaluate the AST expression "expr" with the identifiers bound to 
+ * their values in "env".
+ * "error" is set if the expression can not be evaluated.
+ */
+static long ast_expr_eval(__isl_keep isl_ast_expr *expr, 
+  const std::map<std::string, long> &env, bool *error)
+{
+  enum isl_ast_expr_type type = isl_ast_expr_get_type(expr);
+
+  if (type == isl_ast_expr_int) {
+    isl_val *val = isl_ast_expr_get_val(expr);
+    long v = isl_val_get_num_si(val);
+    isl_val_free(val);
+    return v;
+  } else if (type == isl_ast_expr_id) {
+    isl_id *id = isl_ast_expr_get_id(expr);
+    std::string name(isl_id_get_name(id));
+    isl_id_free(id);
+    std::map<std::string, long>::const_iterator it = env.find(name);
+    if (it == env.end()) {
+      *error = true;
+      return 0;
+    }
+    return it->second;
+  } else if (type != isl_ast_expr_op) {
+    *error = true;
+    return 0;
+  }
+
+  int n = isl_ast_expr_op_get_n_arg(expr);
+  std::vector<long> args;
+  for (int i = 0; i < n; i++) {
+    isl_ast_expr *arg = isl_ast_expr_op_get_arg(expr, i);
+    args.push_back(ast_expr_eval(arg, env, error));
+    isl_ast_expr_free(arg);
+  }
+  if (*error)
+    return 0;
+
+  switch (isl_ast_expr_op_get_type(expr)) {
+    case isl_ast_expr_op_and:
+    case isl_ast_expr_op_and_then:
+      return args[0] && args[1];
+    case isl_ast_expr_op_or:
+    case isl_ast_expr_op_or_else:
+      return args[0] || args[1];
+    case isl_ast_expr_op_max:
+      return *std::max_element(args.begin(), args.end());
+    case isl_ast_expr_op_min:
+      return *std::min_element(args.begin(), args.end());
+    case isl_ast_expr_op_minus:
+      return -args[0];
+    case isl_ast_expr_op_add:
+      return args[0] + args[1];
+    case isl_ast_expr_op_sub:
+      return args[0] - args[1];
+    case isl_ast_expr_op_mul:
+      return args[0] * args[1];
+    case isl_ast_expr_op_div:
+    case isl_ast_expr_op_pdiv_q:
+      if (args[1] == 0)
+        break;
+      return args[0] / args[1];
+    case isl_ast_expr_op_fdiv_q:
+      if (args[1] == 0)
+        break;
+      return c_expr_floord(args[0], args[1]);
+    case isl_ast_expr_op_pdiv_r:
+    case isl_ast_expr_op_zdiv_r:
+      if (args[1] == 0)
+        break;
+      return args[0] % args[1];
+    case isl_ast_expr_op_cond:
+    case isl_ast_expr_op_select:
+      return args[0] ? args[1] : args[2];
+    case isl_ast_expr_op_eq:
+      return args[0] == args[1];
+    case isl_ast_expr_op_le:
+      return args[0] <= args[1];
+    case isl_ast_expr_op_lt:
+      return args[0] < args[1];
+    case isl_ast_expr_op_ge:
+      return args[0] >= args[1];
+    case isl_ast_expr_op_gt:
+      return args[0] > args[1];
+    default:
+      break;
+  }
+
+  *error = true;
+  return 0;
+}
+
+long autosa_eval_ast_expr(__isl_keep isl_ast_expr *expr, 
+  const std::map<std::string, long> &env, bool *error)
+{
+  bool err = false;
+  long v = ast_expr_eval(expr, env, &err);
+
+  if (err && error)
+    *error = true;
+  return v;
+}
+
+/* Internal data structure for profiling the compilation stages.
+ * "options" provides the output directory of the report.
+ * "root" is the JSON report under construction.
+ * "stack" contains the JSON objects of the stages that are currently 
+ * running, together with their start times in "start".
+ */
+struct autosa_profile_data {
+  bool enabled;
+  struct autosa_options *options;
+  cJSON *root;
+  std::vector<cJSON *> stack;
+  std::vector<double> start;
+};
+
+static struct autosa_profile_data autosa_profile = {false, NULL, NULL};
+
+/* Return the current wall time in seconds.
+ */
+static double autosa_profile_wall_time()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* Return the peak resident set size of the process in KB.
+ */
+static long autosa_profile_peak_rss()
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/* Enable the profiling of the compilation stages.
+ * The report is dumped at the exit of the program at the latest, 
+ * since several tuning steps exit the program once they have dumped 
+ * the tuning information.
+ */
+void autosa_profile_enable(struct autosa_options *options)
+{
+  if (autosa_profile.enabled)
+    return;
+  autosa_profile.enabled = true;
+  autosa_profile.options = options;
+  autosa_profile.root = cJSON_CreateObject();
+  cJSON_AddItemToObject(autosa_profile.root, "stages", cJSON_CreateArray());
+  atexit(&autosa_profile_dump);
+}
+
+/* Start the stage "name". 
+ * Stages started before the current stage has ended are recorded 
+ * as sub-stages of the current stage.
+ */
+void autosa_profile_begin(const char *name)
+{
+  cJSON *stage;
+
+  if (!autosa_profile.enabled)
+    return;
+  stage = cJSON_CreateObject();
+  cJSON_AddStringToObject(stage, "name", name);
+  autosa_profile.stack.push_back(stage);
+  autosa_profile.start.push_back(autosa_profile_wall_time());
+}
+
+/* End the current stage and record its wall time (in seconds) and 
+ * the peak resident set size of the process (in KB) when it ended.
+ */
+void autosa_profile_end()
+{
+  cJSON *stage, *parent, *stages;
+  double start;
+
+  if (!autosa_profile.enabled || autosa_profile.stack.empty())
+    return;
+  stage = autosa_profile.stack.back();
+  start = autosa_profile.start.back();
+  autosa_profile.stack.pop_back();
+  autosa_profile.start.pop_back();
+
+  cJSON_AddItemToObject(stage, "wall_time", 
+      cJSON_CreateNumber(autosa_profile_wall_time() - start));
+  cJSON_AddItemToObject(stage, "peak_rss", 
+      cJSON_CreateNumber(autosa_profile_peak_rss()));
+
+  parent = autosa_profile.stack.empty() ? 
+             autosa_profile.root : autosa_profile.stack.back();
+  stages = cJSON_GetObjectItemCaseSensitive(parent, "stages");
+  if (!stages) {
+    stages = cJSON_CreateArray();
+    cJSON_AddItemToObject(parent, "stages", stages);
+  }
+  cJSON_AddItemToArray(stages, stage);
+}
+
+/* Dump the profile of the compilation stages to 
+ * "output_dir/stage_profile.json". 
+ * Stages that are still running are closed first.
+ * The profiling is disabled afterwards.
+ */
+void autosa_profile_dump()
+{
+  std::string profile_path;
+  char *content;
+  FILE *fp;
+
+  if (!autosa_profile.enabled)
+    return;
+  while (!autosa_profile.stack.empty())
+    autosa_profile_end();
+
+  profile_path = std::string(autosa_profile.options->output_dir) + 
+                   "/stage_profile.json";
+  fp = fopen(profile_path.c_str(), "w");
+  if (fp) {
+    content = cJSON_Print(autosa_profile.root);
+    fprintf(fp, "%s", content);
+    fclose(fp);
+    free(content);
+  } else {
+    printf("[AutoSA] Error: Can't open the file: %s\n", profile_path.c_str());
+  }
+  cJSON_Delete(autosa_profile.root);
+  autosa_profile.root = NULL;
+  autosa_profile.enabled = false;
+}
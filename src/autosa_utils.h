@@ -1,12 +1,17 @@
 #ifndef _AUTOSA_UTILS_H
 #define _AUTOSA_UTILS_H
 
+#include <map>
+#include <string>
+
 #include <isl/ast.h>
 #include <isl/id.h>
 #include <isl/id_to_ast_expr.h>
 
 #include <pet.h>
 
+#include <cJSON/cJSON.h>
+
 #include "ppcg.h"
 #include "ppcg_options.h"
 
@@ -31,5 +36,16 @@ int isl_vec_cmp(__isl_keep isl_vec *vec1, __isl_keep isl_vec *vec2);
 char *concat(isl_ctx *ctx, const char *a, const char *b);
 bool isl_vec_is_zero(__isl_keep isl_vec *vec);
 int suffixcmp(const char *s, const char *suffix);
+__isl_give isl_ast_expr *autosa_ast_expr_simplify(__isl_take isl_ast_expr *expr);
+long autosa_eval_c_expr(const char *s, 
+  const std::map<std::string, long> &env, bool *error);
+long autosa_eval_ast_expr(__isl_keep isl_ast_expr *expr, 
+  const std::map<std::string, long> &env, bool *error);
+
+/* Profiling */
+void autosa_profile_enable(struct autosa_options *options);
+void autosa_profile_begin(const char *name);
+void autosa_profile_end();
+void autosa_profile_dump();
 
 #endif
\ No newline at end of file
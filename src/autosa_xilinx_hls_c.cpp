@@ -1,8 +1,15 @@
+#include <unistd.h>
+#include <ctype.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
 #include <isl/ctx.h>
 
 #include "autosa_xilinx_hls_c.h"
 #include "autosa_common.h"
 #include "autosa_print.h"
+#include "autosa_resource_est.h"
 #include "autosa_trans.h"
 #include "autosa_codegen.h"
 #include "autosa_utils.h"
@@ -211,6 +218,94 @@ static void hls_close_files(struct hls_info *info)
   free(complete);
 }
 
+/* Redirect the output file "f" from "old_path" to "new_path".
+ * The content written so far is copied to the new file and the file 
+ * descriptor of "f" is replaced by the one of the new file, so that 
+ * the FILE handle "f", which may be held by pet, stays valid.
+ */
+static void hls_redirect_file(FILE *f, const char *old_path, 
+  const char *new_path)
+{
+  FILE *src, *dst;
+  char buf[4096];
+  size_t n;
+
+  fflush(f);
+  src = fopen(old_path, "r");
+  if (!src) {
+    printf("[AutoSA] Error: Can't open the file: %s\n", old_path);
+    exit(1);
+  }
+  dst = fopen(new_path, "w");
+  if (!dst) {
+    printf("[AutoSA] Error: Can't open the file: %s\n", new_path);
+    exit(1);
+  }
+  while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+    fwrite(buf, 1, n, dst);
+  fflush(dst);
+  dup2(fileno(dst), fileno(f));
+  fclose(dst);
+  fclose(src);
+}
+
+/* Discard the output file "f" at "path".
+ * The file is removed and the file descriptor of "f" is replaced by 
+ * the one of /dev/null, so that the FILE handle "f" stays valid.
+ */
+static void hls_discard_file(FILE *f, const char *path)
+{
+  FILE *dst;
+
+  dst = fopen("/dev/null", "w");
+  if (!dst) {
+    printf("[AutoSA] Error: Can't open the file: /dev/null\n");
+    exit(1);
+  }
+  fflush(f);
+  dup2(fileno(dst), fileno(f));
+  fclose(dst);
+  unlink(path);
+}
+
+/* Redirect all output files to the output directory "output_dir".
+ * This is used by the sweep mode, where each design point is generated 
+ * in a separate output directory.
+ * If "output_dir" is NULL, the output files are discarded instead.
+ */
+static void hls_redirect_files(void *user, const char *output_dir)
+{
+  struct hls_info *info = (struct hls_info *)user;
+  const char *suffix[] = {"_host.cpp", "_host.hpp", "_kernel_modules.cpp", 
+    "_kernel.h", "_top_gen.cpp", "_top_gen.h"};
+  FILE *files[] = {info->host_c, info->host_h, info->kernel_c, 
+    info->kernel_h, info->top_gen_c, info->top_gen_h};
+  char name[PATH_MAX];
+  char old_path[PATH_MAX];
+  char new_path[PATH_MAX];
+  int len;
+
+  len = ppcg_extract_base_name(name, info->input);
+  for (int i = 0; i < 6; i++) {
+    if (!files[i])
+      continue;
+    strcpy(name + len, suffix[i]);
+    sprintf(old_path, "%s/src/%s", info->output_dir, name);
+    if (!output_dir) {
+      hls_discard_file(files[i], old_path);
+      continue;
+    }
+    sprintf(new_path, "%s/src/%s", output_dir, name);
+    if (strcmp(old_path, new_path) == 0)
+      continue;
+    hls_redirect_file(files[i], old_path, new_path);
+  }
+  if (!output_dir)
+    return;
+  free(info->output_dir);
+  info->output_dir = strdup(output_dir);
+}
+
 /* Extract the data pack factors for each I/O buffer allocated for the current
  * I/O group.
  * Only insert the data pack factor that is not found in the current list
@@ -376,6 +471,19 @@ static __isl_give isl_printer *find_device_xilinx(__isl_take isl_printer *p)
   p = isl_printer_end_line(p);
 }
 
+/* Print the suffix of the device buffer "buffer" of "array", 
+ * if the array has several buffers.
+ */
+static __isl_give isl_printer *print_buffer_suffix(__isl_take isl_printer *p,
+  struct autosa_array_info *array, int buffer)
+{
+  if (array->n_buffer > 1) {
+    p = isl_printer_print_str(p, "_");
+    p = isl_printer_print_int(p, buffer);
+  }
+  return p;
+}
+
 static __isl_give isl_printer *declare_and_allocate_device_arrays_xilinx(
   __isl_take isl_printer *p, struct autosa_prog *prog)
 {
@@ -385,18 +493,21 @@ static __isl_give isl_printer *declare_and_allocate_device_arrays_xilinx(
     if (!autosa_array_requires_device_allocation(array))
       continue;
     
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "std::vector<");
-    p = isl_printer_print_str(p, array->type);
-    p = isl_printer_print_str(p, ", aligned_allocator<");
-    p = isl_printer_print_str(p, array->type);
-    p = isl_printer_print_str(p, ">> ");
-    p = isl_printer_print_str(p, "dev_");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, "(");
-    p = autosa_array_info_print_data_size(p, array);
-    p = isl_printer_print_str(p, ");");
-    p = isl_printer_end_line(p);
+    for (int j = 0; j < max(array->n_buffer, 1); j++) {
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "std::vector<");
+      p = isl_printer_print_str(p, array->type);
+      p = isl_printer_print_str(p, ", aligned_allocator<");
+      p = isl_printer_print_str(p, array->type);
+      p = isl_printer_print_str(p, ">> ");
+      p = isl_printer_print_str(p, "dev_");
+      p = isl_printer_print_str(p, array->name);
+      p = print_buffer_suffix(p, array, j);
+      p = isl_printer_print_str(p, "(");
+      p = autosa_array_info_print_data_size(p, array);
+      p = isl_printer_print_str(p, ");");
+      p = isl_printer_end_line(p);
+    }
   }
   p = isl_printer_end_line(p);
 
@@ -407,21 +518,24 @@ static __isl_give isl_printer *declare_and_allocate_device_arrays_xilinx(
     if (!autosa_array_requires_device_allocation(array))
       continue;
 
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "std::copy(reinterpret_cast<");
-    p = isl_printer_print_str(p, array->type);
-    p = isl_printer_print_str(p, " *>(");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, "), reinterpret_cast<");
-    p = isl_printer_print_str(p, array->type);
-    p = isl_printer_print_str(p, " *>(");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, ") + ");
-    p = autosa_array_info_print_data_size(p, array);
-    p = isl_printer_print_str(p, ", dev_");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, ".begin());");
-    p = isl_printer_end_line(p);
+    for (int j = 0; j < max(array->n_buffer, 1); j++) {
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "std::copy(reinterpret_cast<");
+      p = isl_printer_print_str(p, array->type);
+      p = isl_printer_print_str(p, " *>(");
+      p = isl_printer_print_str(p, array->name);
+      p = isl_printer_print_str(p, "), reinterpret_cast<");
+      p = isl_printer_print_str(p, array->type);
+      p = isl_printer_print_str(p, " *>(");
+      p = isl_printer_print_str(p, array->name);
+      p = isl_printer_print_str(p, ") + ");
+      p = autosa_array_info_print_data_size(p, array);
+      p = isl_printer_print_str(p, ", dev_");
+      p = isl_printer_print_str(p, array->name);
+      p = print_buffer_suffix(p, array, j);
+      p = isl_printer_print_str(p, ".begin());");
+      p = isl_printer_end_line(p);
+    }
   }
   p = isl_printer_end_line(p);
 
@@ -434,28 +548,79 @@ static __isl_give isl_printer *declare_and_allocate_device_arrays_xilinx(
     if (!autosa_array_requires_device_allocation(array))
       continue;
 
-    p = print_str_new_line(p, "OCL_CHECK(err,");
-    indent1 = strlen("OCL_CHECK(");
-    p = isl_printer_indent(p, indent1);
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "cl::Buffer buffer_");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, "(context,");
-    p = isl_printer_end_line(p);
-    p = isl_printer_indent(p, strlen("cl::Buffer buffer_") + strlen(array->name) + 1);
-    p = print_str_new_line(p, "CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE,");
-    p = isl_printer_start_line(p);
-    p = autosa_array_info_print_size(p, array);
-    p = isl_printer_print_str(p, ",");
-    p = isl_printer_end_line(p);
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "dev_");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, ".data(),");
-    p = isl_printer_end_line(p);
-    p = print_str_new_line(p, "&err));");
-    p = isl_printer_indent(p, -(strlen("cl::Buffer buffer_") + strlen(array->name) + 1));
-    p = isl_printer_indent(p, -indent1);
+    for (int j = 0; j < max(array->n_buffer, 1); j++) {
+      isl_printer *p_str;
+      char *buffer_name;
+
+      p_str = isl_printer_to_str(isl_printer_get_ctx(p));
+      p_str = isl_printer_print_str(p_str, array->name);
+      p_str = print_buffer_suffix(p_str, array, j);
+      buffer_name = isl_printer_get_str(p_str);
+      isl_printer_free(p_str);
+
+      /* Place the buffer in the HBM channel of its first pointer. */
+      if (array->hbm_banks) {
+        int bank = array->hbm_banks[array->n_buffer > 1 ? j : 0];
+        p = isl_printer_start_line(p);
+        p = isl_printer_print_str(p, "cl_mem_ext_ptr_t ext_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ";");
+        p = isl_printer_end_line(p);
+        p = isl_printer_start_line(p);
+        p = isl_printer_print_str(p, "ext_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ".flags = ");
+        p = isl_printer_print_int(p, bank);
+        p = isl_printer_print_str(p, " | XCL_MEM_TOPOLOGY;");
+        p = isl_printer_end_line(p);
+        p = isl_printer_start_line(p);
+        p = isl_printer_print_str(p, "ext_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ".obj = dev_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ".data();");
+        p = isl_printer_end_line(p);
+        p = isl_printer_start_line(p);
+        p = isl_printer_print_str(p, "ext_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ".param = 0;");
+        p = isl_printer_end_line(p);
+      }
+
+      p = print_str_new_line(p, "OCL_CHECK(err,");
+      indent1 = strlen("OCL_CHECK(");
+      p = isl_printer_indent(p, indent1);
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "cl::Buffer buffer_");
+      p = isl_printer_print_str(p, buffer_name);
+      p = isl_printer_print_str(p, "(context,");
+      p = isl_printer_end_line(p);
+      indent2 = strlen("cl::Buffer buffer_") + strlen(buffer_name) + 1;
+      p = isl_printer_indent(p, indent2);
+      if (array->hbm_banks)
+        p = print_str_new_line(p, "CL_MEM_USE_HOST_PTR | CL_MEM_EXT_PTR_XILINX | CL_MEM_READ_WRITE,");
+      else
+        p = print_str_new_line(p, "CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE,");
+      p = isl_printer_start_line(p);
+      p = autosa_array_info_print_size(p, array);
+      p = isl_printer_print_str(p, ",");
+      p = isl_printer_end_line(p);
+      p = isl_printer_start_line(p);
+      if (array->hbm_banks) {
+        p = isl_printer_print_str(p, "&ext_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ",");
+      } else {
+        p = isl_printer_print_str(p, "dev_");
+        p = isl_printer_print_str(p, buffer_name);
+        p = isl_printer_print_str(p, ".data(),");
+      }
+      p = isl_printer_end_line(p);
+      p = print_str_new_line(p, "&err));");
+      p = isl_printer_indent(p, -indent2);
+      p = isl_printer_indent(p, -indent1);
+      free(buffer_name);
+    }
   }
   p = isl_printer_end_line(p);
 
@@ -561,8 +726,10 @@ static __isl_give isl_printer *clear_device_xilinx(__isl_take isl_printer *p,
       p = isl_printer_start_line(p);
       p = isl_printer_print_str(p, "std::copy(dev_");
       p = isl_printer_print_str(p, array->name);
+      p = print_buffer_suffix(p, array, 0);
       p = isl_printer_print_str(p, ".begin(), dev_");
       p = isl_printer_print_str(p, array->name);
+      p = print_buffer_suffix(p, array, 0);
       p = isl_printer_print_str(p, ".end(), reinterpret_cast<");
       p = isl_printer_print_str(p, array->type);
       p = isl_printer_print_str(p, " *>(");
@@ -590,8 +757,14 @@ static __isl_give isl_printer *copy_array_to_device_xilinx(
     indent = strlen("OCL_CHECK(");
     p = isl_printer_indent(p, indent);
     p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "err = q.enqueueMigrateMemObjects({buffer_");
-    p = isl_printer_print_str(p, array->name);
+    p = isl_printer_print_str(p, "err = q.enqueueMigrateMemObjects({");
+    for (int j = 0; j < max(array->n_buffer, 1); j++) {
+      if (j > 0)
+        p = isl_printer_print_str(p, ", ");
+      p = isl_printer_print_str(p, "buffer_");
+      p = isl_printer_print_str(p, array->name);
+      p = print_buffer_suffix(p, array, j);
+    }
     p = isl_printer_print_str(p, "}, 0));");
     p = isl_printer_end_line(p);
     p = isl_printer_indent(p, -indent);
@@ -628,6 +801,7 @@ static __isl_give isl_printer *copy_array_from_device_xilinx(
     p = isl_printer_start_line(p);
     p = isl_printer_print_str(p, "err = q.enqueueMigrateMemObjects({buffer_");
     p = isl_printer_print_str(p, array->name);
+    p = print_buffer_suffix(p, array, 0);
     p = isl_printer_print_str(p, "}, CL_MIGRATE_MEM_OBJECT_HOST));");
     p = isl_printer_end_line(p);
     p = isl_printer_indent(p, -indent);
@@ -717,15 +891,21 @@ static __isl_give isl_printer *print_set_kernel_arguments_xilinx(
       continue;
 
     struct autosa_array_info *array = &prog->array[i];
+    int n_ref = kernel->array[i].n_io_group_refs;
 
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "OCL_CHECK(err, err = krnl.setArg(");
-    p = isl_printer_print_int(p, n_arg);
-    p = isl_printer_print_str(p, ", buffer_");
-    p = isl_printer_print_str(p, array->name);
-    p = isl_printer_print_str(p, "));");
-    p = isl_printer_end_line(p);
-    n_arg++;
+    /* The kernel takes one pointer per I/O module connected to the 
+     * external memory, see print_kernel_arguments. */
+    for (int j = 0; j < n_ref; j++) {
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "OCL_CHECK(err, err = krnl.setArg(");
+      p = isl_printer_print_int(p, n_arg);
+      p = isl_printer_print_str(p, ", buffer_");
+      p = isl_printer_print_str(p, array->name);
+      p = print_buffer_suffix(p, array, array->n_buffer > 1 ? j : 0);
+      p = isl_printer_print_str(p, "));");
+      p = isl_printer_end_line(p);
+      n_arg++;
+    }
   }
 
   /* param */
@@ -1701,9 +1881,10 @@ static __isl_give isl_printer *autosa_print_host_code(__isl_take isl_printer *p,
 }
 
 /* Declare the AXI interface for each global pointers. 
+ * If "env" is NULL, print the code that prints the pragmas.
  */
 static __isl_give isl_printer *print_top_module_interface_xilinx(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_prog *prog, struct autosa_kernel *kernel)
 {
   int n;
@@ -1717,9 +1898,9 @@ static __isl_give isl_printer *print_top_module_interface_xilinx(
         && !autosa_array_is_scalar(local_array->array)) {
       if (local_array->n_io_group_refs > 1) {
         for (int j = 0; j < local_array->n_io_group_refs; j++) {
-          p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-          p = isl_printer_start_line(p);
-          p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE m_axi port=");
+          p = top_gen_start_line(p, env);
+          p = top_gen_open_str(p, env);
+          p = isl_printer_print_str(p, "#pragma HLS INTERFACE m_axi port=");
           p = isl_printer_print_str(p, local_array->array->name);
           p = isl_printer_print_str(p, "_");
           p = isl_printer_print_int(p, j);
@@ -1727,20 +1908,18 @@ static __isl_give isl_printer *print_top_module_interface_xilinx(
           p = isl_printer_print_str(p, local_array->array->name);
           p = isl_printer_print_str(p, "_");
           p = isl_printer_print_int(p, j);
-          p = isl_printer_print_str(p, "\");");
-          p = isl_printer_end_line(p);
-          p = print_str_new_line(p, "p = isl_printer_end_line(p);");       
+          p = top_gen_close_str(p, env);
+          p = top_gen_end_line(p, env);
         }
       } else {
-        p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-        p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE m_axi port=");
+        p = top_gen_start_line(p, env);
+        p = top_gen_open_str(p, env);
+        p = isl_printer_print_str(p, "#pragma HLS INTERFACE m_axi port=");
         p = isl_printer_print_str(p, local_array->array->name);
         p = isl_printer_print_str(p, " offset=slave bundle=gmem_");
         p = isl_printer_print_str(p, local_array->array->name);
-        p = isl_printer_print_str(p, "\");");
-        p = isl_printer_end_line(p);
-        p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+        p = top_gen_close_str(p, env);
+        p = top_gen_end_line(p, env);
       }
     }
   }
@@ -1750,24 +1929,24 @@ static __isl_give isl_printer *print_top_module_interface_xilinx(
     if (autosa_kernel_requires_array_argument(kernel, i)) {
       if (local_array->n_io_group_refs > 1) {
         for (int j = 0; j < local_array->n_io_group_refs; j++) {
-          p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-          p = isl_printer_start_line(p);
-          p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE s_axilite port=");
+          p = top_gen_start_line(p, env);
+          p = top_gen_open_str(p, env);
+          p = isl_printer_print_str(p, "#pragma HLS INTERFACE s_axilite port=");
           p = isl_printer_print_str(p, local_array->array->name);
           p = isl_printer_print_str(p, "_");
           p = isl_printer_print_int(p, j);
-          p = isl_printer_print_str(p, " bundle=control\");");
-          p = isl_printer_end_line(p);
-          p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+          p = isl_printer_print_str(p, " bundle=control");
+          p = top_gen_close_str(p, env);
+          p = top_gen_end_line(p, env);
         }
       } else {
-        p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-        p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE s_axilite port=");
+        p = top_gen_start_line(p, env);
+        p = top_gen_open_str(p, env);
+        p = isl_printer_print_str(p, "#pragma HLS INTERFACE s_axilite port=");
         p = isl_printer_print_str(p, local_array->array->name);
-        p = isl_printer_print_str(p, " bundle=control\");");
-        p = isl_printer_end_line(p);
-        p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+        p = isl_printer_print_str(p, " bundle=control");
+        p = top_gen_close_str(p, env);
+        p = top_gen_end_line(p, env);
       }
     }
   }
@@ -1777,13 +1956,13 @@ static __isl_give isl_printer *print_top_module_interface_xilinx(
   for (int i = 0; i < nparam; i++) {
     const char *name;
     name = isl_space_get_dim_name(space, isl_dim_param, i);
-    p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE s_axilite port=");
+    p = top_gen_start_line(p, env);
+    p = top_gen_open_str(p, env);
+    p = isl_printer_print_str(p, "#pragma HLS INTERFACE s_axilite port=");
     p = isl_printer_print_str(p, name);
-    p = isl_printer_print_str(p, " bundle=control\");");
-    p = isl_printer_end_line(p);
-    p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+    p = isl_printer_print_str(p, " bundle=control");
+    p = top_gen_close_str(p, env);
+    p = top_gen_end_line(p, env);
   }
   isl_space_free(space);
 
@@ -1792,58 +1971,63 @@ static __isl_give isl_printer *print_top_module_interface_xilinx(
   for (int i = 0; i < n; i++) {
     const char *name;
     name = isl_space_get_dim_name(kernel->space, isl_dim_set, i);
-    p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE s_axilite port=");
+    p = top_gen_start_line(p, env);
+    p = top_gen_open_str(p, env);
+    p = isl_printer_print_str(p, "#pragma HLS INTERFACE s_axilite port=");
     p = isl_printer_print_str(p, name);
-    p = isl_printer_print_str(p, " bundle=control\");");
-    p = isl_printer_end_line(p);
-    p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+    p = isl_printer_print_str(p, " bundle=control");
+    p = top_gen_close_str(p, env);
+    p = top_gen_end_line(p, env);
   }
 
-  p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-  p = print_str_new_line(p, "p = isl_printer_print_str(p, \"#pragma HLS INTERFACE s_axilite port=return bundle=control\");");
-  p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+  p = top_gen_start_line(p, env);
+  p = top_gen_print_str(p, env, 
+        "#pragma HLS INTERFACE s_axilite port=return bundle=control");
+  p = top_gen_end_line(p, env);
 
   return p;
 }
 
+/* Print the header of the top module, followed by the interface and 
+ * dataflow pragmas.
+ * If "env" is NULL, print the code that prints them.
+ */
 static __isl_give isl_printer *print_top_module_headers_xilinx(
-  __isl_take isl_printer *p,
+  __isl_take isl_printer *p, struct autosa_top_gen_env *env,
   struct autosa_prog *prog, struct autosa_hw_top_module *top, struct hls_info *hls)
 {
   struct autosa_kernel *kernel = top->kernel;
 
   if (!hls->hls) {
-    p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-    p = print_str_new_line(p, "p = isl_printer_print_str(p, \"extern \\\"C\\\" {\");");
-    p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+    p = top_gen_start_line(p, env);
+    p = top_gen_print_str(p, env, "extern \"C\" {");
+    p = top_gen_end_line(p, env);
   }
 
-  p = print_str_new_line(p, "p = isl_printer_start_line(p);");
+  p = top_gen_start_line(p, env);
 
-  p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"void kernel");
+  p = top_gen_open_str(p, env);
+  p = isl_printer_print_str(p, "void kernel");
   p = isl_printer_print_int(p, top->kernel->id);
   p = isl_printer_print_str(p, "(");
   p = print_kernel_arguments(p, prog, top->kernel, 1, hls);
-  p = isl_printer_print_str(p, ")\");");
-  p = isl_printer_end_line(p);
+  p = isl_printer_print_str(p, ")");
+  p = top_gen_close_str(p, env);
 
-  p = print_str_new_line(p, "p = isl_printer_end_line(p);");
-  p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-  p = print_str_new_line(p, "p = isl_printer_print_str(p, \"{\");");
-  p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+  p = top_gen_end_line(p, env);
+  p = top_gen_start_line(p, env);
+  p = top_gen_print_str(p, env, "{");
+  p = top_gen_end_line(p, env);
 
   /* Print out the interface pragmas. */
-  p = print_top_module_interface_xilinx(p, prog, kernel);
+  p = print_top_module_interface_xilinx(p, env, prog, kernel);
 
   /* Print out the dataflow pragma. */
-  p = print_str_new_line(p, "p = isl_printer_end_line(p);");
-  p = print_str_new_line(p, "p = isl_printer_start_line(p);");
-  p = print_str_new_line(p, "p = isl_printer_print_str(p, \"#pragma HLS DATAFLOW\");");
-  p = print_str_new_line(p, "p = isl_printer_end_line(p);");
-  p = print_str_new_line(p, "p = isl_printer_end_line(p);");
+  p = top_gen_end_line(p, env);
+  p = top_gen_start_line(p, env);
+  p = top_gen_print_str(p, env, "#pragma HLS DATAFLOW");
+  p = top_gen_end_line(p, env);
+  p = top_gen_end_line(p, env);
   
   return p;
 }
@@ -1914,7 +2098,8 @@ static __isl_give isl_printer *print_top_module_fifo_stmt(__isl_take isl_printer
 
   switch (stmt->type) {
     case AUTOSA_KERNEL_STMT_FIFO_DECL:
-      return autosa_kernel_print_fifo_decl(p, stmt, data->prog, data->hls);
+      return autosa_kernel_print_fifo_decl(p, NULL, stmt, data->prog, 
+                data->hls);
   }
 
   return p;
@@ -1937,12 +2122,84 @@ static __isl_give isl_printer *print_top_module_call_stmt(
 
   switch (stmt->type) {
     case AUTOSA_KERNEL_STMT_MODULE_CALL:
-      return autosa_kernel_print_module_call(p, stmt, data->prog);
+      return autosa_kernel_print_module_call(p, NULL, stmt, data->prog);
   }
 
   return p;
 }
 
+/* Collect the names of the module counters of the top module "top",
+ * i.e., the hardware modules, their intra/inter transfer sub-modules, 
+ * boundary modules, and the PE dummy modules.
+ * The number of names is stored in "n_module_names_p".
+ */
+static char **extract_top_module_names(isl_ctx *ctx, 
+  struct autosa_hw_top_module *top, int *n_module_names_p)
+{
+  int n_module_names = 0;
+  char **module_names = NULL;
+  for (int i = 0; i < top->n_hw_modules; i++) {
+    /* Generate module call counter. */
+    struct autosa_hw_module *module = top->hw_modules[i];
+    char *module_name;
+
+    if (module->is_filter && module->is_buffer) {
+      module_name = concat(ctx, module->name, "intra_trans");
+      
+      n_module_names++;
+      module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
+      module_names[n_module_names - 1] = module_name;
+
+      module_name = concat(ctx, module->name, "inter_trans");
+      
+      n_module_names++;
+      module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
+      module_names[n_module_names - 1] = module_name;
+
+      if (module->boundary) {
+        module_name = concat(ctx, module->name, "inter_trans_boundary");
+      
+        n_module_names++;
+        module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
+        module_names[n_module_names - 1] = module_name;       
+      }
+    }
+        
+    module_name = strdup(module->name);
+    
+    n_module_names++;
+    module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
+    module_names[n_module_names - 1] = module_name;       
+ 
+    if (module->boundary) {
+      module_name = concat(ctx, module->name, "boundary");
+      
+      n_module_names++;
+      module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
+      module_names[n_module_names - 1] = module_name;       
+    }
+
+    if (module->n_pe_dummy_modules > 0) {
+      for (int j = 0; j < module->n_pe_dummy_modules; j++) {
+        struct autosa_pe_dummy_module *dummy_module = module->pe_dummy_modules[j];
+        struct autosa_array_ref_group *group = dummy_module->io_group;
+        isl_printer *p_str = isl_printer_to_str(ctx);
+        p_str = autosa_array_ref_group_print_prefix(group, p_str);
+        p_str = isl_printer_print_str(p_str, "_PE_dummy");
+        module_name = isl_printer_get_str(p_str);
+        isl_printer_free(p_str);
+        
+        n_module_names++;
+        module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
+        module_names[n_module_names - 1] = module_name;       
+      }
+    }
+  }
+
+  *n_module_names_p = n_module_names;
+  return module_names;
+}
+
 /* This function prints the code that prints out the top function that 
  * calls the hardware modules and declares the fifos.
  */
@@ -1981,7 +2238,7 @@ static void print_top_gen_host_code(
   p = isl_printer_end_line(p);
 
   if (hls->target == XILINX_HW)
-    p = print_top_module_headers_xilinx(p, prog, top, hls);
+    p = print_top_module_headers_xilinx(p, NULL, prog, top, hls);
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "p = isl_printer_indent(p, 4);");
   p = isl_printer_end_line(p);
@@ -2049,64 +2306,8 @@ static void print_top_gen_host_code(
   p = isl_printer_end_line(p);
 
   int n_module_names = 0;
-  char **module_names = NULL;
-  for (int i = 0; i < top->n_hw_modules; i++) {
-    /* Generate module call counter. */
-    struct autosa_hw_module *module = top->hw_modules[i];
-    char *module_name;
-
-    if (module->is_filter && module->is_buffer) {
-      module_name = concat(ctx, module->name, "intra_trans");
-      
-      n_module_names++;
-      module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
-      module_names[n_module_names - 1] = module_name;
-
-      module_name = concat(ctx, module->name, "inter_trans");
-      
-      n_module_names++;
-      module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
-      module_names[n_module_names - 1] = module_name;
-
-      if (module->boundary) {
-        module_name = concat(ctx, module->name, "inter_trans_boundary");
-      
-        n_module_names++;
-        module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
-        module_names[n_module_names - 1] = module_name;       
-      }
-    }
-        
-    module_name = strdup(module->name);
-    
-    n_module_names++;
-    module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
-    module_names[n_module_names - 1] = module_name;       
- 
-    if (module->boundary) {
-      module_name = concat(ctx, module->name, "boundary");
-      
-      n_module_names++;
-      module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
-      module_names[n_module_names - 1] = module_name;       
-    }
-
-    if (module->n_pe_dummy_modules > 0) {
-      for (int j = 0; j < module->n_pe_dummy_modules; j++) {
-        struct autosa_pe_dummy_module *dummy_module = module->pe_dummy_modules[j];
-        struct autosa_array_ref_group *group = dummy_module->io_group;
-        isl_printer *p_str = isl_printer_to_str(ctx);
-        p_str = autosa_array_ref_group_print_prefix(group, p_str);
-        p_str = isl_printer_print_str(p_str, "_PE_dummy");
-        module_name = isl_printer_get_str(p_str);
-        isl_printer_free(p_str);
-        
-        n_module_names++;
-        module_names = (char **)realloc(module_names, n_module_names * sizeof(char *));
-        module_names[n_module_names - 1] = module_name;       
-      }
-    }
-  }
+  char **module_names = extract_top_module_names(ctx, top, 
+                          &n_module_names);
   for (int i = 0; i < n_module_names; i++) {
     p = isl_printer_start_line(p);
     p = isl_printer_print_str(p, "int ");
@@ -2198,6 +2399,282 @@ static void print_top_gen_host_code(
   return;
 }
 
+/* Evaluate the AST expression "expr" under the current loop iterators 
+ * in "env".
+ */
+static long top_gen_eval_ast_expr(__isl_keep isl_ast_expr *expr, 
+  struct autosa_top_gen_env *env)
+{
+  bool error = false;
+  long v = autosa_eval_ast_expr(expr, env->iters, &error);
+
+  if (error)
+    env->error = true;
+  return v;
+}
+
+/* Walk the AST "node" of the FIFO declarations or module calls of 
+ * the top module and print the FIFO declarations or module calls of 
+ * the user nodes to "p" for each iteration of the surrounding loops.
+ * The values of the loop iterators are kept in "env".
+ */
+static __isl_give isl_printer *top_gen_walk(__isl_take isl_printer *p,
+  __isl_keep isl_ast_node *node, struct autosa_top_gen_env *env, 
+  struct print_hw_module_data *hw_data)
+{
+  if (!node || env->error)
+    return p;
+
+  switch (isl_ast_node_get_type(node)) {
+    case isl_ast_node_for:
+    {
+      isl_ast_expr *iterator = isl_ast_node_for_get_iterator(node);
+      isl_ast_expr *init = isl_ast_node_for_get_init(node);
+      isl_ast_expr *cond = isl_ast_node_for_get_cond(node);
+      isl_ast_expr *inc = isl_ast_node_for_get_inc(node);
+      isl_ast_node *body = isl_ast_node_for_get_body(node);
+      isl_id *id = isl_ast_expr_get_id(iterator);
+      std::string name(isl_id_get_name(id));
+      long step = top_gen_eval_ast_expr(inc, env);
+
+      if (step <= 0)
+        env->error = true;
+      env->iters[name] = top_gen_eval_ast_expr(init, env);
+      while (!env->error && top_gen_eval_ast_expr(cond, env)) {
+        p = top_gen_walk(p, body, env, hw_data);
+        env->iters[name] += step;
+      }
+      env->iters.erase(name);
+
+      isl_id_free(id);
+      isl_ast_node_free(body);
+      isl_ast_expr_free(inc);
+      isl_ast_expr_free(cond);
+      isl_ast_expr_free(init);
+      isl_ast_expr_free(iterator);
+      break;
+    }
+    case isl_ast_node_if:
+    {
+      isl_ast_expr *cond = isl_ast_node_if_get_cond(node);
+      isl_ast_node *child_node;
+      if (top_gen_eval_ast_expr(cond, env))
+        child_node = isl_ast_node_if_get_then_node(node);
+      else
+        child_node = isl_ast_node_if_get_else_node(node);
+      if (child_node) {
+        p = top_gen_walk(p, child_node, env, hw_data);
+        isl_ast_node_free(child_node);
+      }
+      isl_ast_expr_free(cond);
+      break;
+    }
+    case isl_ast_node_block:
+    {
+      isl_ast_node_list *children = isl_ast_node_block_get_children(node);
+      int n = isl_ast_node_list_n_ast_node(children);
+      for (int i = 0; i < n; i++) {
+        isl_ast_node *child = isl_ast_node_list_get_ast_node(children, i);
+        p = top_gen_walk(p, child, env, hw_data);
+        isl_ast_node_free(child);
+      }
+      isl_ast_node_list_free(children);
+      break;
+    }
+    case isl_ast_node_mark:
+    {
+      isl_ast_node *child = isl_ast_node_mark_get_node(node);
+      p = top_gen_walk(p, child, env, hw_data);
+      isl_ast_node_free(child);
+      break;
+    }
+    case isl_ast_node_user:
+    {
+      isl_id *id = isl_ast_node_get_annotation(node);
+      struct autosa_kernel_stmt *stmt = 
+        (struct autosa_kernel_stmt *)isl_id_get_user(id);
+
+      isl_id_free(id);
+      if (stmt->type == AUTOSA_KERNEL_STMT_FIFO_DECL)
+        p = autosa_kernel_print_fifo_decl(p, env, stmt, hw_data->prog, 
+              hw_data->hls);
+      else if (stmt->type == AUTOSA_KERNEL_STMT_MODULE_CALL)
+        p = autosa_kernel_print_module_call(p, env, stmt, hw_data->prog);
+      break;
+    }
+    default:
+      env->error = true;
+  }
+
+  return p;
+}
+
+/* Generate the top module "top.cpp" and the design information 
+ * "design_info.dat" directly, instead of printing a program that generates 
+ * them. The FIFO declaration and module call ASTs are walked and 
+ * the statement printers print the top module for the values of the 
+ * loop iterators, so that the code is identical to the output of 
+ * the program printed by print_top_gen_host_code.
+ * Return isl_stat_error if the top module contains a construct that
+ * can not be evaluated, e.g., loop bounds that depend on parameters,
+ * in which case nothing is written.
+ */
+static isl_stat generate_top_module_in_process(struct autosa_prog *prog,
+  struct autosa_hw_top_module *top, struct hls_info *hls)
+{
+  isl_ctx *ctx = prog->ctx;
+  struct print_hw_module_data hw_data = { hls, prog, NULL };
+  struct autosa_top_gen_env env;
+  isl_printer *p, *p_str;
+  char *code;
+  std::string info;
+  int n_module_names;
+  char **module_names;
+  FILE *fp;
+
+  env.error = false;
+  p = isl_printer_to_str(ctx);
+
+  /* Function header and interface pragmas. */
+  if (hls->target == XILINX_HW)
+    p = print_top_module_headers_xilinx(p, &env, prog, top, hls);
+  p = isl_printer_indent(p, 4);
+
+  /* FIFO declarations */
+  p = print_str_new_line(p, "/* FIFO Declaration */");
+  for (int i = 0; i < top->n_fifo_decls && !env.error; i++) {
+    char *fifo_name = extract_fifo_name_from_fifo_decl_name(ctx, 
+                        top->fifo_decl_names[i]);
+    char *fifo_w = extract_fifo_width_from_fifo_decl_name(ctx, 
+                     top->fifo_decl_names[i]);
+    env.cnt["fifo_cnt"] = 0;
+    p = top_gen_walk(p, top->fifo_decl_wrapped_trees[i], &env, &hw_data);
+    info += std::string("fifo:") + fifo_name + ":" + 
+              std::to_string(env.cnt["fifo_cnt"]) + ":" + fifo_w + "\n";
+    free(fifo_name);
+    free(fifo_w);
+  }
+  p = print_str_new_line(p, "/* FIFO Declaration */");
+  p = isl_printer_end_line(p);
+
+  /* Module calls */
+  for (int i = 0; i < top->n_module_calls && !env.error; i++) {
+    p = top_gen_walk(p, top->module_call_wrapped_trees[i], &env, &hw_data);
+  }
+  module_names = extract_top_module_names(ctx, top, &n_module_names);
+  for (int i = 0; i < n_module_names; i++) {
+    std::string cnt_name = std::string(module_names[i]) + "_cnt";
+    info += std::string("module:") + module_names[i] + ":" + 
+              std::to_string(env.cnt[cnt_name]) + "\n";
+    free(module_names[i]);
+  }
+  free(module_names);
+
+  p = isl_printer_indent(p, -4);
+  p = print_str_new_line(p, "}");
+  if (hls->target == XILINX_HW && !hls->hls)
+    p = print_str_new_line(p, "}");
+
+  code = isl_printer_get_str(p);
+  isl_printer_free(p);
+  if (env.error) {
+    free(code);
+    return isl_stat_error;
+  }
+
+  p_str = isl_printer_to_str(ctx);
+  p_str = isl_printer_print_str(p_str, hls->output_dir);
+  p_str = isl_printer_print_str(p_str, "/src/top.cpp");
+  char *top_path = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+  fp = fopen(top_path, "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Can't open the file: %s\n", top_path);
+    exit(1);
+  }
+  fprintf(fp, "%s", code);
+  fclose(fp);
+  free(top_path);
+  free(code);
+
+  p_str = isl_printer_to_str(ctx);
+  p_str = isl_printer_print_str(p_str, hls->output_dir);
+  p_str = isl_printer_print_str(p_str, "/resource_est/design_info.dat");
+  char *info_path = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+  fp = fopen(info_path, "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Can't open the file: %s\n", info_path);
+    exit(1);
+  }
+  fprintf(fp, "%s", info.c_str());
+  fclose(fp);
+  free(info_path);
+
+  return isl_stat_ok;
+}
+
+/* Assign the HBM channels to the pointers of the arrays of "kernel"
+ * and print the matching "connectivity.cfg" for v++ in the output directory.
+ * The channels are assigned in order, wrapping around the "hbm_channels" 
+ * of the hardware information file, 32 by default.
+ * Each pointer of a read-only array uses its own channel and its own copy 
+ * of the array. The pointers of the other arrays share one channel.
+ */
+static void assign_hbm_banks(struct autosa_prog *prog, 
+  struct autosa_kernel *kernel, struct hls_info *hls)
+{
+  cJSON *hw_info = sa_hw_info(prog->scop->options->autosa);
+  int n_bank = 32;
+  int bank = 0;
+  std::string cfg_path;
+  FILE *fp;
+
+  if (hw_info) {
+    cJSON *channels = cJSON_GetObjectItemCaseSensitive(hw_info, 
+                        "hbm_channels");
+    if (cJSON_IsNumber(channels) && channels->valuedouble >= 1)
+      n_bank = (int)channels->valuedouble;
+  }
+
+  cfg_path = std::string(hls->output_dir) + "/connectivity.cfg";
+  fp = fopen(cfg_path.c_str(), "w");
+  if (!fp) {
+    printf("[AutoSA] Error: Can't open the file: %s\n", cfg_path.c_str());
+    exit(1);
+  }
+  fprintf(fp, "[connectivity]\n");
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_local_array_info *local_array = &kernel->array[i];
+    struct autosa_array_info *array = local_array->array;
+    int n_ref = local_array->n_io_group_refs;
+    int read_only;
+
+    if (!autosa_kernel_requires_array_argument(kernel, i) ||
+        autosa_array_is_scalar(array) || n_ref == 0)
+      continue;
+
+    read_only = autosa_array_is_read_only(array);
+    array->n_io_group_refs = n_ref;
+    array->n_buffer = read_only ? n_ref : 1;
+    array->hbm_banks = isl_alloc_array(prog->ctx, int, n_ref);
+    for (int j = 0; j < n_ref; j++) {
+      if (read_only || j == 0)
+        array->hbm_banks[j] = bank++ % n_bank;
+      else
+        array->hbm_banks[j] = array->hbm_banks[0];
+      fprintf(fp, "sp=kernel0_1.%s", array->name);
+      if (n_ref > 1)
+        fprintf(fp, "_%d", j);
+      fprintf(fp, ":HBM[%d]\n", array->hbm_banks[j]);
+    }
+  }
+  fclose(fp);
+  if (bank > n_bank)
+    printf("[AutoSA] Warning: %d pointers share %d HBM channels.\n", 
+           bank, n_bank);
+}
+
 /* Given a autosa_prog "prog" and the corresponding tranformed AST
  * "tree", print the entire OpenCL/HLS code to "p".
  * "types" collects the types for which a definition has already been
@@ -2221,9 +2698,18 @@ static __isl_give isl_printer *print_hw(
   if (!kernel)
     return isl_printer_free(p);
 
+  if (prog->scop->options->autosa->hbm && top_module && !hls->hls)
+    assign_hbm_banks(prog, top_module->kernel, hls);
   /* Print OpenCL host and kernel function. */
   p = autosa_print_host_code(p, prog, tree, modules, n_modules, top_module, hls); 
-  /* Print seperate top module code generation function. */
+  /* Print the top module directly, or fall back to printing 
+   * a seperate top module code generation function. */
+  if (prog->scop->options->autosa->inline_top_gen) {
+    if (generate_top_module_in_process(prog, top_module, hls) == isl_stat_ok)
+      return p;
+    printf("[AutoSA] Warning: Failed to generate the top module in-process. "
+           "Printing the top module generation code instead.\n");
+  }
   print_top_gen_host_code(prog, tree, top_module, hls); 
 
   return p;
@@ -2240,10 +2726,14 @@ int generate_autosa_xilinx_hls_c(isl_ctx *ctx, struct ppcg_options *options,
   hls.target = XILINX_HW;
   hls.hls = options->autosa->hls;
   hls.ctx = ctx;
-  hls.output_dir = options->autosa->output_dir;
+  hls.output_dir = strdup(options->autosa->output_dir);
+  hls.input = input;
+  hls.host_h = NULL;
   hls_open_files(&hls, input);
 
-  r = generate_sa(ctx, input, hls.host_c, options, &print_hw, &hls);
+  r = generate_sa(ctx, input, hls.host_c, options, &print_hw, &hls,
+        &hls_redirect_files);
 
   hls_close_files(&hls);  
+  free(hls.output_dir);
 }
\ No newline at end of file
@@ -15,10 +15,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <isl/ctx.h>
 #include <isl/id.h>
 #include <isl/val.h>
 #include <isl/set.h>
+#include <isl/space.h>
 #include <isl/union_set.h>
 #include <isl/union_map.h>
 #include <isl/aff.h>
@@ -1052,6 +1054,561 @@ static void compute_tagged_waw_dep(struct ppcg_scop *ps)
   derive_waw_dep_from_tagged_waw_dep(ps);
 }
 
+/* AutoSA Extended */
+/* Version of the format of the dependence cache files.
+ * Increase it whenever the set of cached dependences or the way
+ * they are computed changes.
+ */
+#define PPCG_DEP_CACHE_VERSION 1
+
+/* A growable list of strings.
+ */
+struct ppcg_str_list {
+	int n;
+	char **str;
+};
+
+static isl_stat add_map_str(__isl_take isl_map *map, void *user)
+{
+	struct ppcg_str_list *list = user;
+
+	list->str = realloc(list->str, (list->n + 1) * sizeof(char *));
+	if (!list->str) {
+		isl_map_free(map);
+		return isl_stat_error;
+	}
+	list->str[list->n++] = isl_map_to_str(map);
+	isl_map_free(map);
+
+	return isl_stat_ok;
+}
+
+static int cmp_str(const void *a, const void *b)
+{
+	const char *s1 = *(const char **) a;
+	const char *s2 = *(const char **) b;
+
+	if (!s1 || !s2)
+		return s1 ? 1 : (s2 ? -1 : 0);
+	return strcmp(s1, s2);
+}
+
+/* Print the key entry "name" of "umap" to "p".
+ * The maps in "umap" are printed one per line in sorted order,
+ * such that the key does not depend on the (pointer-based) order
+ * in which isl stores the maps in "umap".
+ */
+static __isl_give isl_printer *print_dep_cache_key_umap(
+	__isl_take isl_printer *p, const char *name,
+	__isl_keep isl_union_map *umap)
+{
+	int i;
+	struct ppcg_str_list list = { 0, NULL };
+
+	p = isl_printer_print_str(p, name);
+	p = isl_printer_print_str(p, ":");
+	p = isl_printer_end_line(p);
+	if (umap)
+		isl_union_map_foreach_map(umap, &add_map_str, &list);
+	qsort(list.str, list.n, sizeof(char *), &cmp_str);
+	for (i = 0; i < list.n; ++i) {
+		p = isl_printer_print_str(p, list.str[i]);
+		p = isl_printer_end_line(p);
+		free(list.str[i]);
+	}
+	free(list.str);
+
+	return p;
+}
+
+/* Construct the key of the dependence cache entry of "ps".
+ * The key consists of the inputs of compute_dependences, i.e.,
+ * the options that select the dependence analysis,
+ * the context, the iteration domain, the access relations and
+ * the schedule of "ps".
+ */
+static char *dep_cache_key(struct ppcg_scop *ps)
+{
+	isl_printer *p;
+	isl_union_map *umap;
+	char *key;
+
+	p = isl_printer_to_str(isl_set_get_ctx(ps->context));
+	p = isl_printer_print_str(p, "version: ");
+	p = isl_printer_print_int(p, PPCG_DEP_CACHE_VERSION);
+	p = isl_printer_end_line(p);
+	p = isl_printer_print_str(p, "options: ");
+	p = isl_printer_print_int(p, ps->options->live_range_reordering);
+	p = isl_printer_print_str(p, " ");
+	p = isl_printer_print_int(p, ps->options->target);
+	p = isl_printer_print_str(p, " ");
+	p = isl_printer_print_int(p, ps->options->autosa->autosa);
+	p = isl_printer_end_line(p);
+	p = isl_printer_print_str(p, "context: ");
+	p = isl_printer_print_set(p, ps->context);
+	p = isl_printer_end_line(p);
+	umap = isl_union_map_from_domain(isl_union_set_copy(ps->domain));
+	p = print_dep_cache_key_umap(p, "domain", umap);
+	isl_union_map_free(umap);
+	p = print_dep_cache_key_umap(p, "tagged_reads", ps->tagged_reads);
+	p = print_dep_cache_key_umap(p, "tagged_may_writes",
+					ps->tagged_may_writes);
+	p = print_dep_cache_key_umap(p, "tagged_must_writes",
+					ps->tagged_must_writes);
+	p = print_dep_cache_key_umap(p, "tagged_must_kills",
+					ps->tagged_must_kills);
+	umap = isl_schedule_get_map(ps->schedule);
+	p = print_dep_cache_key_umap(p, "schedule", umap);
+	isl_union_map_free(umap);
+	p = print_dep_cache_key_umap(p, "independence", ps->independence);
+	key = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	return key;
+}
+
+/* Compute the 64-bit FNV-1a hash of "str".
+ */
+unsigned long long ppcg_hash_str(const char *str)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (; *str; ++str) {
+		hash ^= (unsigned char) *str;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/* Return the name of the cache file with key "key" in the cache directory.
+ */
+static char *dep_cache_file_name(struct ppcg_scop *ps, const char *key)
+{
+	isl_printer *p;
+	char hash[17];
+	char *name;
+
+	snprintf(hash, sizeof(hash), "%016llx", ppcg_hash_str(key));
+	p = isl_printer_to_str(isl_set_get_ctx(ps->context));
+	p = isl_printer_print_str(p, ps->options->autosa->dep_cache);
+	p = isl_printer_print_str(p, "/");
+	p = isl_printer_print_str(p, hash);
+	p = isl_printer_print_str(p, ".deps");
+	name = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	return name;
+}
+
+/* The names of the dependence fields of a ppcg_scop that are stored
+ * in the dependence cache, in the order of dep_cache_fields.
+ */
+static const char *dep_cache_field_names[] = {
+	"live_in", "live_out",
+	"tagged_dep_flow", "dep_flow", "dep_false", "dep_forced",
+	"tagged_dep_order", "dep_order",
+	"tagged_dep_rar", "dep_rar", "tagged_dep_waw", "dep_waw"
+};
+
+#define PPCG_DEP_CACHE_N_FIELD \
+	(sizeof(dep_cache_field_names) / sizeof(dep_cache_field_names[0]))
+
+/* Store pointers to the dependence fields of "ps" that are stored
+ * in the dependence cache in "fields".
+ */
+static void dep_cache_fields(struct ppcg_scop *ps, isl_union_map **fields[])
+{
+	fields[0] = &ps->live_in;
+	fields[1] = &ps->live_out;
+	fields[2] = &ps->tagged_dep_flow;
+	fields[3] = &ps->dep_flow;
+	fields[4] = &ps->dep_false;
+	fields[5] = &ps->dep_forced;
+	fields[6] = &ps->tagged_dep_order;
+	fields[7] = &ps->dep_order;
+	fields[8] = &ps->tagged_dep_rar;
+	fields[9] = &ps->dep_rar;
+	fields[10] = &ps->tagged_dep_waw;
+	fields[11] = &ps->dep_waw;
+}
+
+/* Data used to give the maps read back from the dependence cache
+ * the identifiers of "ps".
+ *
+ * "ids" collects the identifiers of the parameters and tuples
+ * that appear in the context, domain and accesses of "ps".
+ * "res" collects the maps with the identifiers replaced.
+ */
+struct ppcg_dep_cache_ids_data {
+	isl_id_list *ids;
+	isl_union_map *res;
+};
+
+/* Return a copy of the identifier in "ids" with name "name", if any.
+ */
+static __isl_give isl_id *find_id_by_name(__isl_keep isl_id_list *ids,
+	const char *name)
+{
+	int i, n;
+
+	if (!name)
+		return NULL;
+	n = isl_id_list_n_id(ids);
+	for (i = 0; i < n; ++i) {
+		isl_id *id = isl_id_list_get_id(ids, i);
+		const char *id_name = isl_id_get_name(id);
+
+		if (id_name && !strcmp(id_name, name))
+			return id;
+		isl_id_free(id);
+	}
+
+	return NULL;
+}
+
+/* Add "id" to "ids" if no identifier with the same name is in there yet.
+ */
+static __isl_give isl_id_list *add_id(__isl_take isl_id_list *ids,
+	__isl_take isl_id *id)
+{
+	isl_id *found;
+
+	if (!id)
+		return ids;
+	found = find_id_by_name(ids, isl_id_get_name(id));
+	if (found) {
+		isl_id_free(found);
+		isl_id_free(id);
+		return ids;
+	}
+
+	return isl_id_list_add(ids, id);
+}
+
+/* Add the identifiers of the (possibly nested) tuples of
+ * the set space "space" to "ids".
+ */
+static __isl_give isl_id_list *add_tuple_ids(__isl_take isl_id_list *ids,
+	__isl_take isl_space *space)
+{
+	if (isl_space_is_wrapping(space) == isl_bool_true) {
+		space = isl_space_unwrap(space);
+		ids = add_tuple_ids(ids, isl_space_domain(isl_space_copy(space)));
+		return add_tuple_ids(ids, isl_space_range(space));
+	}
+	if (isl_space_has_tuple_id(space, isl_dim_set) == isl_bool_true)
+		ids = add_id(ids, isl_space_get_tuple_id(space, isl_dim_set));
+	isl_space_free(space);
+
+	return ids;
+}
+
+/* Add the identifiers of the parameters and tuples of "space",
+ * which may be a set or a map space, to "ids".
+ */
+static __isl_give isl_id_list *add_space_ids(__isl_take isl_id_list *ids,
+	__isl_take isl_space *space)
+{
+	int i, n;
+
+	n = isl_space_dim(space, isl_dim_param);
+	for (i = 0; i < n; ++i)
+		ids = add_id(ids, isl_space_get_dim_id(space, isl_dim_param, i));
+	if (isl_space_is_set(space) == isl_bool_true)
+		return add_tuple_ids(ids, space);
+	ids = add_tuple_ids(ids, isl_space_domain(isl_space_copy(space)));
+	return add_tuple_ids(ids, isl_space_range(space));
+}
+
+static isl_stat collect_map_ids(__isl_take isl_map *map, void *user)
+{
+	isl_id_list **ids = user;
+
+	*ids = add_space_ids(*ids, isl_map_get_space(map));
+	isl_map_free(map);
+
+	return isl_stat_ok;
+}
+
+static isl_stat collect_set_ids(__isl_take isl_set *set, void *user)
+{
+	isl_id_list **ids = user;
+
+	*ids = add_space_ids(*ids, isl_set_get_space(set));
+	isl_set_free(set);
+
+	return isl_stat_ok;
+}
+
+/* Replace the identifiers of the (possibly nested) tuples of
+ * the set space "space" by the identifiers with the same names in "ids".
+ */
+static __isl_give isl_space *reset_tuple_ids(__isl_take isl_space *space,
+	__isl_keep isl_id_list *ids)
+{
+	isl_id *id, *new_id;
+
+	if (isl_space_is_wrapping(space) == isl_bool_true) {
+		isl_space *dom, *ran;
+
+		space = isl_space_unwrap(space);
+		dom = reset_tuple_ids(isl_space_domain(isl_space_copy(space)), ids);
+		ran = reset_tuple_ids(isl_space_range(space), ids);
+		return isl_space_wrap(isl_space_map_from_domain_and_range(dom, ran));
+	}
+	if (isl_space_has_tuple_id(space, isl_dim_set) != isl_bool_true)
+		return space;
+	id = isl_space_get_tuple_id(space, isl_dim_set);
+	new_id = find_id_by_name(ids, isl_id_get_name(id));
+	isl_id_free(id);
+	if (new_id)
+		space = isl_space_set_tuple_id(space, isl_dim_set, new_id);
+
+	return space;
+}
+
+/* Replace the identifiers of the parameters and tuples of "map"
+ * by the identifiers with the same names in data->ids and
+ * add the result to data->res.
+ *
+ * The tuple identifiers are replaced by taking the preimage
+ * of "map" under the identity mapping from the space with
+ * the new identifiers to the space with the old identifiers.
+ */
+static isl_stat reset_map_ids(__isl_take isl_map *map, void *user)
+{
+	struct ppcg_dep_cache_ids_data *data = user;
+	isl_space *space, *new_space;
+	isl_multi_aff *ma;
+	int i, n;
+
+	n = isl_map_dim(map, isl_dim_param);
+	for (i = 0; i < n; ++i) {
+		isl_id *id, *new_id;
+
+		id = isl_map_get_dim_id(map, isl_dim_param, i);
+		new_id = find_id_by_name(data->ids, isl_id_get_name(id));
+		isl_id_free(id);
+		if (new_id)
+			map = isl_map_set_dim_id(map, isl_dim_param, i, new_id);
+	}
+
+	space = isl_space_domain(isl_map_get_space(map));
+	new_space = reset_tuple_ids(isl_space_copy(space), data->ids);
+	ma = isl_multi_aff_identity(
+			isl_space_map_from_domain_and_range(new_space, space));
+	map = isl_map_preimage_domain_multi_aff(map, ma);
+
+	space = isl_space_range(isl_map_get_space(map));
+	new_space = reset_tuple_ids(isl_space_copy(space), data->ids);
+	ma = isl_multi_aff_identity(
+			isl_space_map_from_domain_and_range(new_space, space));
+	map = isl_map_preimage_range_multi_aff(map, ma);
+
+	data->res = isl_union_map_add_map(data->res, map);
+
+	return data->res ? isl_stat_ok : isl_stat_error;
+}
+
+/* Read the dependence "str" from the cache and give it the identifiers
+ * in "ids".
+ *
+ * The identifiers of the statements and arrays of "ps" may carry
+ * user pointers, which are lost when the dependences are printed.
+ * The identifiers of the dependences read back from the cache
+ * are therefore replaced by the identifiers with the same names
+ * that appear in "ps".
+ */
+static __isl_give isl_union_map *read_cached_dep(struct ppcg_scop *ps,
+	const char *str, __isl_keep isl_id_list *ids)
+{
+	isl_union_map *umap;
+	struct ppcg_dep_cache_ids_data data;
+
+	umap = isl_union_map_read_from_str(isl_set_get_ctx(ps->context), str);
+	if (!umap)
+		return NULL;
+	data.ids = ids;
+	data.res = isl_union_map_empty(isl_set_get_space(ps->context));
+	if (isl_union_map_foreach_map(umap, &reset_map_ids, &data) < 0)
+		data.res = isl_union_map_free(data.res);
+	isl_union_map_free(umap);
+
+	return data.res;
+}
+
+/* Read the whole content of the file "name".
+ * Return NULL if the file cannot be read.
+ */
+char *ppcg_read_file(const char *name)
+{
+	FILE *fp;
+	long size;
+	char *buf;
+
+	fp = fopen(name, "r");
+	if (!fp)
+		return NULL;
+	if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 ||
+	    fseek(fp, 0, SEEK_SET) != 0) {
+		fclose(fp);
+		return NULL;
+	}
+	buf = malloc(size + 1);
+	if (buf && fread(buf, 1, size, fp) != (size_t) size) {
+		free(buf);
+		buf = NULL;
+	}
+	if (buf)
+		buf[size] = '\0';
+	fclose(fp);
+
+	return buf;
+}
+
+/* Try and load the dependences of "ps" from the cache file "name"
+ * with key "key".
+ *
+ * The cache file starts with the key, followed by a line "%%" and
+ * then one line "<field> <dependences>" for each cached field,
+ * where <dependences> is "NULL" for fields that were not computed.
+ * The key is compared in full to guard against hash collisions.
+ *
+ * Return 1 if the dependences were loaded and 0 otherwise.
+ * In the latter case, the dependence fields of "ps" are left untouched.
+ */
+static int load_cached_dependences(struct ppcg_scop *ps, const char *name,
+	const char *key)
+{
+	char *buf, *line, *next;
+	isl_union_map **fields[PPCG_DEP_CACHE_N_FIELD];
+	isl_union_map *loaded[PPCG_DEP_CACHE_N_FIELD] = { NULL };
+	int found[PPCG_DEP_CACHE_N_FIELD] = { 0 };
+	isl_id_list *ids;
+	size_t key_len = strlen(key);
+	int i, n = PPCG_DEP_CACHE_N_FIELD, ok = 1;
+
+	buf = ppcg_read_file(name);
+	if (!buf)
+		return 0;
+	if (strncmp(buf, key, key_len) != 0 ||
+	    strncmp(buf + key_len, "%%\n", 3) != 0) {
+		free(buf);
+		return 0;
+	}
+
+	dep_cache_fields(ps, fields);
+
+	ids = isl_id_list_alloc(isl_set_get_ctx(ps->context), 0);
+	ids = add_space_ids(ids, isl_set_get_space(ps->context));
+	isl_union_set_foreach_set(ps->domain, &collect_set_ids, &ids);
+	isl_union_map_foreach_map(ps->tagged_reads, &collect_map_ids, &ids);
+	isl_union_map_foreach_map(ps->tagged_may_writes, &collect_map_ids,
+				&ids);
+	isl_union_map_foreach_map(ps->tagged_must_kills, &collect_map_ids,
+				&ids);
+
+	for (line = buf + key_len + 3; ok && line && *line; line = next) {
+		char *sep;
+
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		sep = strchr(line, ' ');
+		if (!sep) {
+			ok = 0;
+			break;
+		}
+		*sep++ = '\0';
+		for (i = 0; i < n; ++i)
+			if (!strcmp(line, dep_cache_field_names[i]))
+				break;
+		if (i >= n || found[i]) {
+			ok = 0;
+			break;
+		}
+		found[i] = 1;
+		if (strcmp(sep, "NULL") == 0)
+			continue;
+		loaded[i] = read_cached_dep(ps, sep, ids);
+		if (!loaded[i])
+			ok = 0;
+	}
+	for (i = 0; i < n; ++i)
+		if (!found[i])
+			ok = 0;
+	isl_id_list_free(ids);
+	free(buf);
+
+	for (i = 0; i < n; ++i) {
+		if (ok) {
+			isl_union_map_free(*fields[i]);
+			*fields[i] = loaded[i];
+		} else {
+			isl_union_map_free(loaded[i]);
+		}
+	}
+
+	return ok;
+}
+
+/* Store the dependences of "ps" in the cache file "name" with key "key".
+ *
+ * The dependences are first written to a temporary file, which
+ * is then renamed to "name", such that concurrent AutoSA processes
+ * sharing the cache directory never see a partially written file.
+ * Failure to write the cache is not fatal.
+ */
+static void store_cached_dependences(struct ppcg_scop *ps, const char *name,
+	const char *key)
+{
+	isl_printer *p;
+	char *tmp_name;
+	isl_union_map **fields[PPCG_DEP_CACHE_N_FIELD];
+	FILE *fp;
+	int i, n = PPCG_DEP_CACHE_N_FIELD;
+
+	p = isl_printer_to_str(isl_set_get_ctx(ps->context));
+	p = isl_printer_print_str(p, name);
+	p = isl_printer_print_str(p, ".tmp.");
+	p = isl_printer_print_int(p, (int) getpid());
+	tmp_name = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	fp = fopen(tmp_name, "w");
+	if (!fp) {
+		printf("[AutoSA] Warning: Cannot write the dependence cache file: %s\n",
+			tmp_name);
+		free(tmp_name);
+		return;
+	}
+
+	dep_cache_fields(ps, fields);
+	p = isl_printer_to_file(isl_set_get_ctx(ps->context), fp);
+	p = isl_printer_print_str(p, key);
+	p = isl_printer_print_str(p, "%%");
+	p = isl_printer_end_line(p);
+	for (i = 0; i < n; ++i) {
+		p = isl_printer_print_str(p, dep_cache_field_names[i]);
+		p = isl_printer_print_str(p, " ");
+		if (*fields[i])
+			p = isl_printer_print_union_map(p, *fields[i]);
+		else
+			p = isl_printer_print_str(p, "NULL");
+		p = isl_printer_end_line(p);
+	}
+	isl_printer_free(p);
+
+	if (fclose(fp) != 0 || rename(tmp_name, name) != 0) {
+		printf("[AutoSA] Warning: Cannot write the dependence cache file: %s\n",
+			name);
+		remove(tmp_name);
+	}
+	free(tmp_name);
+}
+/* AutoSA Extended */
+
 /* Compute the dependences of the program represented by "scop".
  * Store the computed potential flow dependences
  * in scop->dep_flow and the reads with potentially no corresponding writes in
@@ -1064,16 +1621,34 @@ static void compute_tagged_waw_dep(struct ppcg_scop *ps)
  * in compute_live_range_reordering_dependences.
  * 
  * Extended by AutoSA: Add analysis for WAW and RAR dependences.
+ * If a dependence cache directory is specified, then the dependences
+ * are loaded from the cache if they were computed before for the same
+ * inputs and they are stored in the cache otherwise.
  */
 static void compute_dependences(struct ppcg_scop *scop)
 {
 	isl_union_map *may_source;
 	isl_union_access_info *access;
 	isl_union_flow *flow;
+	char *cache_key = NULL, *cache_file = NULL;
 
 	if (!scop)
 		return;
 
+	/* AutoSA Extended */
+	if (scop->options->autosa->dep_cache) {
+		cache_key = dep_cache_key(scop);
+		cache_file = dep_cache_file_name(scop, cache_key);
+		if (load_cached_dependences(scop, cache_file, cache_key)) {
+			printf("[AutoSA] Load the dependences from the cache: %s\n",
+				cache_file);
+			free(cache_key);
+			free(cache_file);
+			return;
+		}
+	}
+	/* AutoSA Extended */
+
 	compute_live_out(scop);
 
 	if (scop->options->live_range_reordering)
@@ -1103,6 +1678,11 @@ static void compute_dependences(struct ppcg_scop *scop)
 		compute_tagged_rar_dep(scop);
 		compute_tagged_waw_dep(scop);			
 	}
+
+	if (cache_file && scop->dep_flow && scop->dep_false)
+		store_cached_dependences(scop, cache_file, cache_key);
+	free(cache_key);
+	free(cache_file);
 	/* AutoSA Extended */
 }
 
@@ -130,6 +130,9 @@ int ppcg_transform(isl_ctx *ctx, const char *input, FILE *out,
 
 int autosa_main_wrap(int argc, char **argv);
 
+unsigned long long ppcg_hash_str(const char *str);
+char *ppcg_read_file(const char *name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -88,22 +88,42 @@ ISL_ARGS_END
 ISL_ARGS_START(struct autosa_options, autosa_options_args)
 ISL_ARG_BOOL(struct autosa_options, autosa, 0, "autosa", 1,
   "generate systolic arrays using AutoSA")
+ISL_ARG_BOOL(struct autosa_options, burst_buffer, 0, "burst-buffer", 0,
+  "buffer the array tiles in the I/O modules connected to the external memory")
+ISL_ARG_STR(struct autosa_options, checkpoint_dir, 0, "checkpoint-dir", "dir", 
+  NULL, "directory used to checkpoint the PE optimization stages")
 ISL_ARG_STR(struct autosa_options, config, 0, "config", "config", NULL, 
   "AutoSA configuration file")
 ISL_ARG_BOOL(struct autosa_options, credit_control, 0, "credit-control", 0,
   "enable credit control between different array partitions")	
 ISL_ARG_BOOL(struct autosa_options, data_pack, 0, "data-pack", 1,
   "enable data packing for data transfer")	
+ISL_ARG_STR(struct autosa_options, dep_cache, 0, "dep-cache", "dir", NULL,
+  "directory used to cache the results of the dependence analysis")
 ISL_ARG_BOOL(struct autosa_options, double_buffer, 0, "double-buffer", 1,
   "enable double-buffering for data transfer")	
+ISL_ARG_BOOL(struct autosa_options, estimate, 0, "estimate", 0,
+  "estimate the latency of the generated array")
+ISL_ARG_STR(struct autosa_options, fifo_depth_file, 0, "fifo-depth-file", "file", 
+  NULL, "FIFO depths that override the default or sized FIFO depths")
+ISL_ARG_BOOL(struct autosa_options, fifo_sizing, 0, "fifo-sizing", 0,
+  "size the FIFOs from the schedules of the connected modules")
 ISL_ARG_BOOL(struct autosa_options, hbm, 0, "hbm", 0,
   "use multi-port DRAM/HBM")	
+ISL_ARG_STR(struct autosa_options, hbm_channels, 0, "hbm-channels", "channels", 
+  NULL, "HBM channels of each array, e.g., \"A:4,B:2\", or \"auto\"")
 ISL_ARG_INT(struct autosa_options, n_hbm_port, 0, "hbm-port-num", "num", 2, 
   "default HBM port number")
 ISL_ARG_BOOL(struct autosa_options, hls, 0, "hls", 0,
   "generate Xilinx HLS host")	
+ISL_ARG_STR(struct autosa_options, hw_info, 0, "hw-info", "file", NULL,
+  "resource budget of the target FPGA, designs that exceed it are rejected")
+ISL_ARG_BOOL(struct autosa_options, inline_top_gen, 0, "inline-top-gen", 0,
+  "generate the top module directly instead of printing a top module generator")
 ISL_ARG_BOOL(struct autosa_options, insert_hls_dependence, 0, "insert-hls-dependence", 1,
   "insert Xilinx HLS dependence pragma")		
+ISL_ARG_INT(struct autosa_options, n_jobs, 0, "jobs", "num", 1,
+  "number of processes that build the space-time candidates in parallel")
 ISL_ARG_BOOL(struct autosa_options, use_local_memory, 0, "local-memory", 1, 
   "use local memory in kernel code")
 ISL_ARG_INT(struct autosa_options, max_local_memory, 0,
@@ -112,15 +132,32 @@ ISL_ARG_INT(struct autosa_options, max_sa_dim, 0,
   "max-sa-dim", "dim", 2, "maximal systolic array dimension")
 ISL_ARG_STR(struct autosa_options, output_dir, 0, "output-dir", "dir", "./autosa.tmp/output", 
   "AutoSA Output directory")
+ISL_ARG_BOOL(struct autosa_options, profile, 0, "profile", 0,
+  "dump the time and memory profile of the compilation stages")
 ISL_ARG_STR(struct autosa_options, sa_sizes, 0, "sa-sizes", "sizes", NULL,
 	"per kernel PE optimization tile sizes")	
+ISL_ARG_STR(struct autosa_options, sa_sizes_sweep, 0, "sa-sizes-sweep", "file", 
+  NULL, "file of per kernel PE optimization tile sizes to sweep, one per line")
 ISL_ARG_INT(struct autosa_options, sa_tile_size, 0, "sa-tile-size", "size", 4, 
   "default tile size in PE optmization")	
 ISL_ARG_USER_OPT_CHOICE(struct autosa_options, sa_type, 0, "sa-type", sa_type,
   NULL, AUTOSA_SA_TYPE_ASYNC, AUTOSA_SA_TYPE_ASYNC,
   "systolic array type")	
+ISL_ARG_BOOL(struct autosa_options, serve, 0, "serve", 0,
+  "run as a compile server reading JSON requests from the standard input")
 ISL_ARG_STR(struct autosa_options, simd_info, 0, "simd-info", "info", NULL,
 	"per kernel SIMD information")	
+ISL_ARG_BOOL(struct autosa_options, space_time_model, 0, "space-time-model", 0,
+  "select the space-time transformation with the cost model in the auto mode")
+ISL_ARG_STR(struct autosa_options, stream_from, 0, "stream-from", "file", NULL,
+  "check the arrays read against the stream orders of a producer design "
+  "(analysis only)")
+ISL_ARG_BOOL(struct autosa_options, stream_order, 0, "stream-order", 0,
+  "write the order in which the array partitions access each array")
+ISL_ARG_INT(struct autosa_options, sweep_jobs, 0, "sweep-jobs", "num", 1,
+  "number of design points compiled in parallel in the sweep mode")
+ISL_ARG_STR(struct autosa_options, tuning_db, 0, "tuning-db", "file", NULL,
+  "record the compiled designs in the tuning database file")
 ISL_ARG_BOOL(struct autosa_options, two_level_buffer, 0, "two-level-buffer", 0,
   "enable two-level buffering in I/O modules")
 ISL_ARG_BOOL(struct autosa_options, t2s_tile, 0, "t2s-tile", 0,
@@ -22,16 +22,29 @@ struct autosa_options {
   /* Use HBM memory. */
   int hbm;
   int n_hbm_port;
+  /* HBM channels of each array, or "auto" to split them by traffic. */
+  char *hbm_channels;
   /* Enable double buffering. */
   int double_buffer;
   /* Maximal systolic array dimension. */
   int max_sa_dim;
   /* Systolic array type. */
   int sa_type;
+  /* Run as a compile server reading requests from the standard input. */
+  int serve;
+  /* Select the space-time transformation with the cost model. */
+  int space_time_model;
+  /* Write the order in which the array partitions access each array. */
+  int stream_order;
+  /* Stream orders of the producer design of the arrays read, 
+   * only used by the stream chain analysis. */
+  char *stream_from;
   /* Universal tile size. */
   int sa_tile_size;
   /* Tile sizes for PE optimization. */
   char *sa_sizes;
+  /* File of tile sizes to sweep, one design point per line. */
+  char *sa_sizes_sweep;
   /* Generate T2S code from tiled program. */
   int t2s_tile;
   /* Phases of T2S codegen for tiled program. */
@@ -46,20 +59,45 @@ struct autosa_options {
   int credit_control;
   /* Enable two-level buffering in I/O modules */
   int two_level_buffer;
+  /* Buffer the array tiles in the I/O modules connected to the DRAM */
+  int burst_buffer;
+  /* Size the FIFOs from the schedules of the connected modules */
+  int fifo_sizing;
+  /* FIFO depths overriding the default or sized depths */
+  char *fifo_depth_file;
   /* Configuration file */
   char *config;
+  /* Directory of the PE optimization checkpoints */
+  char *checkpoint_dir;
+  /* Directory of the dependence analysis cache */
+  char *dep_cache;
   /* Output directory */
   char *output_dir;
 	/* SIMD information file */
 	char *simd_info;
+  /* Resource budget of the target FPGA */
+  char *hw_info;
+  /* Tuning database file */
+  char *tuning_db;
   /* Generate HLS host instead of OpenCL host */
   int hls;
   /* Use URAM */
   int uram;	
 	/* Print verbose information */
 	int verbose;
+  /* Dump the time and memory profile of the compilation stages */
+  int profile;
 	/* Insert HLS dependence pragma */
 	int insert_hls_dependence;
+  /* Number of processes that build the space-time candidates in parallel */
+  int n_jobs;
+  /* Number of design points compiled in parallel in the sweep mode */
+  int sweep_jobs;
+  /* Estimate the latency of the generated array */
+  int estimate;
+  /* Generate the top module inside AutoSA instead of printing a program 
+   * that generates it */
+  int inline_top_gen;
 };
 
 struct ppcg_options {